@@ -0,0 +1,152 @@
+"""
+Trial throughput benchmark.
+
+Runs a fixed set of reference trials through the same path as the optimizer
+(ParameterManager -> CarMakerInterface.run_test -> ResultHandler) and reports
+where the wall time of a trial goes: per phase p50 / p95 (src/utils/timing.py
+spans) and trials per hour, against a saved baseline.
+
+    python run_benchmark.py                    # run, compare with the baseline
+    python run_benchmark.py --save-baseline    # run, store it as the new baseline
+    python run_benchmark.py --sessions 1       # on a persistent CM_Office session
+
+CM_Office's own phases (cm_startup, load_testrun, wait_running, sim,
+save_results) come from the marks of the Tcl script with the one-shot
+launcher and overlap result_wait; on a session they are measured directly.
+"""
+import argparse
+import datetime
+import glob
+import json
+import logging
+import os
+import time
+
+from src.core.orchestrator import Orchestrator
+from src.core.parameter_manager import ParameterManager
+from src.core.resource_manager import ResourceManager
+from src.database.data_handler import ResultHandler
+from src.interface.carmaker_interface import CarMakerInterface
+from src.interface.session_pool import SessionPool
+from src.utils.timing import spans
+
+BASELINE_PATH = "Output/benchmark_baseline.json"
+# Reference setups: position of every DYNAMICS_SPACE parameter in its range
+REFERENCE_POINTS = [0.5, 0.25, 0.75, 0.4, 0.6]
+
+
+def reference_trials(n):
+    """The same n parameter sets on every run."""
+    trials = []
+    for i in range(n):
+        f = REFERENCE_POINTS[i % len(REFERENCE_POINTS)]
+        trials.append({name: lo + f * (hi - lo) for name, _, lo, hi in Orchestrator.DYNAMICS_SPACE})
+    return trials
+
+
+def find_erg(cm, testrun_name, since):
+    """Newest ERG of the TestRun written after 'since', None if there is none."""
+    pattern = os.path.join(cm.PROJECT_DIR, "SimOutput", "**", f"{testrun_name}*.erg")
+    files = [f for f in glob.glob(pattern, recursive=True) if os.path.getmtime(f) >= since]
+    return max(files, key=os.path.getmtime) if files else None
+
+
+def run_benchmark(n_trials, n_sessions):
+    resources = ResourceManager(base_dir="Output/Benchmark")
+    cm = CarMakerInterface()
+    pool = None
+    if n_sessions > 0:
+        pool = SessionPool(cm.CM_EXEC, cm.PROJECT_DIR, size=n_sessions, env=cm.launch_env())
+        cm.session_pool = pool
+    param_manager = ParameterManager(template_path="templates/FSE_AllWheelDrive")
+    handler = ResultHandler(os.path.join(resources.get_campaign_path(), "parquet"))
+
+    statuses = []
+    spans.reset()
+    spans.enabled = True
+    t_start = time.perf_counter()
+    try:
+        for i, params in enumerate(reference_trials(n_trials)):
+            trial_id = f"Bench_{i}"
+            t0, started = time.perf_counter(), time.time()
+            status = "InjectFailed"
+            # A failed trial keeps its spans, the phases aren't measured on successes only
+            with spans.trial(trial_id):
+                try:
+                    folder = resources.setup_trial_folder(i)
+                    vehicle_file = os.path.join(folder, "Vehicle_Setup.txt")
+                    if param_manager.inject_parameters(vehicle_file, params):
+                        status = cm.run_test(vehicle_file, folder, trial_id).get('status')
+                        erg = find_erg(cm, f"Run_{trial_id}", started) if cm.WRITE_ERG else None
+                        handler.process_results(trial_id, erg or cm.export_path(folder) or "")
+                finally:
+                    spans.add("trial", time.perf_counter() - t0)
+            statuses.append(status)
+            logging.info(f"Trial {i}: {status} in {time.perf_counter() - t0:.2f} s")
+    finally:
+        spans.enabled = False
+        if pool is not None:
+            pool.shutdown()
+    wall = time.perf_counter() - t_start
+
+    return {
+        'created': datetime.datetime.now().isoformat(timespec='seconds'),
+        'trials': len(statuses),
+        'sessions': n_sessions,
+        'statuses': {s: statuses.count(s) for s in set(statuses)},
+        'failed': sum(1 for s in statuses if s != 'Complete'),
+        'wall_time': wall,
+        'trials_per_hour': 3600.0 * len(statuses) / wall if wall > 0 else 0.0,
+        'phases': spans.summary(),
+    }
+
+
+def _delta(value, base):
+    if base is None or base <= 0:
+        return ""
+    return f"{100.0 * (value - base) / base:+7.1f}%"
+
+
+def print_report(res, baseline=None):
+    base_phases = (baseline or {}).get('phases', {})
+    trial_p50 = res['phases'].get('trial', {}).get('p50', 0.0)
+
+    print(f"\n{res['trials']} trial(s), {res['sessions']} session(s): {res['statuses']}")
+    print(f"Failed: {res.get('failed', 0)} trial(s), included in the phase spans")
+    print(f"Throughput: {res['trials_per_hour']:.1f} trials/hour "
+          f"{_delta(res['trials_per_hour'], (baseline or {}).get('trials_per_hour'))}"
+          + (f" (baseline {baseline['created']})" if baseline else ""))
+    print(f"\n{'phase':<14} {'p50 [s]':>9} {'p95 [s]':>9} {'share':>7} {'p50 vs base':>12}")
+    for phase, st in sorted(res['phases'].items(), key=lambda kv: -kv[1]['p50']):
+        share = f"{100.0 * st['p50'] / trial_p50:6.1f}%" if trial_p50 > 0 and phase != 'trial' else ""
+        print(f"{phase:<14} {st['p50']:9.4f} {st['p95']:9.4f} {share:>7} "
+              f"{_delta(st['p50'], base_phases.get(phase, {}).get('p50')):>12}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="End-to-end trial throughput benchmark")
+    parser.add_argument("--trials", type=int, default=len(REFERENCE_POINTS), help="reference trials to run")
+    parser.add_argument("--sessions", type=int, default=0, help="persistent CM_Office sessions (0 = one-shot)")
+    parser.add_argument("--baseline", default=BASELINE_PATH, help="baseline file")
+    parser.add_argument("--save-baseline", action="store_true", help="store this run as the baseline")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO, format='[%(name)s] %(levelname)s: %(message)s')
+
+    baseline = None
+    if os.path.exists(args.baseline):
+        with open(args.baseline, 'r', encoding='utf-8') as f:
+            baseline = json.load(f)
+
+    res = run_benchmark(args.trials, args.sessions)
+    print_report(res, baseline)
+
+    if args.save_baseline:
+        os.makedirs(os.path.dirname(os.path.abspath(args.baseline)), exist_ok=True)
+        with open(args.baseline, 'w', encoding='utf-8') as f:
+            json.dump(res, f, indent=2)
+        print(f"\nBaseline saved: {args.baseline}")
+
+
+if __name__ == "__main__":
+    main()
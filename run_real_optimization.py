@@ -6,17 +6,28 @@ import logging
 CALIBRATE_FIRST = False  # Set to True once you have "real_log.csv"
 STUDY_NAME = "FSAE_Spain_2026_Attack"
 REAL_LOG_PATH = "data/real_world_log.csv"
+SESSION_POOL_SIZE = 0    # Persistent CM_Office instances, e.g. 1 (0 = relaunch per trial)
+N_WORKERS = 1            # Parallel simulations (one CarMaker license each)
+SCREEN_POOL = 0          # Surrogate-screened candidates per batch round, e.g. 2000 (0 = TPE only)
+TUNE_CONTROLS = False    # Also search TC/TV/recuperation gains (app built with -DCM_TUNBATCH)
+SCREEN_DIST = 0          # Multi-fidelity: screening segment in m, best 1/SCREEN_ETA promoted (0 = full laps)
+SCREEN_ETA = 3
+RESULT_CACHE = True      # Reuse results of setups identical after injection (Output/result_cache.db)
 
 def main():
     logging.basicConfig(level=logging.INFO, 
                        format='[%(name)s] %(levelname)s: %(message)s')
     
     # 1. Initialize Resources
-    orchestrator = Orchestrator(STUDY_NAME)
+    orchestrator = Orchestrator(STUDY_NAME, n_sessions=SESSION_POOL_SIZE, n_workers=N_WORKERS,
+                                screen_pool=SCREEN_POOL, tune_controls=TUNE_CONTROLS,
+                                screen_dist=SCREEN_DIST, screen_eta=SCREEN_ETA, result_cache=RESULT_CACHE)
     
     # 2. Phase 5: Digital Twin Calibration (Optional but Recommended)
     if CALIBRATE_FIRST:
-        sys_id = SystemIdentifier(REAL_LOG_PATH, orchestrator.storage_url)
+        # Calibration runs on the optimizer's workers / sessions
+        sys_id = SystemIdentifier(REAL_LOG_PATH, orchestrator.storage_url, workers=orchestrator.workers,
+                                  n_workers=orchestrator.n_workers, param_manager=orchestrator.param_manager)
         print("\n🔍 PHASE 5: SYSTEM IDENTIFICATION (DIGITAL TWIN)...")
         real_physics = sys_id.calibrate(n_trials=30)
         
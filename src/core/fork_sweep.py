@@ -0,0 +1,127 @@
+import logging
+import os
+import queue
+from concurrent.futures import ThreadPoolExecutor
+
+from src.core.orchestrator import Orchestrator
+from src.core.parameter_manager import ParameterManager
+from src.interface.carmaker_interface import CarMakerInterface
+
+
+class ForkSweep:
+    """
+    Local sensitivity runs forked from the middle of a lap.
+
+    One trunk run drives the base setup up to fork_dist metres and exports
+    the vehicle state there (CarMakerInterface.fork(), WarmStart.c). Each
+    perturbed variant then only drives the rest of the lap, starting from
+    that state at the route position and speed of the fork point. Variants
+    run in parallel on the worker pool; on a session with HOT_PARAMS the
+    variants after the first only send their changed vehicle keys and
+    restart the loaded variant Test Run.
+
+    The lap time of a variant is the trunk's time up to the fork plus its
+    own, its KPIs cover the part after the fork. So variants are only
+    comparable with each other, not with full-lap trials.
+    """
+    def __init__(self, workers=None, n_workers=1, param_manager=None, fork_dist=30.0,
+                 output_dir="Output/Fork"):
+        self.logger = logging.getLogger("ForkSweep")
+        self.n_workers = max(1, n_workers)
+        if workers is None:
+            workers = queue.Queue()
+            workers.put(CarMakerInterface())
+            self.n_workers = 1
+        self.workers = workers
+        self.param_manager = param_manager or ParameterManager(template_path="templates/FSE_AllWheelDrive")
+        self.fork_dist = fork_dist
+        self.output_dir = os.path.abspath(output_dir)
+        self.ranges = {name: (lo, hi) for name, _, lo, hi in Orchestrator.DYNAMICS_SPACE}
+
+    def _vehicle(self, params, name):
+        folder = os.path.join(self.output_dir, name)
+        os.makedirs(folder, exist_ok=True)
+        vehicle_file = os.path.join(folder, "Vehicle_Setup.txt")
+        if not self.param_manager.inject_parameters(vehicle_file, params):
+            return None, folder
+        return vehicle_file, folder
+
+    def run(self, base_params, variants):
+        """
+        Trunk run of base_params, then every parameter set of variants from the fork.
+        Returns (fork point, [result per variant]), (None, []) if the trunk failed.
+        """
+        vehicle_file, _ = self._vehicle(base_params, "Trunk")
+        if vehicle_file is None:
+            return None, []
+        cm_interface = self.workers.get()
+        try:
+            fork = cm_interface.fork(vehicle_file, self.fork_dist)
+        finally:
+            self.workers.put(cm_interface)
+        if fork is None:
+            return None, []
+        self.logger.info(f"🍴 Fork at {fork['distance']:.1f} m / {fork['time']:.2f} s, "
+                         f"{len(variants)} variant(s) on {self.n_workers} worker(s)")
+
+        with ThreadPoolExecutor(max_workers=self.n_workers) as pool:
+            results = list(pool.map(lambda iv: self._run_variant(fork, iv[0], iv[1]), enumerate(variants)))
+        return fork, results
+
+    def _run_variant(self, fork, i, params):
+        trial_id = f"Fork_{i}"
+        vehicle_file, folder = self._vehicle(params, trial_id)
+        if vehicle_file is None:
+            return {'status': 'InjectFailed', 'lap_time': None}
+
+        cm_interface = self.workers.get()
+        warm_start = cm_interface.WARM_START
+        try:
+            # The fork's snapshot is the warm start of the variants
+            cm_interface.WARM_START = False
+            vehicle, start_keys = cm_interface.fork_variant(fork, vehicle_file, trial_id)
+            result = cm_interface.run_test(vehicle, folder, trial_id, tunables=start_keys)
+        finally:
+            cm_interface.WARM_START = warm_start
+            self.workers.put(cm_interface)
+
+        result = dict(result)
+        sim_time = result.get('quantities', {}).get('Time')
+        if result.get('status') == 'Complete' and sim_time is not None:
+            result['lap_time'] = fork['time'] + float(sim_time)
+            result['distance'] = fork['distance'] + result.get('distance', 0.0)
+        else:
+            result['lap_time'] = None
+        return result
+
+    def sweep(self, base_params, name, values):
+        """One-at-a-time sweep of one parameter: [(value, lap time or None)]."""
+        variants = [dict(base_params, **{name: v}) for v in values]
+        _, results = self.run(base_params, variants)
+        return [(v, r.get('lap_time')) for v, r in zip(values, results)]
+
+    def gradient(self, base_params, names=None, rel_step=0.05):
+        """
+        Central finite differences of the lap time, {name: d lap_time / d param}
+        (None where a variant didn't finish). The step is rel_step of the
+        parameter's search range, clipped to the range.
+        """
+        names = [n for n in (names or base_params) if n in self.ranges]
+        variants, steps = [], []
+        for name in names:
+            lo, hi = self.ranges[name]
+            h = rel_step * (hi - lo)
+            x = base_params[name]
+            up, down = min(x + h, hi), max(x - h, lo)
+            variants += [dict(base_params, **{name: up}), dict(base_params, **{name: down})]
+            steps.append(up - down)
+
+        _, results = self.run(base_params, variants)
+        if not results:
+            return {}
+        grad = {}
+        for k, name in enumerate(names):
+            t_up, t_down = results[2 * k].get('lap_time'), results[2 * k + 1].get('lap_time')
+            grad[name] = (t_up - t_down) / steps[k] if t_up is not None and t_down is not None \
+                and steps[k] > 0 else None
+        return grad
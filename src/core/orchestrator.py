@@ -1,24 +1,86 @@
 import optuna
 import logging
 import os
+import queue
+import threading
 import numpy as np
 
 from src.interface.carmaker_interface import CarMakerInterface
+from src.interface.session_pool import SessionPool
 from src.core.parameter_manager import ParameterManager
 from src.core.surrogate import SurrogateOracle
 from src.core.resource_manager import ResourceManager
+from src.database.trial_store import TrialStore
+from src.database.result_cache import ResultCache
 from src.core.physics_validator import PhysicsValidator  # <--- NEW
 from src.core.delta_learner import DeltaLearner          # <--- NEW
 
 class Orchestrator:
-    def __init__(self, study_name):
+    # Search space: (internal name, Optuna name, low, high).
+    # Order = feature order of the surrogate.
+    # Refined ranges based on Document recommendations (avoiding extreme stiffness)
+    DYNAMICS_SPACE = [
+        ("Spring_F", "k_spring_f", 20000, 75000), # N/m
+        ("Spring_R", "k_spring_r", 20000, 75000),
+        ("Damp_Bump_F", "d_bump_f", 500, 4000),   # Ns/m
+        ("Damp_Reb_F", "d_reb_f", 1500, 6000),
+        ("Damp_Bump_R", "d_bump_r", 500, 4000),
+        ("Damp_Reb_R", "d_reb_r", 1500, 6000),
+        ("Stabilizer_F", "arb_f", 0, 50000),      # Nm/rad
+        ("Stabilizer_R", "arb_r", 0, 50000),
+        ("Camber_Static_F", "camber_f", -0.05, -0.01),
+        ("Camber_Static_R", "camber_r", -0.03, -0.005),
+        ("Toe_Static_F", "toe_f", -0.005, 0.005),
+        ("Toe_Static_R", "toe_r", -0.002, 0.005),
+    ]
+    # Controller gains (Simulink tunables, ParameterManager.TUNABLE_PARAMS),
+    # searched alongside the suspension when tune_controls is set.
+    # Not surrogate features.
+    CONTROL_SPACE = [
+        ("TC_Derivative", "tc_derivative", 0.2, 0.8),
+        ("TV_Override", "tv_override", 0.0, 0.3),
+        ("Brake_Mech_Rec_Ratio", "brake_rec_ratio", 0.5, 1.0),
+    ]
+
+    def __init__(self, study_name, n_sessions=0, n_workers=1, screen_pool=0, tune_controls=False,
+                 screen_dist=0, screen_eta=3, result_cache=True):
         self.study_name = study_name
         self.logger = logging.getLogger("Orchestrator")
         optuna.logging.set_verbosity(optuna.logging.WARNING)
         
         self.resources = ResourceManager()
         self.storage_url = self.resources.get_db_path()
+        # Per-trial KPIs go through a write-behind store (batched commits by one
+        # writer thread) instead of one optuna user attr transaction each
+        self.trial_store = TrialStore(self.resources.get_campaign_path())
+        # Results of identical injected setups, shared across workers and campaigns
+        self.result_cache = ResultCache(self.resources.get_cache_path()) if result_cache else None
         self.cm_interface = CarMakerInterface()
+        
+        # --- PARALLEL WORKERS ---
+        # The one-shot launcher kills every CM_Office on the machine, so
+        # parallel workers always run on persistent sessions (one per worker).
+        self.n_workers = max(1, n_workers)
+        if self.n_workers > 1:
+            n_sessions = max(n_sessions, self.n_workers)
+        
+        # Persistent CM_Office instances (0 = relaunch CarMaker for every trial)
+        self.session_pool = None
+        if n_sessions > 0:
+            self.session_pool = SessionPool(self.cm_interface.CM_EXEC, self.cm_interface.PROJECT_DIR, size=n_sessions,
+                                            env=self.cm_interface.launch_env())
+            self.cm_interface.session_pool = self.session_pool
+        
+        # Each worker owns an interface with its own scratch folder (Tcl script / logs),
+        # configured like cm_interface. Settings changed on cm_interface later are
+        # copied to a worker before each run (_simulate).
+        self.workers = queue.Queue()
+        if self.n_workers == 1:
+            self.workers.put(self.cm_interface)
+        else:
+            for w in range(self.n_workers):
+                self.workers.put(self.cm_interface.clone(self.resources.setup_worker_folder(w)))
+        self._lock = threading.Lock() # Guards surrogate + best_lap across workers
         self.param_manager = ParameterManager(template_path="templates/FSE_AllWheelDrive")
         self.surrogate = SurrogateOracle()
         
@@ -29,6 +91,25 @@ class Orchestrator:
         self.optimization_mode = "dynamics" 
         self.best_lap = float('inf')
         self.TOTAL_TRACK_DIST = 75.0 
+        
+        # --- BATCH SCREENING (batch BO) ---
+        # Every other round of n_workers trials, 'screen_pool' random candidates are
+        # scored by the surrogate in one call and only the top-q are simulated.
+        self.screen_pool = screen_pool
+        self._rng = np.random.default_rng()
+        self.MAX_SIDESLIP = 0.35 # rad, early stop on spin
+        self.STALL_TIME = 5.0    # s without progress, early stop
+        
+        # Controller gains per trial without restarting MATLAB/Simulink (TunBatch.c)
+        self.tune_controls = tune_controls
+        
+        # --- MULTI-FIDELITY (ASHA) ---
+        # screen_dist > 0: a trial first drives only screen_dist metres (Prune.Horizon),
+        # then screen_dist * eta, ... and finally the full lap. The projected lap time
+        # of each segment is reported to optuna, whose SuccessiveHalvingPruner only
+        # promotes the best 1/eta of a rung.
+        self.screen_dist = int(screen_dist)
+        self.screen_eta = screen_eta
 
     def optimize(self, n_trials=100):
         study = optuna.create_study(
@@ -36,35 +117,48 @@ class Orchestrator:
             storage=self.storage_url,
             direction="minimize",
             load_if_exists=True,
-            sampler=optuna.samplers.TPESampler(n_startup_trials=10)
+            # constant_liar keeps concurrent workers from proposing the same point
+            sampler=optuna.samplers.TPESampler(n_startup_trials=10, constant_liar=self.n_workers > 1),
+            pruner=self._pruner()
         )
         
-        self.logger.info(f"🚀 Starting Phase 3/4 Optimization (Physics Gated)")
-        study.optimize(self._objective, n_trials=n_trials)
+        self.logger.info(f"🚀 Starting Phase 3/4 Optimization (Physics Gated, {self.n_workers} worker(s))")
+        try:
+            if self.screen_pool <= 0:
+                study.optimize(self._objective, n_trials=n_trials, n_jobs=self.n_workers)
+            else:
+                done, round_no = 0, 0
+                while done < n_trials:
+                    q = min(self.n_workers, n_trials - done)
+                    if round_no % 2 == 1:
+                        self._enqueue_screened(study, q)
+                    study.optimize(self._objective, n_trials=q, n_jobs=self.n_workers)
+                    done += q
+                    round_no += 1
+        finally:
+            if self.session_pool is not None:
+                self.session_pool.shutdown()
+            self.trial_store.close()
+            if self.result_cache is not None and self.result_cache.hits:
+                self.logger.info(f"♻️ Result cache: {self.result_cache.hits} hit(s), "
+                                 f"{self.result_cache.misses} simulated")
         return study.best_params
 
     def _objective(self, trial):
         # 1. Parameter Proposal & PHYSICS GATE
-        # We loop until we find a physically valid set (max 10 tries)
-        # to avoid wasting the 'trial' object on a NaN result
-        for _ in range(10):
-            params = self._suggest_dynamics_params(trial)
-            is_valid, reason = self.validator.check_viability(params)
-            
-            if is_valid:
-                break
-            else:
-                # Tell Optuna this area is bad (Pruning)
-                # But since we haven't run sim, we just loop to find better params
-                # In strict Optuna, we might return a Fail value, but looping is cleaner here.
-                pass
+        # The sampler only proposes springs inside the validator's feasible
+        # region (see _suggest_dynamics_params), so this is a safety net for
+        # enqueued / hand-made trials, not a rejection loop.
+        params = self._suggest_dynamics_params(trial)
+        is_valid, reason = self.validator.check_viability(params)
         
         if not is_valid:
             self._log_row(trial.number, "PRUNED", "N/A", reason)
             return 999.0 # Hard penalty for physics violation
 
         # 2. Risk Assessment (cBO)
-        risk_score = self.surrogate.predict_score(params)
+        with self._lock:
+            risk_score = self.surrogate.predict_score(params)
         
         # 3. Execution
         trial_folder = self.resources.setup_trial_folder(trial.number)
@@ -73,8 +167,35 @@ class Orchestrator:
         if not self.param_manager.inject_parameters(vehicle_file, params):
             return 999.0
 
-        result = self.cm_interface.run_test(vehicle_file, trial_folder, trial.number)
-        
+        # Early stop thresholds: once the projection can't beat best_lap the run is lost
+        with self._lock:
+            prune = {'TotalDist': self.TOTAL_TRACK_DIST, 'MaxSideSlip': self.MAX_SIDESLIP,
+                     'StallTime': self.STALL_TIME}
+            if np.isfinite(self.best_lap):
+                prune['BestTime'] = f"{self.best_lap:.3f}"
+
+        # Calibrated tire grip (SystemIdentifier) is a TestRun key
+        tunables = self.param_manager.physics_testrun_keys(self.param_manager.base_physics) or None
+        if self.tune_controls:
+            controls = {name: trial.suggest_float(opt, lo, hi) for name, opt, lo, hi in self.CONTROL_SPACE}
+            tunables = {**(tunables or {}), **self.param_manager.tunable_keys(controls)}
+
+        # Multi-fidelity: short segments first, each one a rung of the pruner
+        for horizon in self._horizons():
+            result = self._simulate(trial, params, vehicle_file, trial_folder, {**prune, 'Horizon': horizon},
+                                    tunables)
+            if result.get('stop_reason') != 'horizon':
+                break # Over before the horizon (spin, slow, ...): that's the final result
+            pace_cost = self._projected_time(result['lap_time'], result.get('distance', horizon))
+            trial.report(pace_cost, horizon)
+            if trial.should_prune():
+                self._log_row(trial.number, "PRUNED", f"{pace_cost:.3f}s", f"screened at {horizon} m")
+                raise optuna.TrialPruned()
+        else:
+            # Horizon = 0 keeps the TestRun keys of the segments (hot parameter injection)
+            full = {**prune, 'Horizon': 0} if self._horizons() else prune
+            result = self._simulate(trial, params, vehicle_file, trial_folder, full, tunables)
+
         # 4. Result Handling (Soft Penalties + Reality Gap)
         lap_time = result['lap_time']
         dist = result.get('distance', 0)
@@ -82,13 +203,18 @@ class Orchestrator:
         
         status = "COMPLETE"
         
-        if dist < (self.TOTAL_TRACK_DIST * 0.95) or lap_time > 100:
+        # Stopped because the projection can't beat best_lap: a safe lap that is
+        # just slower, scored on its projected pace and not infeasible for the
+        # surrogate. Spin / stall / off track are scored like a crash.
+        stopped = result.get('status') == 'Stopped'
+        if stopped and result.get('stop_reason') == 'slow':
+            status = "SLOW"
+            final_cost = self._projected_time(lap_time, dist) if dist > 5.0 else 300.0
+        elif stopped or dist < (self.TOTAL_TRACK_DIST * 0.95) or lap_time > 100:
             is_crash = True
-            status = "CRASH"
+            status = "STOPPED" if stopped else "CRASH"
             if dist > 5.0:
-                pace = lap_time / dist
-                projected_time = pace * self.TOTAL_TRACK_DIST
-                final_cost = projected_time * 1.10 
+                final_cost = self._projected_time(lap_time, dist) * 1.10 
             else:
                 final_cost = 300.0 
         else:
@@ -99,33 +225,149 @@ class Orchestrator:
         final_cost += correction
         # ------------------------------------
 
-        self.surrogate.update(params, final_cost, is_crash)
-        
-        if final_cost < self.best_lap:
-            self.best_lap = final_cost
-            status = "⭐ NEW BEST"
+        with self._lock:
+            self.surrogate.update(params, final_cost, is_crash)
+            
+            if final_cost < self.best_lap:
+                self.best_lap = final_cost
+                status = "⭐ NEW BEST"
 
+        if result.get('stop_reason'):
+            reason = f"stopped early ({result['stop_reason']})"
         self._log_row(trial.number, status, f"{final_cost:.3f}s", f"Dist: {dist:.1f}m | {reason}")
         return final_cost
 
+    def _simulate(self, trial, params, vehicle_file, trial_folder, prune, tunables):
+        """One run on a free worker, or the cached result of the same injected setup; stores the KPIs."""
+        # The key comes from the worker that runs the trial, with the settings it runs under
+        key, result = None, None
+        cm_interface = self.workers.get()
+        try:
+            if cm_interface is not self.cm_interface:
+                cm_interface.copy_config(self.cm_interface)
+            if self.result_cache is not None:
+                testrun = cm_interface.result_fingerprint(prune, tunables)
+                if testrun is not None:
+                    key = ResultCache.key(self.param_manager.fingerprint(params), testrun)
+                    result = self.result_cache.get(key)
+            cached = result is not None
+            if not cached:
+                result = cm_interface.run_test(vehicle_file, trial_folder, trial.number, prune=prune,
+                                               tunables=tunables)
+        finally:
+            self.workers.put(cm_interface)
+
+        if cached:
+            self.logger.info(f"♻️ Trial {trial.number}: identical setup already simulated, cached result")
+        else:
+            if self.tune_controls:
+                self._check_tunables(trial, result, tunables)
+            if key is not None:
+                self.result_cache.put(key, result)
+        
+        # Handling KPIs streamed by the app (no ERG parsing), shown in the dashboard
+        record = dict(result.get('kpis', {}))
+        if 'start_time' in result:
+            record['start_time'] = result['start_time']
+        self.trial_store.append(trial.study.study_name, trial.number, record)
+        return result
+
+    def _check_tunables(self, trial, result, tunables):
+        """Fails the trial if the app didn't set every controller gain sent (TunBatch.n)."""
+        sent, n_set = CarMakerInterface.tunables_set(result, tunables)
+        if n_set is not None and n_set != sent:
+            msg = (f"Trial {trial.number}: the app set {n_set} of {sent} controller gain(s) (TunBatch.n). "
+                   f"Build it with -DCM_TUNBATCH and call TunBatch_Register() in the model wrapper "
+                   f"(TunBatch.h), or run without tune_controls.")
+            self.logger.error(msg)
+            raise RuntimeError(msg)
+
+    def _projected_time(self, time, dist):
+        """Full-lap time at the pace of the first dist metres."""
+        return time / max(dist, 1.0) * self.TOTAL_TRACK_DIST
+
+    def _horizons(self):
+        """Screening distances in m (the pruner's rungs) below the full lap, [] = full laps only."""
+        horizons, h = [], self.screen_dist
+        while 0 < h < self.TOTAL_TRACK_DIST * 0.95:
+            horizons.append(h)
+            h *= self.screen_eta
+        return horizons
+
+    def _pruner(self):
+        if not self._horizons():
+            return optuna.pruners.NopPruner()
+        # Rung k at screen_dist * eta^k metres = the reported step
+        return optuna.pruners.SuccessiveHalvingPruner(min_resource=self.screen_dist,
+                                                      reduction_factor=self.screen_eta,
+                                                      min_early_stopping_rate=0)
+
     def _log_row(self, trial_num, status, time_str, note):
         RESET = "\033[0m"
         color = "\033[92m" if "BEST" in status else ("\033[91m" if "CRASH" in status else ("\033[93m" if "PRUNED" in status else RESET))
         self.logger.info(f"| {trial_num:^5} | {color}{status:^10}{RESET} | {time_str:^10} | {note:<30} |")
 
+    def _enqueue_screened(self, study, q):
+        """Scores a candidate pool with the surrogate and enqueues the top-q."""
+        with self._lock:
+            if not self.surrogate.is_trained:
+                return 0
+        cands = self._sample_candidates(study, self.screen_pool)
+        if len(cands) == 0:
+            return 0
+        with self._lock:
+            scores = self.surrogate.predict_scores(cands)
+        
+        for i in np.argsort(scores)[:q]:
+            study.enqueue_trial({opt: float(cands[i, j]) for j, (_, opt, _, _) in enumerate(self.DYNAMICS_SPACE)})
+        self.logger.info(f"🎯 Screened {len(cands)} candidates -> top {q} (best score {scores.min():.4f})")
+        return q
+
+    def _space_bounds(self, name):
+        for n, _, lo, hi in self.DYNAMICS_SPACE:
+            if n == name:
+                return lo, hi
+        raise KeyError(name)
+
+    def _sample_candidates(self, study, n):
+        """Half uniform over the feasible space, half Gaussian around the incumbent (10% of range)."""
+        names = [name for name, _, _, _ in self.DYNAMICS_SPACE]
+        low = np.array([lo for _, _, lo, _ in self.DYNAMICS_SPACE], dtype=float)
+        high = np.array([hi for _, _, _, hi in self.DYNAMICS_SPACE], dtype=float)
+        cands = self._rng.uniform(low, high, size=(n, len(low)))
+        
+        # Springs straight from the validator's feasible region
+        i_f, i_r = names.index("Spring_F"), names.index("Spring_R")
+        f_lo, f_hi = self.validator.front_spring_range(low[i_f], high[i_f], low[i_r], high[i_r])
+        cands[:, i_f] = self._rng.uniform(f_lo, f_hi, size=n)
+        r_lo, r_hi = self.validator.rear_spring_range(cands[:, i_f], low[i_r], high[i_r])
+        cands[:, i_r] = r_lo + self._rng.uniform(size=n) * (r_hi - r_lo)
+        
+        try:
+            best = study.best_trial.params
+            center = np.array([best.get(opt, (lo + hi) / 2) for _, opt, lo, hi in self.DYNAMICS_SPACE])
+            n_local = n // 2
+            local = center + self._rng.normal(0.0, 0.1, size=(n_local, len(low))) * (high - low)
+            cands[:n_local] = np.clip(local, low, high)
+        except ValueError:
+            pass # No completed trial yet
+        
+        # One vectorized physics check for the whole pool
+        return cands[self.validator.check_batch(cands[:, i_f], cands[:, i_r])]
+
     def _suggest_dynamics_params(self, trial):
-        # Refined ranges based on Document recommendations (avoiding extreme stiffness)
-        return {
-            "Spring_F": trial.suggest_float("k_spring_f", 20000, 75000), # N/m
-            "Spring_R": trial.suggest_float("k_spring_r", 20000, 75000),
-            "Damp_Bump_F": trial.suggest_float("d_bump_f", 500, 4000),   # Ns/m
-            "Damp_Reb_F":  trial.suggest_float("d_reb_f", 1500, 6000),
-            "Damp_Bump_R": trial.suggest_float("d_bump_r", 500, 4000),
-            "Damp_Reb_R":  trial.suggest_float("d_reb_r", 1500, 6000),
-            "Stabilizer_F": trial.suggest_float("arb_f", 0, 50000),      # Nm/rad
-            "Stabilizer_R": trial.suggest_float("arb_r", 0, 50000),
-            "Camber_Static_F": trial.suggest_float("camber_f", -0.05, -0.01), 
-            "Camber_Static_R": trial.suggest_float("camber_r", -0.03, -0.005),
-            "Toe_Static_F": trial.suggest_float("toe_f", -0.005, 0.005),
-            "Toe_Static_R": trial.suggest_float("toe_r", -0.002, 0.005),
-        }
\ No newline at end of file
+        params = {}
+        for name, opt, lo, hi in self.DYNAMICS_SPACE:
+            # Springs: only the region PhysicsValidator accepts (ride freq, F/R ratio, sag)
+            if name == "Spring_F":
+                lo, hi = self._feasible(self.validator.front_spring_range(lo, hi, *self._space_bounds("Spring_R")), lo, hi)
+            elif name == "Spring_R":
+                lo, hi = self._feasible(self.validator.rear_spring_range(params["Spring_F"], lo, hi), lo, hi)
+            params[name] = trial.suggest_float(opt, lo, hi)
+        return params
+
+    @staticmethod
+    def _feasible(bounds, lo, hi):
+        """Feasible sub-interval, or the full range if the limits leave nothing."""
+        f_lo, f_hi = float(bounds[0]), float(bounds[1])
+        return (f_lo, f_hi) if f_lo < f_hi else (lo, hi)
@@ -1,7 +1,91 @@
+import hashlib
 import os
+import re
 import logging
 import numpy as np
 
+from src.utils.timing import spans
+
+class CompiledTemplate:
+    """
+    CarMaker Infofile (Vehicle / TestRun) parsed once for repeated patching.
+
+    Keeps the lines and an index key -> line numbers of its 'Key = value'
+    and 'Key:' lines (the latter with their tab-indented continuation
+    lines). render() replaces or removes the indexed lines in a copy of the
+    line list, so a patched file costs one lookup per changed key instead
+    of a pass over the whole file per key.
+    """
+    KEY_END = re.compile(r'[ \t=:]')
+
+    def __init__(self, path):
+        self.path = path
+        self._stamp = self._file_stamp(path)
+        with open(path, 'r', encoding='utf-8', errors='ignore') as f:
+            self.lines = f.readlines()
+        self.digest = hashlib.sha1("".join(self.lines).encode("utf-8")).hexdigest()
+
+        self.index = {}
+        self._end = {} # 'Key:' line -> end of its continuation lines
+        for i, line in enumerate(self.lines):
+            stripped = line.strip()
+            m = self.KEY_END.search(stripped)
+            if m is None or m.start() == 0 or line[:1] in ('\t', ' '):
+                continue
+            self.index.setdefault(stripped[:m.start()], []).append(i)
+            if stripped[m.start():].lstrip().startswith(':'):
+                j = i + 1
+                while j < len(self.lines) and self.lines[j][:1] in ('\t', ' ') and self.lines[j].strip():
+                    j += 1
+                self._end[i] = j
+
+    @staticmethod
+    def _file_stamp(path):
+        st = os.stat(path)
+        return st.st_mtime_ns, st.st_size
+
+    def is_current(self):
+        """False if the file was changed or removed since it was parsed."""
+        try:
+            return self._file_stamp(self.path) == self._stamp
+        except OSError:
+            return False
+
+    def keys_containing(self, text):
+        return [key for key in self.index if text in key]
+
+    def block(self, key):
+        """Lines of the first occurrence of 'key' (with continuation lines), [] if missing."""
+        if key not in self.index:
+            return []
+        i = self.index[key][0]
+        return self.lines[i:self._end.get(i, i + 1)]
+
+    def render(self, replace=None, drop=(), append=()):
+        """
+        Text of the template with the blocks of the keys in 'replace' set to
+        'Key = value' (a list value replaces the whole block by these lines),
+        the keys in 'drop' removed and the lines in 'append' added at the end.
+        Keys the template doesn't have are ignored.
+        """
+        lines = list(self.lines)
+        for key, val in (replace or {}).items():
+            for i in self.index.get(key, ()):
+                # The continuation lines of a 'Key:' block go with it in both cases
+                lines[i:self._end.get(i, i + 1)] = [""] * (self._end.get(i, i + 1) - i)
+                lines[i] = "".join(val) if isinstance(val, list) else f"{key} = {val}\n"
+        for key in drop:
+            for i in self.index.get(key, ()):
+                lines[i:self._end.get(i, i + 1)] = [""] * (self._end.get(i, i + 1) - i)
+        lines.extend(append)
+        return "".join(lines)
+
+    @staticmethod
+    def write(path, text):
+        """One buffered write of a rendered file."""
+        with open(path, 'w', encoding='utf-8', buffering=max(8192, 2 * len(text))) as f:
+            f.write(text)
+
 class ParameterManager:
     """
     Handles the modification of CarMaker text files (Vehicle or TestRun).
@@ -39,83 +123,41 @@ class ParameterManager:
             # Note: Camber/Toe are NOT simple parameters in the vehicle file
             # They're part of the kinematic .skc file, so we skip them for now
         }
+        
+        # Controller gains of the Simulink model (Parameters/FSE_Parameters.m),
+        # set per TestRun through Tun.<model>.<param> keys (TunBatch.c)
+        self.TUNABLE_MODEL = "OPENXWD"
+        self.TUNABLE_PARAMS = ["TC_Derivative", "TC_Relay_On", "TC_Relay_Off",
+                               "TV_Override", "Brake_Mech_Rec_Ratio"]
+
+        self._template = None # CompiledTemplate of template_path
+
+        # Model parameters of the digital twin (SystemIdentifier), scales / offsets
+        # of the template's values. The tire grip is the road friction of the TestRun.
+        self.NOMINAL_FRICTION = 1.3 # Road.Link.0.Friction of FS_SkidPad
+        self.base_physics = {}      # calibrated, applied to every injected vehicle
 
     def inject_parameters(self, output_path, parameters):
         """
         Inject parameters into the vehicle file.
         Only modifies parameters that exist in PARAM_MAP.
         """
+        with spans.span("inject"):
+            return self._inject(output_path, parameters)
+
+    def _inject(self, output_path, parameters):
         try:
             if not os.path.exists(self.template_path):
                 self.logger.error(f"Template not found: {self.template_path}")
                 return False
 
-            with open(self.template_path, 'r', encoding='utf-8', errors='ignore') as f:
-                lines = f.readlines()
-
-            # Calculate any mass penalties
-            mass_updates = self._calculate_mass_penalty(parameters)
-            raw_params = {**parameters, **mass_updates}
-            
-            # Filter to only valid parameters
-            valid_params = {}
-            for k, v in raw_params.items():
-                if k in self.PARAM_MAP:
-                    # Map to CarMaker key
-                    cm_key = self.PARAM_MAP[k]
-                    valid_params[cm_key] = v
-                elif k in ["Body.Mass", "Body.Ixx", "Body.Iyy", "Body.Izz"]:
-                    # Direct body parameters
-                    valid_params[k] = v
+            self._compiled()
+            valid_params = self._written_values(parameters)
 
             self.logger.info(f"   -> Injecting {len(valid_params)} parameters")
             
-            new_lines = []
-            keys_handled = set()
-
-            # Process each line
-            for line in lines:
-                line_handled = False
-                stripped = line.strip()
-                
-                # Check if this line matches any parameter we want to change
-                for key, val in valid_params.items():
-                    # Match "Key = Value" or "Key = ..." pattern
-                    if stripped.startswith(key):
-                        # Check next character is space, =, or tab
-                        if len(stripped) > len(key) and stripped[len(key)] in [' ', '=', '\t']:
-                            # Special handling for damper amplify (has $ variable)
-                            if "Amplify" in key:
-                                # Convert raw damping value to amplify factor
-                                # Base values from template: ~150-500 N/(m/s)
-                                # User values: 500-8000 N/(m/s)
-                                # Amplify = user_value / base_value
-                                base_value = 1.0  # We'll scale relative to current Amplify
-                                
-                                # Extract current amplify if it exists
-                                if "=" in stripped:
-                                    parts = stripped.split("=")
-                                    if len(parts) > 1:
-                                        try:
-                                            current = parts[1].strip().replace("$amp=", "")
-                                            base_value = float(current)
-                                        except:
-                                            base_value = 1.0
-                                
-                                # Calculate new amplify factor
-                                # Assuming base damping ~2000 N/(m/s)
-                                new_amplify = val / 2000.0
-                                new_lines.append(f"{key} = {new_amplify:.3f}\n")
-                            else:
-                                # Simple value replacement
-                                new_lines.append(f"{key} = {val}\n")
-                            
-                            keys_handled.add(key)
-                            line_handled = True
-                            break
-                
-                if not line_handled:
-                    new_lines.append(line)
+            keys_handled = [k for k in valid_params if k in self._template.index]
+            text = self._template.render({**self.physics_blocks(self.base_physics), **valid_params})
 
             # Log what was changed
             if keys_handled:
@@ -123,10 +165,7 @@ class ParameterManager:
             else:
                 self.logger.warning(f"   -> No parameters were modified!")
 
-            # Write output
-            with open(output_path, 'w', encoding='utf-8') as f:
-                f.writelines(new_lines)
-            
+            CompiledTemplate.write(output_path, text)
             return True
 
         except Exception as e:
@@ -135,6 +174,95 @@ class ParameterManager:
             traceback.print_exc()
             return False
 
+    def _written_values(self, parameters):
+        """CarMaker key -> value of the parameters that map onto the vehicle file."""
+        # Calculate any mass penalties
+        mass_updates = self._calculate_mass_penalty(parameters)
+        raw_params = {**parameters, **mass_updates}
+        
+        # Filter to only valid parameters
+        valid_params = {}
+        for k, v in raw_params.items():
+            if k in self.PARAM_MAP:
+                cm_key = self.PARAM_MAP[k]
+                if "Amplify" in cm_key:
+                    # Dampers: raw damping value -> amplify factor of the
+                    # lookup table, assuming base damping ~2000 N/(m/s)
+                    v = f"{v / 2000.0:.3f}"
+                valid_params[cm_key] = v
+            elif k in ["Body.Mass", "Body.Ixx", "Body.Iyy", "Body.Izz"]:
+                # Direct body parameters
+                valid_params[k] = v
+        return valid_params
+
+    def fingerprint(self, parameters):
+        """
+        What inject_parameters() writes for 'parameters' (ResultCache key):
+        the template hash, the values as formatted into the file for the keys
+        the template has, and the base physics blocks.
+        """
+        tpl = self._compiled()
+        written = {k: str(v) for k, v in self._written_values(parameters).items() if k in tpl.index}
+        return {'template': tpl.digest, 'values': written,
+                'physics': {k: "".join(v) for k, v in self.physics_blocks(self.base_physics).items()}}
+
+    def _compiled(self):
+        # Parsed once, again only if the file changed
+        if self._template is None or not self._template.is_current():
+            self._template = CompiledTemplate(self.template_path)
+        return self._template
+
+    def physics_blocks(self, physics):
+        """
+        Vehicle blocks {key: lines} for the model parameters in 'physics':
+        Aero_Drag_Scale / Aero_Lift_Scale scale the Fx / Fz columns of Aero.Coeff,
+        CoG_Height_Offset moves Body.pos up (m), Brake_Friction_Scale is the
+        Brake.Torque.Amplify of all wheels.
+        """
+        if not physics:
+            return {}
+        tpl = self._compiled()
+        blocks = {}
+
+        drag = physics.get("Aero_Drag_Scale", 1.0)
+        lift = physics.get("Aero_Lift_Scale", 1.0)
+        coeff = tpl.block("Aero.Coeff")
+        if coeff and ("Aero_Drag_Scale" in physics or "Aero_Lift_Scale" in physics):
+            # Rows: angle, Fx, Fy, Fz, Mx, My, Mz
+            lines = [coeff[0]]
+            for row in coeff[1:]:
+                v = [float(x) for x in row.split()]
+                v[1] *= drag
+                v[3] *= lift
+                lines.append("\t" + " ".join(f"{x:.4g}" for x in v) + "\n")
+            blocks["Aero.Coeff"] = lines
+
+        pos = tpl.block("Body.pos")
+        if pos and "CoG_Height_Offset" in physics:
+            x, y, z = [float(v) for v in pos[0].split("=", 1)[1].split()[:3]]
+            blocks["Body.pos"] = [f"Body.pos = {x:g} {y:g} {z + physics['CoG_Height_Offset']:.4f}\n"]
+
+        if "Brake_Friction_Scale" in physics:
+            amp = f"{physics['Brake_Friction_Scale']:.4f}"
+            blocks["Brake.Torque.Amplify"] = [f"Brake.Torque.Amplify = {amp} {amp} {amp} {amp}\n"]
+        return blocks
+
+    def physics_testrun_keys(self, physics):
+        """TestRun keys for the model parameters in 'physics' (tire grip as road friction)."""
+        if "Tire_Mu_Scale" not in physics:
+            return {}
+        return {"Road.Link.0.Friction": round(self.NOMINAL_FRICTION * physics["Tire_Mu_Scale"], 4)}
+
+    def update_base_physics(self, physics):
+        """Calibrated model parameters ({Tire_Mu_Scale: ..}), applied to all later trials."""
+        self.base_physics = dict(physics)
+        self.logger.info(f"   -> Base physics: {self.base_physics}")
+
+    def tunable_keys(self, parameters):
+        """TestRun keys for the controller gains in 'parameters', {} if there are none."""
+        return {f"Tun.{self.TUNABLE_MODEL}.{name}": val
+                for name, val in parameters.items() if name in self.TUNABLE_PARAMS}
+
     def _calculate_mass_penalty(self, parameters):
         """Calculate mass penalty for geometry changes"""
         geo_keywords = ["Wishbone", "Tierod", "Rack", "Pushrod"]
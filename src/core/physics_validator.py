@@ -24,23 +24,85 @@ class PhysicsValidator:
         self.MAX_FREQ_HZ = 4.5
         self.MAX_STATIC_SAG_MM = 25.0 # Max compression under gravity
         self.MIN_STATIC_SAG_MM = 5.0
+        self.MIN_FR_RATIO = 0.7       # Front/Rear ride frequency
+        self.MAX_FR_RATIO = 1.5
+        
+        # Note: We assume Motion Ratio (MR) ~ 1.0 for simplicity, 
+        # or that 'k_spring' is Wheel Rate. If k is Spring Rate, k_wheel = k_spring * MR^2
+        self.MR_FRONT = 1.0 # Update if Bellcrank exists
+        self.MR_REAR = 1.0
 
-    def check_viability(self, params: dict) -> tuple[bool, str]:
+    def metrics(self, spring_f, spring_r):
+        """Ride frequencies (Hz), F/R ratio and static sags (mm); works on scalars or arrays."""
+        k_f = np.asarray(spring_f, dtype=float) * (self.MR_FRONT**2)
+        k_r = np.asarray(spring_r, dtype=float) * (self.MR_REAR**2)
+        
+        with np.errstate(divide='ignore', invalid='ignore'):
+            # f = (1/2pi) * sqrt(k / m)
+            freq_f = (1 / (2 * np.pi)) * np.sqrt(k_f / self.m_s_f)
+            freq_r = (1 / (2 * np.pi)) * np.sqrt(k_r / self.m_s_r)
+            ratio = freq_f / freq_r
+            # Sag = F / k = (m * g) / k
+            sag_f = (self.m_s_f * 9.81) / k_f * 1000 # mm
+            sag_r = (self.m_s_r * 9.81) / k_r * 1000 # mm
+        return freq_f, freq_r, ratio, sag_f, sag_r
+
+    def check_batch(self, spring_f, spring_r):
         """
-        Returns: (is_valid, reason)
+        Vectorized check_viability() for arrays of candidates.
+        Returns a boolean array, True = physically viable.
         """
-        # 1. Calculate Ride Frequencies (Hz)
-        # f = (1/2pi) * sqrt(k / m)
-        # Note: We assume Motion Ratio (MR) ~ 1.0 for simplicity, 
-        # or that 'k_spring' is Wheel Rate. If k is Spring Rate, k_wheel = k_spring * MR^2
-        mr_front = 1.0 # Update if Bellcrank exists
-        mr_rear = 1.0
+        freq_f, freq_r, ratio, sag_f, sag_r = self.metrics(spring_f, spring_r)
+        return ((self.MIN_FREQ_HZ <= freq_f) & (freq_f <= self.MAX_FREQ_HZ)
+                & (self.MIN_FREQ_HZ <= freq_r) & (freq_r <= self.MAX_FREQ_HZ)
+                & (ratio <= self.MAX_FR_RATIO) & (ratio >= self.MIN_FR_RATIO)
+                & (sag_f <= self.MAX_STATIC_SAG_MM) & (sag_f >= self.MIN_STATIC_SAG_MM)
+                & (sag_r <= self.MAX_STATIC_SAG_MM) & (sag_r >= self.MIN_STATIC_SAG_MM))
+
+    # --- FEASIBLE REGION (for the sampler) ---
+    # Every check is an interval on a wheel rate, and the F/R ratio bounds the
+    # rear rate by the front one, so the valid set is known in closed form.
+    _EPS = 1e-9 # Keep sampled points strictly inside against float rounding
+
+    def _wheel_rate_box(self, m):
+        w_lo, w_hi = 2 * np.pi * self.MIN_FREQ_HZ, 2 * np.pi * self.MAX_FREQ_HZ
+        lo = max(m * w_lo**2, m * 9.81 / (self.MAX_STATIC_SAG_MM / 1000))
+        hi = min(m * w_hi**2, m * 9.81 / (self.MIN_STATIC_SAG_MM / 1000))
+        return lo, hi
+
+    def _ratio_factors(self):
+        # k_r = k_f * (m_r / m_f) / ratio^2
+        c = self.m_s_r / self.m_s_f
+        return c / self.MAX_FR_RATIO**2, c / self.MIN_FR_RATIO**2
+
+    def front_spring_range(self, lo, hi, lo_r, hi_r):
+        """Front spring interval within [lo, hi] that has a valid rear partner in [lo_r, hi_r]."""
+        mr_f2, mr_r2 = self.MR_FRONT**2, self.MR_REAR**2
+        box_lo, box_hi = self._wheel_rate_box(self.m_s_f)
+        rear_lo, rear_hi = self._wheel_rate_box(self.m_s_r)
+        rear_lo, rear_hi = max(rear_lo, lo_r * mr_r2), min(rear_hi, hi_r * mr_r2)
+        c_lo, c_hi = self._ratio_factors()
         
-        k_f = params.get("Spring_F", 0) * (mr_front**2)
-        k_r = params.get("Spring_R", 0) * (mr_rear**2)
+        k_lo = max(box_lo, rear_lo / c_hi, lo * mr_f2) / mr_f2
+        k_hi = min(box_hi, rear_hi / c_lo, hi * mr_f2) / mr_f2
+        return k_lo * (1 + self._EPS), k_hi * (1 - self._EPS)
+
+    def rear_spring_range(self, spring_f, lo, hi):
+        """Valid rear spring interval for a given front spring (scalar or array)."""
+        mr_f2, mr_r2 = self.MR_FRONT**2, self.MR_REAR**2
+        box_lo, box_hi = self._wheel_rate_box(self.m_s_r)
+        c_lo, c_hi = self._ratio_factors()
+        k_f = np.asarray(spring_f, dtype=float) * mr_f2
         
-        freq_f = (1 / (2 * np.pi)) * np.sqrt(k_f / self.m_s_f)
-        freq_r = (1 / (2 * np.pi)) * np.sqrt(k_r / self.m_s_r)
+        k_lo = np.maximum(max(box_lo, lo * mr_r2), k_f * c_lo) / mr_r2
+        k_hi = np.minimum(min(box_hi, hi * mr_r2), k_f * c_hi) / mr_r2
+        return k_lo * (1 + self._EPS), k_hi * (1 - self._EPS)
+
+    def check_viability(self, params: dict) -> tuple[bool, str]:
+        """
+        Returns: (is_valid, reason)
+        """
+        freq_f, freq_r, ratio, sag_f, sag_r = self.metrics(params.get("Spring_F", 0), params.get("Spring_R", 0))
         
         # CHECK 1: Frequency Range (Comfort vs Grip window)
         if not (self.MIN_FREQ_HZ <= freq_f <= self.MAX_FREQ_HZ):
@@ -53,19 +115,14 @@ class PhysicsValidator:
         # Usually Rear Freq > Front Freq is preferred for flat ride,
         # but in Aero cars (FS), stiff front is common for platform control.
         # We just check they aren't wildly mismatched.
-        ratio = freq_f / freq_r
-        if ratio > 1.5 or ratio < 0.7:
+        if ratio > self.MAX_FR_RATIO or ratio < self.MIN_FR_RATIO:
              return False, f"Freq Imbalance F/R ratio: {ratio:.2f}"
 
         # CHECK 3: Static Sag (Gravity Drop)
-        # Sag = F / k = (m * g) / k
-        sag_f = (self.m_s_f * 9.81) / k_f * 1000 # mm
-        sag_r = (self.m_s_r * 9.81) / k_r * 1000 # mm
-        
         if sag_f > self.MAX_STATIC_SAG_MM or sag_f < self.MIN_STATIC_SAG_MM:
             return False, f"Front Static Sag {sag_f:.1f}mm invalid"
             
         if sag_r > self.MAX_STATIC_SAG_MM or sag_r < self.MIN_STATIC_SAG_MM:
             return False, f"Rear Static Sag {sag_r:.1f}mm invalid"
 
-        return True, "Valid"
\ No newline at end of file
+        return True, "Valid"
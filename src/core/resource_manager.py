@@ -11,15 +11,23 @@ class ResourceManager:
     
     Structure:
     Output/
+      ├── result_cache.db (ResultCache, shared by all campaigns)
       └── Campaign_YYYY-MM-DD_HH-MM/
           ├── optimization.db
+          ├── trial_log_0.jsonl (TrialStore write-behind log, removed once committed)
           ├── Trial_000/
           ├── Trial_001/
+          ├── Worker_00/     (per-worker scratch: Tcl script, debug log)
           └── ...
+
+    The worker scratch folders can live on a RAM disk instead
+    (scratch_root or CM_SCRATCH_ROOT, e.g. /dev/shm or an ImDisk drive):
+    <scratch_root>/Campaign_.../Worker_00/
     """
-    def __init__(self, base_dir="Output"):
+    def __init__(self, base_dir="Output", scratch_root=None):
         self.logger = logging.getLogger("ResourceManager")
         self.base_dir = base_dir
+        self.scratch_root = scratch_root or os.environ.get("CM_SCRATCH_ROOT") or None
         
         # Create a unique name for this entire optimization session
         # Format: Output/Campaign_YYYY-MM-DD_HH-MM
@@ -50,6 +58,24 @@ class ResourceManager:
             self.logger.error(f"Failed to create trial folder {path}: {e}")
             return None
 
+    def setup_worker_folder(self, worker_id):
+        """
+        Creates an isolated scratch folder for a parallel worker (e.g., Worker_03).
+        Every worker writes its own Tcl script and logs here, so concurrent
+        simulations never share a file.
+        """
+        parent = self.campaign_folder
+        if self.scratch_root:
+            parent = os.path.join(self.scratch_root, os.path.basename(self.campaign_folder))
+        path = os.path.abspath(os.path.join(parent, f"Worker_{worker_id:02d}"))
+        
+        try:
+            os.makedirs(path, exist_ok=True)
+            return path
+        except OSError as e:
+            self.logger.error(f"Failed to create worker folder {path}: {e}")
+            raise
+
     def get_db_path(self):
         """
         Returns the SQLalchemy connection string for the database.
@@ -66,6 +92,10 @@ class ResourceManager:
             
         return f"sqlite:///{abs_path}"
 
+    def get_cache_path(self):
+        """Result cache of all campaigns under base_dir."""
+        return os.path.join(self.base_dir, "result_cache.db")
+
     def get_campaign_path(self):
         """Returns the root path of the current campaign."""
         return self.campaign_folder
\ No newline at end of file
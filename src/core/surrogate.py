@@ -1,6 +1,9 @@
 import numpy as np
 import os
+import json
 import joblib
+from scipy.linalg import cholesky, cho_solve, solve_triangular
+from scipy.stats import norm
 from sklearn.gaussian_process import GaussianProcessRegressor
 from sklearn.gaussian_process.kernels import Matern, WhiteKernel, ConstantKernel
 from sklearn.base import clone
@@ -10,6 +13,73 @@ import warnings
 warnings.filterwarnings("ignore")
 logger = logging.getLogger(__name__)
 
+class IncrementalGP:
+    """
+    GP posterior with FIXED hyperparameters (taken from a fitted sklearn GP),
+    grown by one Cholesky row per observation: O(n^2) per update instead of
+    an O(n^3) refit with optimizer restarts.
+    
+    K = [[K_old, k], [k^T, k_xx]]  ->  L = [[L_old, 0], [l^T, d]],
+    l = L_old^-1 k,  d = sqrt(k_xx - l.l)
+    """
+    def __init__(self, alpha=1e-10, normalize_y=False):
+        self.alpha = alpha # Same diagonal jitter as GaussianProcessRegressor
+        self.normalize_y = normalize_y
+        self.kernel = None
+        self.X = None
+        self.y = None
+        self.L = None
+
+    def reset(self, kernel, X, y):
+        """Full factorization, after a hyperparameter fit."""
+        self.kernel = kernel
+        self.X = np.array(X, dtype=float)
+        self.y = np.array(y, dtype=float)
+        K = self.kernel(self.X)
+        K[np.diag_indices_from(K)] += self.alpha
+        self.L = cholesky(K, lower=True)
+        self._solve_weights()
+
+    def add(self, x, y):
+        """Appends one observation. Returns False if the update is numerically unsafe (refit instead)."""
+        x = np.asarray(x, dtype=float)[None, :]
+        k = self.kernel(self.X, x)[:, 0]
+        k_xx = self.kernel.diag(x)[0] + self.alpha
+        l = solve_triangular(self.L, k, lower=True)
+        d2 = k_xx - l @ l
+        if not np.isfinite(d2) or d2 <= 1e-12:
+            return False
+
+        n = len(self.X)
+        L = np.zeros((n + 1, n + 1))
+        L[:n, :n] = self.L
+        L[n, :n] = l
+        L[n, n] = np.sqrt(d2)
+        self.L = L
+        self.X = np.vstack([self.X, x])
+        self.y = np.append(self.y, y)
+        self._solve_weights()
+        return True
+
+    def _solve_weights(self):
+        if self.normalize_y:
+            self._y_mean = np.mean(self.y)
+            self._y_std = np.std(self.y) or 1.0
+        else:
+            self._y_mean, self._y_std = 0.0, 1.0
+        self.weights = cho_solve((self.L, True), (self.y - self._y_mean) / self._y_std)
+
+    def predict(self, X, return_std=False):
+        X = np.asarray(X, dtype=float)
+        K_s = self.kernel(X, self.X)
+        mu = K_s @ self.weights * self._y_std + self._y_mean
+        if not return_std:
+            return mu
+        v = solve_triangular(self.L, K_s.T, lower=True)
+        var = self.kernel.diag(X) - np.sum(v * v, axis=0)
+        return mu, np.sqrt(np.clip(var, 0.0, None)) * self._y_std
+
+
 class SurrogateOracle:
     """
     GEN 6.0: Constrained Bayesian Optimization (cBO) Oracle.
@@ -17,9 +87,20 @@ class SurrogateOracle:
     
     Model 1: Objective (Lap Time)
     Model 2: Constraint (Probability of Crash)
+    
+    Incremental mode: hyperparameters are re-optimized every REFIT_EVERY
+    observations; in between, new points only extend the Cholesky factor
+    (IncrementalGP). Observations are appended to a log (<storage>.jsonl),
+    which is the state; the .pkl snapshot is only rewritten to compact the
+    log once it holds COMPACT_EVERY records, not at every refit.
     """
-    def __init__(self, storage_path="data/knowledge_base.pkl"):
+    REFIT_EVERY = 25
+    COMPACT_EVERY = 500
+
+    def __init__(self, storage_path="data/knowledge_base.pkl", incremental=True):
         self.storage_path = storage_path
+        self.log_path = os.path.splitext(storage_path)[0] + ".jsonl"
+        self.incremental = incremental
         
         # Generic Kernel
         kernel = ConstantKernel(1.0) * Matern(nu=2.5) + WhiteKernel(noise_level=0.1)
@@ -33,7 +114,15 @@ class SurrogateOracle:
         self.y_time = [] # Lap times (only for valid runs)
         self.y_feas = [] # 1.0 = Valid, 0.0 = Crash
         
+        self.inc_time = IncrementalGP(alpha=self.model_time.alpha, normalize_y=True)
+        self.inc_feas = IncrementalGP(alpha=self.model_feas.alpha, normalize_y=False)
+        self._inc_ready = False
+        self._since_refit = 0
+        self._log_records = 0 # records in the log, not yet in the snapshot
+        
         self._load_state()
+        if self.incremental and len(self.X) >= 5:
+            self.train()
 
     def update(self, params: dict, cost: float, is_crash: bool):
         """
@@ -54,8 +143,27 @@ class SurrogateOracle:
             # or manage separate arrays (better).
             pass 
 
-        self.train()
-        self._save_state()
+        if not self.incremental:
+            self.train()
+            self._save_state()
+            return
+
+        self._append_log(x_vec, cost, is_crash)
+        self._since_refit += 1
+        if not self._inc_ready or self._since_refit >= self.REFIT_EVERY or not self._extend(x_vec, cost, is_crash):
+            self.train()
+        if self._log_records >= self.COMPACT_EVERY:
+            self._save_state()
+
+    def _extend(self, x_vec, cost, is_crash):
+        """Rank-one growth of both posteriors with the current hyperparameters."""
+        if not self.inc_feas.add(x_vec, 0.0 if is_crash else 1.0):
+            return False
+        if not is_crash:
+            if self.inc_time.X is None:
+                return len(self.y_time) <= 2 # Time model gets enough data -> refit
+            return self.inc_time.add(x_vec, cost)
+        return True
 
     def predict_score(self, params: dict):
         """
@@ -64,11 +172,25 @@ class SurrogateOracle:
         """
         if not self.is_trained:
             return 1.0 # Pure exploration
+        return float(self.predict_scores([params])[0])
+
+    def predict_scores(self, batch):
+        """
+        Batch acquisition: EI x P(feasible) for many candidates in one call.
+        batch: list of param dicts (same key order as update()) or an (n, d) array.
+        Returns an (n,) array, lower = better (negative EI, Optuna minimizes).
+        """
+        if len(batch) and isinstance(batch[0], dict):
+            X = np.array([list(p.values()) for p in batch], dtype=float)
+        else:
+            X = np.atleast_2d(np.asarray(batch, dtype=float))
+        if not self.is_trained:
+            return np.ones(len(X)) # Pure exploration
 
-        x_in = np.array([list(params.values())])
+        model_time, model_feas = self._models()
         
         # 1. Predict Mean and Uncertainty (Standard Deviation)
-        mu, sigma = self.model_time.predict(x_in, return_std=True)
+        mu, sigma = model_time.predict(X, return_std=True)
         
         # 2. Get current best observed value
         current_best = min(self.y_time) if self.y_time else 100.0
@@ -78,16 +200,20 @@ class SurrogateOracle:
         with np.errstate(divide='warn'):
             imp = current_best - mu
             Z = imp / (sigma + 1e-9)
-            from scipy.stats import norm
             ei = imp * norm.cdf(Z) + sigma * norm.pdf(Z)
             
-        # 4. Feasibility Weighting (Constraint)
-        prob_success, _ = self.model_feas.predict(x_in, return_std=True)
-        prob_success = np.clip(prob_success[0], 0.0, 1.0)
+        # 4. Feasibility Weighting (Constraint), mean only
+        prob_success = np.clip(model_feas.predict(X), 0.0, 1.0)
         
         # Final Score: High EI * High Probability of Survival
-        # We return negative because Optuna minimizes, but EI is "higher is better"
-        return -(ei[0] * prob_success)
+        return -(ei * prob_success)
+
+    def _models(self):
+        """(time, feasibility) predictors: incremental posteriors when available."""
+        if self._inc_ready:
+            time_model = self.inc_time if self.inc_time.X is not None else self.model_time
+            return time_model, self.inc_feas
+        return self.model_time, self.model_feas
 
     def train(self):
         if len(self.X) < 5: return
@@ -103,14 +229,42 @@ class SurrogateOracle:
             if len(valid_indices) > 2:
                 self.model_time.fit(X_all[valid_indices], np.array(self.y_time))
             self.is_trained = True
-        except Exception: pass
+        except Exception: return
+
+        # Freeze the fitted hyperparameters for the incremental updates
+        self._inc_ready = False
+        if self.incremental:
+            try:
+                self.inc_feas.reset(self.model_feas.kernel_, X_all, y_feas)
+                if len(valid_indices) > 2:
+                    self.inc_time.reset(self.model_time.kernel_, X_all[valid_indices], np.array(self.y_time))
+                self._inc_ready = True
+            except (np.linalg.LinAlgError, ValueError) as e:
+                logger.warning(f"Incremental GP disabled until next refit: {e}")
+        self._since_refit = 0
+
+    def _append_log(self, x_vec, cost, is_crash):
+        """Append-only persistence: one JSON line per observation."""
+        try:
+            os.makedirs(os.path.dirname(self.log_path) or ".", exist_ok=True)
+            with open(self.log_path, "a", encoding="utf-8") as f:
+                f.write(json.dumps({"i": len(self.X) - 1, "x": [float(v) for v in x_vec],
+                                    "cost": float(cost), "crash": bool(is_crash)}) + "\n")
+            self._log_records += 1
+        except OSError: pass
 
     def _save_state(self):
+        """Full snapshot; in incremental mode also compacts the observation log."""
         try:
             os.makedirs(os.path.dirname(self.storage_path), exist_ok=True)
+            tmp_path = self.storage_path + ".tmp"
             joblib.dump({
                 "X": self.X, "y_time": self.y_time, "y_feas": self.y_feas
-            }, self.storage_path)
+            }, tmp_path)
+            os.replace(tmp_path, self.storage_path)
+            if self.incremental and os.path.exists(self.log_path):
+                open(self.log_path, "w").close()
+                self._log_records = 0
         except: pass
 
     def _load_state(self):
@@ -121,4 +275,23 @@ class SurrogateOracle:
                 self.y_time = data["y_time"]
                 self.y_feas = data["y_feas"]
                 self.is_trained = True
-            except: pass
\ No newline at end of file
+            except: pass
+
+        # Replay observations appended since the last snapshot
+        if os.path.exists(self.log_path):
+            try:
+                with open(self.log_path, "r", encoding="utf-8") as f:
+                    for line in f:
+                        try:
+                            rec = json.loads(line)
+                        except ValueError:
+                            continue # Torn last line
+                        if rec.get("i", 0) < len(self.X):
+                            continue # Already in the snapshot
+                        self._log_records += 1
+                        self.X.append(rec["x"])
+                        self.y_feas.append(0.0 if rec["crash"] else 1.0)
+                        if not rec["crash"]:
+                            self.y_time.append(rec["cost"])
+                self.is_trained = len(self.X) > 0
+            except OSError: pass
@@ -3,84 +3,194 @@ import pandas as pd
 import numpy as np
 import logging
 import os
-from sklearn.metrics import mean_squared_error
+import queue
 from src.interface.carmaker_interface import CarMakerInterface
 from src.core.parameter_manager import ParameterManager
+from src.database.data_handler import load_binexport
 
 class SystemIdentifier:
     """
     PHASE 5: SYSTEM IDENTIFICATION (The 'Digital Twin' Engine)
-    
+
     Goal: Tune 'Hidden' physical parameters (Tire Mu, Aero Drag, Inertia)
     so that Sim_Telemetry matches Real_Telemetry.
-    
+
+    The real log is resampled once onto a uniform time base (DT). Every
+    calibration run exports the target channels (BinExport.c), which are
+    put on the same time base and compared with one vectorized, windowed
+    RMSE: each WINDOW seconds may be shifted by up to MAX_SHIFT against
+    the log, channels are normalized by the log's standard deviation.
+
+    Trials run in parallel on the worker pool of the Orchestrator. The
+    vehicle setup is fixed; the model parameters are sent by hot parameter
+    injection (HotParam.c) to sessions that have it loaded already.
+
     References: AMZ Racing 'Model Validation' methodology.
     """
-    def __init__(self, real_log_path, storage_url):
+    # Model parameters: (ParameterManager name, Optuna name, low, high)
+    PHYSICS_SPACE = [
+        ("Tire_Mu_Scale", "tire_mu", 0.85, 1.15),
+        ("Aero_Drag_Scale", "aero_cd", 0.90, 1.20),
+        ("Aero_Lift_Scale", "aero_cl", 0.80, 1.10),
+        ("CoG_Height_Offset", "cog_z_offset", -0.05, 0.05), # +/- 50mm error
+        ("Brake_Friction_Scale", "brake_mu", 0.9, 1.1),
+    ]
+    # Column names of the real log -> CarMaker quantities
+    LOG_ALIASES = {'v': 'Car.v', 'YawRate': 'Car.YawRate', 'ax': 'Car.ax', 'ay': 'Car.ay'}
+
+    DT = 0.02              # s, shared time base (50 Hz)
+    WINDOW = 2.0           # s, each window gets its own time shift (0 = one window)
+    MAX_SHIFT = 0.2        # s, tolerated time shift between sim and log
+    MISSING_PENALTY = 4.0  # error per fraction of the log the run didn't cover
+    FAIL_ERROR = 1e3
+
+    def __init__(self, real_log_path, storage_url, workers=None, n_workers=1, param_manager=None,
+                 vehicle_path="templates/FSE_AllWheelDrive"):
         self.logger = logging.getLogger("SystemID")
-        self.real_data = self._load_log(real_log_path)
-        self.storage_url = storage_url
-        self.cm_interface = CarMakerInterface()
-        self.param_manager = ParameterManager()
-        
+
         # We focus on these specific channels for correlation
         self.target_channels = ['Time', 'Car.v', 'Car.YawRate', 'Car.ax', 'Car.ay']
+        self.real_data = self._load_log(real_log_path)
+        self.storage_url = storage_url
+
+        # Simulations on the Orchestrator's workers, if given (one per parallel trial)
+        self.n_workers = max(1, n_workers)
+        if workers is None:
+            workers = queue.Queue()
+            workers.put(CarMakerInterface())
+            self.n_workers = 1
+        self.workers = workers
+        self.param_manager = param_manager or ParameterManager(template_path=vehicle_path)
+        self.vehicle_path = vehicle_path
+
+        if self.real_data is not None:
+            self._build_time_base()
 
     def _load_log(self, path):
         try:
-            # Assumes CSV format: Time, v, YawRate, ax, ay
-            df = pd.read_csv(path)
-            # Resample real data to 50Hz to match CarMaker output if needed
-            return df
+            # Assumes CSV format: Time, v, YawRate, ax, ay (or the CarMaker names)
+            df = pd.read_csv(path).rename(columns=self.LOG_ALIASES)
         except Exception:
             self.logger.warning("⚠️ No Real World Log found. SystemID disabled.")
             return None
+        missing = [c for c in self.target_channels if c not in df.columns]
+        if missing:
+            self.logger.warning(f"⚠️ Real World Log lacks {missing}. SystemID disabled.")
+            return None
+        return df
+
+    def _build_time_base(self):
+        """Log resampled once onto the time base, scaled per channel."""
+        t = self.real_data['Time'].to_numpy(dtype=float)
+        t = t - t[0]
+        self.time_base = np.arange(0.0, t[-1], self.DT)
+        self.channels = self.target_channels[1:]
+        self.real = self._resample(t, self.real_data[self.channels].to_numpy(dtype=float))
+
+        scale = np.nanstd(self.real, axis=0)
+        self.scale = np.where(scale > 1e-6, scale, 1.0)
+        self.logger.info(f"🔧 Real log: {self.time_base[-1]:.1f} s, {len(self.time_base)} samples on the time base")
+
+    def _resample(self, t, values):
+        """values (len(t) x channels) on the time base, NaN outside of t."""
+        order = np.argsort(t, kind="stable")
+        t, values = t[order], values[order]
+        keep = np.concatenate(([True], np.diff(t) > 0))
+        t, values = t[keep], values[keep]
+        return np.column_stack([np.interp(self.time_base, t, values[:, j], left=np.nan, right=np.nan)
+                                for j in range(values.shape[1])])
 
     def calibrate(self, n_trials=50):
         if self.real_data is None: return None
-        
+
         study = optuna.create_study(
             study_name="SystemID_Calibration",
             storage=self.storage_url,
             direction="minimize",
-            load_if_exists=True
+            load_if_exists=True,
+            sampler=optuna.samplers.TPESampler(constant_liar=self.n_workers > 1)
         )
-        
-        self.logger.info("🔧 Starting Model Calibration (Sim-to-Real Matching)...")
-        study.optimize(self._calibration_objective, n_trials=n_trials)
-        
-        best_physics = study.best_params
-        self.logger.info(f"✅ Calibration Complete. Real Car Stats: {best_physics}")
+
+        self.logger.info(f"🔧 Starting Model Calibration (Sim-to-Real Matching, {self.n_workers} worker(s))...")
+        study.optimize(self._calibration_objective, n_trials=n_trials, n_jobs=self.n_workers)
+
+        best_physics = {name: study.best_params[opt] for name, opt, _, _ in self.PHYSICS_SPACE}
+        self.logger.info(f"✅ Calibration Complete (error {study.best_value:.4f}). Real Car Stats: {best_physics}")
         return best_physics
 
     def _calibration_objective(self, trial):
         # 1. Suggest 'Unknown' Physical Properties
         # These are NOT setup parameters (springs), but MODEL parameters (friction, drag)
-        model_params = {
-            "Tire_Mu_Scale": trial.suggest_float("tire_mu", 0.85, 1.15),
-            "Aero_Drag_Scale": trial.suggest_float("aero_cd", 0.90, 1.20),
-            "Aero_Lift_Scale": trial.suggest_float("aero_cl", 0.80, 1.10),
-            "CoG_Height_Offset": trial.suggest_float("cog_z_offset", -0.05, 0.05), # +/- 50mm error
-            "Brake_Friction_Scale": trial.suggest_float("brake_mu", 0.9, 1.1)
-        }
-        
+        model_params = {name: trial.suggest_float(opt, lo, hi) for name, opt, lo, hi in self.PHYSICS_SPACE}
+
         # 2. Run Simulation with fixed setup but variable Physics
-        # We use a 'Benchmark' testrun (e.g., Skidpad or a specific log replay)
-        trial_folder = f"Output/Calibration_{trial.number}"
+        trial_folder = os.path.abspath(f"Output/Calibration_{trial.number}")
         os.makedirs(trial_folder, exist_ok=True)
-        
-        # Inject Model Parameters (You need to map these in ParameterManager)
-        # vehicle_file = ... 
-        # self.param_manager.inject_physics(vehicle_file, model_params)
-        
-        # For now, we simulate the run (Simulated Lap)
-        # res = self.cm_interface.run_test(...)
-        
+
+        vehicle_keys = self.param_manager.physics_blocks(model_params)
+        testrun_keys = self.param_manager.physics_testrun_keys(model_params)
+        # Export buffer long enough for the whole log
+        testrun_keys["BinExport.MaxTime"] = max(120, int(self.time_base[-1]) + 10)
+
+        cm_interface = self.workers.get()
+        hot_params = cm_interface.HOT_PARAMS
+        try:
+            # Only the model parameters change: hot injected where a session has the vehicle loaded
+            cm_interface.HOT_PARAMS = cm_interface.session_pool is not None
+            result = cm_interface.run_test(self.vehicle_path, trial_folder, f"Calib_{trial.number}",
+                                           tunables=testrun_keys, vehicle_keys=vehicle_keys)
+            export_file = cm_interface.export_path(trial_folder)
+        finally:
+            cm_interface.HOT_PARAMS = hot_params
+            self.workers.put(cm_interface)
+
         # 3. Calculate Error (RMSE) between Sim and Real
-        # This is a placeholder logic. In reality, you compare the time-series.
-        # error = RMSE(Sim_Velocity - Real_Velocity) + RMSE(Sim_Yaw - Real_Yaw)
-        
-        # Mock error for the 'skeleton'
-        error = (model_params["Tire_Mu_Scale"] - 1.0)**2 + (model_params["Aero_Drag_Scale"] - 1.05)**2
-        
-        return error
\ No newline at end of file
+        sim = self._load_sim(export_file)
+        if sim is None:
+            self.logger.warning(f"Calibration trial {trial.number}: no sim output ({result.get('status')})")
+            return self.FAIL_ERROR
+        return self._error(sim)
+
+    def _load_sim(self, export_file):
+        """Target channels of a run on the time base, None if the export is missing."""
+        if not export_file or not os.path.exists(export_file):
+            return None
+        try:
+            df = load_binexport(export_file)
+        except (OSError, ValueError):
+            return None
+        if len(df) < 2 or any(c not in df.columns for c in self.target_channels):
+            return None
+        return self._resample(df['Time'].to_numpy(dtype=float), df[self.channels].to_numpy(dtype=float))
+
+    def _error(self, sim):
+        """
+        Normalized RMSE of sim against the log (both time base x channels).
+        Per window the best of all shifts within MAX_SHIFT counts; the part
+        of the log the sim doesn't cover (crash, early stop) is penalized.
+        """
+        n, n_ch = self.real.shape
+        k = int(round(self.MAX_SHIFT / self.DT))
+        w = int(round(self.WINDOW / self.DT)) if self.WINDOW > 0 else n
+        w = min(max(w, 1), n)
+        m = (n // w) * w
+
+        # All shifts at once: (shifts, channels, n) view of the padded sim
+        padded = np.full((n + 2 * k, n_ch), np.nan)
+        padded[k:k + n] = sim
+        shifted = np.lib.stride_tricks.sliding_window_view(padded, n, axis=0)[:, :, :m]
+
+        d = (shifted.transpose(0, 2, 1) - self.real[:m]) / self.scale
+        d = d.reshape(2 * k + 1, m // w, w * n_ch)
+        valid = ~np.isnan(d)
+        count = valid.sum(axis=2)
+        sq = np.where(valid, d, 0.0) ** 2
+        with np.errstate(invalid='ignore', divide='ignore'):
+            mse = np.where(count > 0, sq.sum(axis=2) / count, np.inf)
+        best = mse.min(axis=0) # per window
+
+        ok = np.isfinite(best)
+        if not ok.any():
+            return self.FAIL_ERROR
+        missing = 1.0 - np.mean(~np.isnan(sim[:, 0]) | np.isnan(self.real[:, 0]))
+        return float(np.sqrt(best[ok].mean()) + self.MISSING_PENALTY * missing)
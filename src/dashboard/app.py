@@ -1,15 +1,28 @@
 import streamlit as st
-import optuna
 import pandas as pd
 import plotly.graph_objects as go
 import plotly.express as px
 import numpy as np
 import os
+import sys
 import glob
+import time
+from collections import deque
+
+# Repo root, for the src.* imports
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), "..", "..")))
+from src.dashboard.study_cache import StudyCache
+from src.interface.telemetry import discover
 
 # --- CONFIGURATION ---
 PAGE_TITLE = "FSAE OPTIMIZER"
 BASE_OUTPUT_DIR = "Output"
+# Live telemetry regions of the CM4SL app (CarMakerInterface.TELEMETRY), one per
+# session: <prefix>_<cmdport>, ports from SessionPool(base_port=16660)
+TELEMETRY_PREFIX = "CMTelemetry"
+TELEMETRY_PORTS = range(16660, 16676)
+LIVE_HISTORY = 600 # samples per worker and quantity
+LIVE_REFRESH = 1.0 # s
 
 st.set_page_config(
     page_title=PAGE_TITLE, 
@@ -44,56 +57,62 @@ def get_campaigns():
     folders.sort(key=os.path.getmtime, reverse=True)
     return [os.path.basename(f) for f in folders]
 
+@st.cache_resource
+def get_study_cache(db_path):
+    """One incremental reader per database, kept across reruns."""
+    return StudyCache(db_path)
+
 def load_study_data(db_path, selected_mode):
     """
-    NUCLEAR OPTION: Drops datetime columns entirely to prevent INT64 Overflow.
+    Finished trials of the studies matching the mode. Only trials that are
+    new or finished since the last call are read (StudyCache), through a
+    read-only connection, so a redraw doesn't contend with the optimizer.
     """
-    storage_url = f"sqlite:///{os.path.abspath(db_path)}"
     try:
-        summaries = optuna.get_all_study_summaries(storage=storage_url)
-        all_dfs = []
-        
-        for summary in summaries:
-            if selected_mode.lower() not in summary.study_name.lower():
-                continue
-                
-            study = optuna.load_study(study_name=summary.study_name, storage=storage_url)
-            df = study.trials_dataframe()
-            
-            # 1. Clean Column Names
-            df.columns = [col.replace("user_attrs_", "").replace("params_", "") for col in df.columns]
-            
-            # 2. Filter Completed
-            if "state" in df.columns:
-                df = df[df["state"] == "COMPLETE"]
-            
-            # 3. Rename Target
-            if "value" in df.columns:
-                df.rename(columns={"value": "Lap Time"}, inplace=True)
-            
-            # --- THE FIX: DELETE THE TIMESTAMPS ---
-            # Do not try to convert them. Just drop them. 
-            # These are the columns causing the 177007... overflow error.
-            cols_to_drop = ["datetime_start", "datetime_complete", "duration"]
-            df.drop(columns=[c for c in cols_to_drop if c in df.columns], inplace=True)
-            
-            # 4. Force everything else to Numeric
-            # If it can't be a number, coerce it to NaN, then drop the column if it's all NaN
-            df = df.apply(pd.to_numeric, errors='coerce')
-            df = df.dropna(axis=1, how='all') # Drop columns that failed completely (like 'state' string)
-            df = df.dropna(subset=["Lap Time"]) # Drop rows with no result
-            
-            all_dfs.append(df)
-        
-        if not all_dfs:
-            return pd.DataFrame()
-            
-        return pd.concat(all_dfs, ignore_index=True)
-
+        return get_study_cache(os.path.abspath(db_path)).load(selected_mode)
     except Exception as e:
         st.error(f"Error loading database: {e}")
         return pd.DataFrame()
 
+def render_live():
+    """Last frame of every running CarMaker instance, read from shared memory."""
+    state = st.session_state
+    if "live_readers" not in state or st.button("🔍 Rescan"):
+        state.live_readers = discover(TELEMETRY_PREFIX, TELEMETRY_PORTS)
+        state.live_history = {}
+
+    if not state.live_readers:
+        st.info("No running CarMaker instance with live telemetry.")
+        return
+
+    for r in state.live_readers:
+        f = r.read()
+        if f is None:
+            st.caption(f"{r.name}: waiting for data")
+            continue
+
+        hist = state.live_history.setdefault(r.name, {})
+        if hist.get("_run") != f["run"]:
+            hist.clear() # new TestRun
+            hist["_run"] = f["run"]
+        hist.setdefault("time", deque(maxlen=LIVE_HISTORY)).append(f["time"])
+        for name, val in f["values"].items():
+            hist.setdefault(name, deque(maxlen=LIVE_HISTORY)).append(val)
+
+        status = "🟢 simulating" if f["simulating"] else "⚪ idle"
+        st.markdown(f"**{r.name}**: trial `{f['tag'] or '-'}`, run {f['run']}, {status}, t = {f['time']:.1f} s")
+        names = list(f["values"])
+        cols = st.columns(max(1, len(names)))
+        for col, name in zip(cols, names):
+            col.metric(name, f"{f['values'][name]:.3f}")
+
+        if names and len(hist["time"]) > 1:
+            fig = go.Figure()
+            for name in names:
+                fig.add_trace(go.Scatter(x=list(hist["time"]), y=list(hist[name]), name=name, mode="lines"))
+            fig.update_layout(template="plotly_dark", height=250, margin=dict(l=0, r=0, t=10, b=0))
+            st.plotly_chart(fig, use_container_width=True)
+
 # --- SIDEBAR ---
 st.sidebar.title(f"🛠️ {PAGE_TITLE}")
 campaigns = get_campaigns()
@@ -106,12 +125,21 @@ db_path = os.path.join(BASE_OUTPUT_DIR, selected_campaign, "optimization.db")
 
 st.sidebar.markdown("---")
 mode = st.sidebar.radio("Optimization Mode", ["Dynamics", "Kinematics"])
+live = st.sidebar.toggle("📡 Live Telemetry", value=False)
+
+if live:
+    st.markdown("### Live Workers")
+    render_live()
+    st.markdown("---")
 
 # --- DATA LOADING ---
 df = load_study_data(db_path, mode)
 
 if df.empty:
     st.warning(f"⚠️ No completed trials found for **{mode}**.")
+    if live:
+        time.sleep(LIVE_REFRESH)
+        st.rerun()
     st.stop()
 
 # Determine Parameters (Anything that isn't metadata)
@@ -177,4 +205,8 @@ with tab3:
             color_continuous_scale="Plasma_r"
         )
         fig_par.update_layout(template="plotly_dark", height=500)
-        st.plotly_chart(fig_par, use_container_width=True)
\ No newline at end of file
+        st.plotly_chart(fig_par, use_container_width=True)
+
+if live:
+    time.sleep(LIVE_REFRESH)
+    st.rerun()
@@ -0,0 +1,159 @@
+import json
+import os
+import sqlite3
+import threading
+
+import numpy as np
+import pandas as pd
+
+
+class StudyCache:
+    """
+    Incremental reader of the optuna SQLite storage for the dashboard.
+
+    Opens the database read-only and reads the optuna tables directly
+    (studies, trials, trial_values, trial_params, trial_user_attributes).
+    Per study it remembers the highest trial_id seen and the trials that
+    were still running, so a refresh only fetches trials that are new or
+    have finished since. Finished trials are kept as one float64 frame per
+    study: 'number', 'Lap Time', the parameters and the numeric user attrs.
+
+    Parameters are the internal optuna representation, i.e. the value
+    itself for float / int distributions.
+
+    The KPIs of the write-behind TrialStore (trial_results table) are
+    merged in by number; they are read by rowid, so only rows committed
+    since the last refresh are fetched, also for trials already cached.
+    """
+    FINISHED = "COMPLETE"
+    UNFINISHED = ("RUNNING", "WAITING")
+    CHUNK = 500 # ids per IN (...), below SQLITE_MAX_VARIABLE_NUMBER
+
+    def __init__(self, db_path):
+        self.db_path = os.path.abspath(db_path)
+        self._lock = threading.Lock()
+        self._studies = {} # study_id -> per-study state
+        self._results_rowid = 0
+        self._results = {} # study_name -> {number: {key: value}}
+
+    def _connect(self):
+        # Read-only, never takes a write lock against the optimizer
+        uri = f"file:{self.db_path}?mode=ro"
+        return sqlite3.connect(uri, uri=True, timeout=1.0, check_same_thread=False)
+
+    def load(self, name_filter=""):
+        """Finished trials of all studies whose name contains name_filter (case-insensitive)."""
+        with self._lock:
+            if not os.path.exists(self.db_path):
+                return pd.DataFrame()
+            con = self._connect()
+            try:
+                self._refresh(con)
+            finally:
+                con.close()
+
+            frames = [s["frame"] for s in self._studies.values()
+                      if name_filter.lower() in s["name"].lower() and len(s["frame"])]
+        if not frames:
+            return pd.DataFrame()
+        df = pd.concat(frames, ignore_index=True).dropna(axis=1, how="all")
+        if "Lap Time" not in df.columns:
+            return pd.DataFrame()
+        return df.dropna(subset=["Lap Time"])
+
+    def _refresh(self, con):
+        new_results = self._read_results(con)
+        for study_id, name in con.execute("SELECT study_id, study_name FROM studies"):
+            s = self._studies.setdefault(study_id, {"name": name, "max_id": 0, "pending": set(),
+                                                     "frame": pd.DataFrame()})
+            self._update_study(con, study_id, s)
+            self._patch_results(s, new_results.get(name, {}))
+
+    def _read_results(self, con):
+        """Rows committed to trial_results since the last refresh, {study: {number: {key: value}}}."""
+        new = {}
+        try:
+            rows = con.execute("SELECT rowid, study_name, number, key, value FROM trial_results "
+                               "WHERE rowid > ?", (self._results_rowid,)).fetchall()
+        except sqlite3.OperationalError:
+            return new # no TrialStore yet
+        for rowid, study, number, key, value in rows:
+            self._results_rowid = max(self._results_rowid, rowid)
+            self._results.setdefault(study, {}).setdefault(number, {})[key] = value
+            new.setdefault(study, {}).setdefault(number, {})[key] = value
+        return new
+
+    @staticmethod
+    def _patch_results(s, new):
+        """Results that arrived for trials that are already in the frame."""
+        if not new or s["frame"].empty:
+            return
+        rows = {n: i for i, n in enumerate(s["frame"]["number"].tolist())}
+        for number, values in new.items():
+            if number in rows:
+                for key, value in values.items():
+                    s["frame"].at[rows[number], key] = value
+
+    def _update_study(self, con, study_id, s):
+        rows = con.execute("SELECT trial_id, state FROM trials WHERE study_id = ? AND trial_id > ?",
+                           (study_id, s["max_id"])).fetchall()
+        for ids in self._chunks(sorted(s["pending"])):
+            marks = ",".join("?" * len(ids))
+            rows += con.execute(f"SELECT trial_id, state FROM trials WHERE trial_id IN ({marks})", ids).fetchall()
+
+        done = []
+        for trial_id, state in rows:
+            s["max_id"] = max(s["max_id"], trial_id)
+            if state == self.FINISHED:
+                done.append(trial_id)
+                s["pending"].discard(trial_id)
+            elif state in self.UNFINISHED:
+                s["pending"].add(trial_id)
+            else:
+                s["pending"].discard(trial_id) # FAIL / PRUNED
+
+        if done:
+            results = self._results.get(s["name"], {})
+            new = [self._fetch(con, ids, results) for ids in self._chunks(done)]
+            if not s["frame"].empty:
+                new.insert(0, s["frame"])
+            s["frame"] = pd.concat(new, ignore_index=True)
+
+    @classmethod
+    def _chunks(cls, ids):
+        return [tuple(ids[i:i + cls.CHUNK]) for i in range(0, len(ids), cls.CHUNK)]
+
+    def _fetch(self, con, ids, results):
+        """Typed frame of the given finished trials."""
+        marks = ",".join("?" * len(ids))
+        row_of = {tid: i for i, tid in enumerate(ids)}
+        cols = {}
+
+        def column(name):
+            if name not in cols:
+                cols[name] = np.full(len(ids), np.nan)
+            return cols[name]
+
+        for tid, number in con.execute(f"SELECT trial_id, number FROM trials WHERE trial_id IN ({marks})", ids):
+            column("number")[row_of[tid]] = number
+        for tid, value in con.execute(f"SELECT trial_id, value FROM trial_values "
+                                      f"WHERE objective = 0 AND trial_id IN ({marks})", ids):
+            if value is not None:
+                column("Lap Time")[row_of[tid]] = value
+        for tid, name, value in con.execute(f"SELECT trial_id, param_name, param_value FROM trial_params "
+                                            f"WHERE trial_id IN ({marks})", ids):
+            column(name)[row_of[tid]] = value
+        for tid, key, value_json in con.execute(f"SELECT trial_id, key, value_json FROM trial_user_attributes "
+                                                f"WHERE trial_id IN ({marks})", ids):
+            try:
+                value = json.loads(value_json)
+            except ValueError:
+                continue
+            if isinstance(value, (int, float)) and not isinstance(value, bool):
+                column(key)[row_of[tid]] = value
+
+        for tid, number in zip(ids, column("number").tolist()):
+            for key, value in results.get(int(number), {}).items():
+                column(key)[row_of[tid]] = value
+
+        return pd.DataFrame(cols)
@@ -0,0 +1,209 @@
+import os
+import glob
+import logging
+import numpy as np
+import pandas as pd
+from concurrent.futures import ProcessPoolExecutor
+from scipy.fft import rfft, irfft, next_fast_len
+from scipy.signal import welch
+
+from src.database.data_handler import BINEXPORT_EXT, FAIL_KPIS, load_binexport
+
+logger = logging.getLogger("CampaignKPIs")
+
+# Channels read by ResultHandler.process_results()
+CHANNELS = ['Time', 'Car.Steer.WhlAngle', 'Car.v', 'Car.YawRate', 'Car.Fr1.Ay', 'Car.Roll']
+SIDESLIP = 'Car.SideSlip'
+
+
+def find_runs(campaign_dir):
+    """
+    (run_id, file) for every Trial_* folder of a campaign.
+    Prefers the binary export (results.cmbx), falls back to an ERG file.
+    """
+    runs = []
+    for folder in sorted(glob.glob(os.path.join(campaign_dir, "Trial_*"))):
+        files = glob.glob(os.path.join(folder, "*" + BINEXPORT_EXT)) or glob.glob(os.path.join(folder, "*.erg"))
+        if files:
+            runs.append((os.path.basename(folder), files[0]))
+    return runs
+
+
+def _load_run(path):
+    if path.endswith(BINEXPORT_EXT):
+        df = load_binexport(path)
+    else:
+        df = pd.read_csv(path, encoding='iso-8859-1', delim_whitespace=True, skiprows=[1])
+    run = {c: np.asarray(df[c].values, dtype=np.float64) for c in CHANNELS}
+    run[SIDESLIP] = np.asarray(df[SIDESLIP].values, dtype=np.float64) if SIDESLIP in df.columns else None
+    if len(run['Time']) < 3:
+        raise ValueError("run too short")
+    return run
+
+
+def _pad(runs, key, n_max):
+    out = np.zeros((len(runs), n_max))
+    for i, r in enumerate(runs):
+        out[i, :len(r[key])] = r[key]
+    return out
+
+
+def _bandwidth(steer, yaw, lengths, dts):
+    """
+    ResultHandler._calculate_frequency_response() for many runs.
+    One welch() call per (length, dt) group, steer and yaw rows stacked.
+    """
+    bw = np.zeros(len(lengths))
+    groups = {}
+    for i, (n, dt) in enumerate(zip(lengths, dts)):
+        groups.setdefault((n, round(dt, 9)), []).append(i)
+
+    for (n, dt), idx in groups.items():
+        if dt <= 0:
+            continue
+        rows = np.vstack([steer[idx, :n], yaw[idx, :n]])
+        f, pxx = welch(rows, 1.0 / dt, nperseg=256, axis=-1)
+        p_steer, p_yaw = pxx[:len(idx)], pxx[len(idx):]
+
+        mag = np.sqrt(p_yaw) / (np.sqrt(p_steer) + 1e-9)
+        dc_gain = np.mean(mag[:, :5], axis=1)
+        ok = dc_gain >= 1e-6
+        below = mag / np.where(ok, dc_gain, 1.0)[:, None] < 0.707
+        first = np.where(below.any(axis=1), below.argmax(axis=1), len(f) - 1)
+        bw[idx] = np.where(ok, f[first], 0.0)
+    return bw
+
+
+def batch_kpis(runs):
+    """
+    KPIs of ResultHandler.process_results() for a list of loaded runs in one
+    vectorized pass. Runs are zero-padded to a common length, every sum is
+    masked to the valid samples, and the steer/yaw cross-correlation is done
+    with one FFT of the whole block instead of np.correlate(mode='full').
+    """
+    lengths = np.array([len(r['Time']) for r in runs])
+    n_max = int(lengths.max())
+    valid = np.arange(n_max)[None, :] < lengths[:, None]
+    last = lengths - 1
+    rows = np.arange(len(runs))
+
+    t = _pad(runs, 'Time', n_max)
+    steer = _pad(runs, 'Car.Steer.WhlAngle', n_max)
+    speed = _pad(runs, 'Car.v', n_max)
+    yaw = _pad(runs, 'Car.YawRate', n_max)
+    lat_acc = _pad(runs, 'Car.Fr1.Ay', n_max)
+    roll = _pad(runs, 'Car.Roll', n_max)
+
+    lap_time = np.where(speed[rows, last] > 1.0, t[rows, last], 999.0)
+    max_roll = np.max(np.abs(roll), axis=1)
+
+    # --- A. Understeer gradient: closed-form least squares on masked moments ---
+    mask = valid & (speed > 10.0) & (np.abs(lat_acc) > 5.0)
+    n_c = mask.sum(axis=1)
+    x = np.where(mask, lat_acc / 9.81, 0.0)
+    y = np.where(mask, steer * 57.296, 0.0)
+    sx, sy = x.sum(axis=1), y.sum(axis=1)
+    sxx, sxy = (x * x).sum(axis=1), (x * y).sum(axis=1)
+    den = n_c * sxx - sx * sx
+    with np.errstate(divide='ignore', invalid='ignore'):
+        understeer = np.where((n_c > 50) & (den > 0), (n_c * sxy - sx * sy) / den, 0.0)
+
+    # --- Steering statistics (shared by RMS and correlation) ---
+    mean_s = steer.sum(axis=1) / lengths
+    std_s = np.sqrt((np.where(valid, steer - mean_s[:, None], 0.0) ** 2).sum(axis=1) / lengths)
+    mean_y = yaw.sum(axis=1) / lengths
+    std_y = np.sqrt((np.where(valid, yaw - mean_y[:, None], 0.0) ** 2).sum(axis=1) / lengths)
+
+    # --- B. Response lag: FFT cross-correlation, same lag convention as np.correlate ---
+    s_norm = np.where(valid, (steer - mean_s[:, None]) / (std_s[:, None] + 1e-6), 0.0)
+    y_norm = np.where(valid, (yaw - mean_y[:, None]) / (std_y[:, None] + 1e-6), 0.0)
+    nfft = next_fast_len(2 * n_max - 1)
+    corr = irfft(rfft(s_norm, nfft, axis=1) * np.conj(rfft(y_norm, nfft, axis=1)), nfft, axis=1)
+    lags = np.arange(-n_max + 1, n_max)
+    corr = corr[:, lags % nfft]
+    corr[np.abs(lags)[None, :] > last[:, None]] = -np.inf
+    lag_idx = lags[np.argmax(corr, axis=1)]
+    dt = t[:, 1] - t[:, 0]
+    response_lag = np.maximum(0.0, lag_idx * dt * 1000.0)
+
+    # --- C. Bandwidth: shared Welch for steer and yaw ---
+    dts = np.array([np.mean(np.diff(r['Time'])) for r in runs])
+    yaw_bandwidth = _bandwidth(steer, yaw, lengths, dts)
+
+    # --- D. Stability index ---
+    stability = np.ones(len(runs))
+    for i, r in enumerate(runs):
+        if r[SIDESLIP] is None:
+            continue
+        m = mask[i, :lengths[i]]
+        if m.any():
+            beta_rate = np.gradient(r[SIDESLIP], r['Time'])
+            stability[i] = max(0.0, 1.0 - np.mean(np.abs(beta_rate[m])) * 5.0)
+
+    return [{
+        "cost": float(lap_time[i]),
+        "max_roll": float(max_roll[i]),
+        "understeer_grad": float(understeer[i]),
+        "stability_index": float(stability[i]),
+        "response_lag": float(response_lag[i]),
+        "yaw_bandwidth": float(yaw_bandwidth[i]),
+        "steering_rms": float(std_s[i]),
+    } for i in range(len(runs))]
+
+
+def _process_chunk(chunk):
+    """Worker: load a chunk of runs and compute their KPIs together."""
+    loaded, ids, rows = [], [], []
+    for run_id, path in chunk:
+        try:
+            loaded.append(_load_run(path))
+            ids.append(run_id)
+        except Exception as e:
+            rows.append({"run_id": run_id, **FAIL_KPIS, "error": str(e)})
+
+    if loaded:
+        try:
+            kpis = batch_kpis(loaded)
+            rows.extend({"run_id": run_id, **k, "error": ""} for run_id, k in zip(ids, kpis))
+        except Exception as e:
+            rows.extend({"run_id": run_id, **FAIL_KPIS, "error": str(e)} for run_id in ids)
+    return rows
+
+
+def process_campaign(campaign_dir, n_jobs=None, chunk_size=16, out_name="campaign_kpis.parquet"):
+    """
+    Computes the KPIs of every trial in a Campaign_* folder and writes one
+    table, <campaign_dir>/campaign_kpis.parquet. Chunks of runs are spread
+    over n_jobs processes (default: all cores).
+    """
+    runs = find_runs(campaign_dir)
+    if not runs:
+        logger.warning(f"No trial results found in {campaign_dir}")
+        return pd.DataFrame()
+
+    chunks = [runs[i:i + chunk_size] for i in range(0, len(runs), chunk_size)]
+    n_jobs = n_jobs or os.cpu_count() or 1
+
+    rows = []
+    if n_jobs == 1 or len(chunks) == 1:
+        for chunk in chunks:
+            rows.extend(_process_chunk(chunk))
+    else:
+        with ProcessPoolExecutor(max_workers=min(n_jobs, len(chunks))) as pool:
+            for part in pool.map(_process_chunk, chunks):
+                rows.extend(part)
+
+    table = pd.DataFrame(rows).sort_values("run_id").reset_index(drop=True)
+    out_path = os.path.join(campaign_dir, out_name)
+    table.to_parquet(out_path)
+    logger.info(f"📊 {len(table)} runs -> {out_path} ({(table['error'] != '').sum()} failed)")
+    return table
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser(description="Batch KPI table for a whole campaign")
+    parser.add_argument("campaign_dir")
+    parser.add_argument("-j", "--jobs", type=int, default=None)
+    args = parser.parse_args()
+    process_campaign(args.campaign_dir, n_jobs=args.jobs)
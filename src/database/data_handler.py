@@ -6,10 +6,51 @@ from typing import Dict
 from scipy.signal import savgol_filter, welch
 from scipy.stats import linregress
 
+from src.utils.timing import spans
+
 # Setup Logging
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - [DATA] - %(message)s')
 logger = logging.getLogger(__name__)
 
+# Default "Fail" KPIs
+FAIL_KPIS = {
+    "cost": float('inf'), 
+    "max_roll": 99.0, 
+    "stability_index": 0.0, 
+    "understeer_grad": 0.0, 
+    "response_lag": 100.0, 
+    "yaw_bandwidth": 0.0, # Gen 5.0 Metric
+    "steering_rms": 0.0
+}
+
+# Binary export written by the CM4SL app (BinExport.c)
+BINEXPORT_EXT = ".cmbx"
+BINEXPORT_NAMELEN = 64
+
+def load_binexport(path: str) -> pd.DataFrame:
+    """
+    Opens a BinExport file zero-copy: the DataFrame columns are views
+    into a read-only np.memmap of the float32[nRows][nChannels] block.
+    """
+    hdr = np.fromfile(path, dtype='<u4', count=8)
+    if len(hdr) < 8 or hdr[:1].tobytes() != b"CMBX":
+        raise ValueError(f"{path} is not a BinExport file")
+    n_chan, n_rows, offset = int(hdr[2]), int(hdr[3]), int(hdr[4])
+
+    with open(path, 'rb') as f:
+        f.seek(32)
+        raw = f.read(n_chan * BINEXPORT_NAMELEN)
+    names = [raw[i:i + BINEXPORT_NAMELEN].split(b"\0", 1)[0].decode('ascii', errors='ignore')
+             for i in range(0, len(raw), BINEXPORT_NAMELEN)]
+
+    if n_rows == 0:
+        n_rows = (os.path.getsize(path) - offset) // (4 * n_chan)
+    if n_rows <= 0:
+        return pd.DataFrame(columns=names, dtype=np.float32)
+
+    data = np.memmap(path, dtype='<f4', mode='r', offset=offset, shape=(n_rows, n_chan))
+    return pd.DataFrame(data, columns=names, copy=False)
+
 class ResultHandler:
     """
     GEN 5.0 DATA INGESTION ENGINE.
@@ -26,35 +67,42 @@ class ResultHandler:
         
     def process_results(self, run_id: str, erg_file_path: str) -> Dict[str, float]:
         """
-        Ingests simulation output, converts to optimized Parquet, 
-        and calculates Engineering KPIs.
+        Ingests simulation output (ERG or BinExport .cmbx), converts ERG
+        to optimized Parquet, and calculates Engineering KPIs.
+        
+        Optimizer trials get the same KPIs streamed from the app (KPI.c,
+        see ResultListener.to_kpis); this is the offline / bandwidth path.
         """
+        with spans.span("erg_parse"):
+            return self._process_results(run_id, erg_file_path)
+
+    def _process_results(self, run_id: str, erg_file_path: str) -> Dict[str, float]:
         # Default "Fail" KPIs
-        fail_kpis = {
-            "cost": float('inf'), 
-            "max_roll": 99.0, 
-            "stability_index": 0.0, 
-            "understeer_grad": 0.0, 
-            "response_lag": 100.0, 
-            "yaw_bandwidth": 0.0, # Gen 5.0 Metric
-            "steering_rms": 0.0
-        }
+        fail_kpis = dict(FAIL_KPIS)
 
         if not os.path.exists(erg_file_path):
             return fail_kpis
 
         try:
-            # 1. READ DATA (Robust handling for CarMaker ASCII)
-            try:
-                # Skip the first few header lines usually found in ERG files
-                df = pd.read_csv(erg_file_path, encoding='iso-8859-1', delim_whitespace=True, skiprows=[1])
-            except Exception as e:
-                logger.error(f"Could not parse ERG file {erg_file_path}: {e}")
-                return fail_kpis
+            if erg_file_path.endswith(BINEXPORT_EXT):
+                # 1+2. BINARY EXPORT: memory-mapped, already compact -> no Parquet copy
+                try:
+                    df = load_binexport(erg_file_path)
+                except Exception as e:
+                    logger.error(f"Could not open export {erg_file_path}: {e}")
+                    return fail_kpis
+            else:
+                # 1. READ DATA (Robust handling for CarMaker ASCII)
+                try:
+                    # Skip the first few header lines usually found in ERG files
+                    df = pd.read_csv(erg_file_path, encoding='iso-8859-1', delim_whitespace=True, skiprows=[1])
+                except Exception as e:
+                    logger.error(f"Could not parse ERG file {erg_file_path}: {e}")
+                    return fail_kpis
 
-            # 2. SAVE AS PARQUET (Fast access for Dashboard)
-            parquet_path = os.path.join(self.storage_path, f"{run_id}.parquet")
-            df.to_parquet(parquet_path)
+                # 2. SAVE AS PARQUET (Fast access for Dashboard)
+                parquet_path = os.path.join(self.storage_path, f"{run_id}.parquet")
+                df.to_parquet(parquet_path)
 
             # 3. EXTRACT CHANNELS (Standard CarMaker Naming)
             # Ensure these match your specific CarMaker OutputQuantities!
@@ -137,6 +185,14 @@ class ResultHandler:
             logger.error(f"KPI Calc Failed for {run_id}: {e}")
             return fail_kpis
 
+    def process_campaign(self, campaign_dir: str, n_jobs=None) -> pd.DataFrame:
+        """
+        Batch mode: KPIs of every trial of a Campaign_* folder in vectorized
+        chunks over all cores, written as one campaign_kpis.parquet table.
+        """
+        from src.database.campaign_kpis import process_campaign
+        return process_campaign(campaign_dir, n_jobs=n_jobs)
+
     def _calculate_frequency_response(self, time, steer, yaw_rate):
         """
         GEN 5.0 EXCLUSIVE: BODE PLOT GENERATOR.
@@ -0,0 +1,87 @@
+import hashlib
+import json
+import logging
+import sqlite3
+import threading
+import time
+
+logger = logging.getLogger("ResultCache")
+
+
+class ResultCache:
+    """
+    Content-addressed cache of run_test() results, shared by all workers
+    and campaigns (Output/result_cache.db).
+
+    The key is a hash of what the simulation actually gets: the values
+    written into the vehicle (ParameterManager.fingerprint(), after
+    PARAM_MAP and formatting) and the TestRun keys that change the run
+    (CarMakerInterface.result_fingerprint()), each with the hash of its
+    template. Setups TPE proposes that only differ below the written
+    precision, or in parameters that aren't injected, hit the same entry.
+
+    Only results that don't depend on the state of the campaign are
+    stored: complete runs and runs stopped by the car itself (spin,
+    stall, off track) or at a screening horizon. A stop against the
+    current best lap time (Prune 'slow') and crashes without a result
+    are simulated again.
+    """
+    CACHED_STOPS = ("spin", "stall", "off track", "horizon")
+
+    def __init__(self, db_path):
+        self.db_path = db_path
+        self._local = threading.local()
+        self.hits = 0
+        self.misses = 0
+        con = self._con()
+        with con:
+            con.execute("CREATE TABLE IF NOT EXISTS results ("
+                        "key TEXT PRIMARY KEY, result TEXT NOT NULL, created REAL)")
+
+    def _con(self):
+        con = getattr(self._local, "con", None)
+        if con is None:
+            con = self._local.con = sqlite3.connect(self.db_path, timeout=30.0)
+            con.execute("PRAGMA journal_mode=WAL") # campaigns in parallel
+        return con
+
+    @staticmethod
+    def key(*parts):
+        """Hash of JSON-serializable fingerprints."""
+        data = json.dumps(parts, sort_keys=True, separators=(",", ":"), default=str)
+        return hashlib.sha256(data.encode("utf-8")).hexdigest()
+
+    def get(self, key):
+        """Stored result (with 'cached': True), None on a miss."""
+        try:
+            row = self._con().execute("SELECT result FROM results WHERE key = ?", (key,)).fetchone()
+        except sqlite3.Error as e:
+            logger.warning(f"Cache lookup failed: {e}")
+            row = None
+        if row is None:
+            self.misses += 1
+            return None
+        self.hits += 1
+        result = json.loads(row[0])
+        result['cached'] = True
+        return result
+
+    @classmethod
+    def cacheable(cls, result):
+        if result.get('status') == 'Complete':
+            return True
+        return result.get('status') == 'Stopped' and result.get('stop_reason') in cls.CACHED_STOPS
+
+    def put(self, key, result):
+        """Stores the result if it is cacheable; True if stored."""
+        if not self.cacheable(result):
+            return False
+        try:
+            con = self._con()
+            with con:
+                con.execute("INSERT OR REPLACE INTO results VALUES (?, ?, ?)",
+                            (key, json.dumps(result, default=float), time.time()))
+        except (sqlite3.Error, TypeError, ValueError) as e:
+            logger.warning(f"Cache store failed: {e}")
+            return False
+        return True
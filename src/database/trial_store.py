@@ -0,0 +1,158 @@
+import glob
+import json
+import logging
+import os
+import queue
+import sqlite3
+import threading
+import time
+
+logger = logging.getLogger("TrialStore")
+
+
+class TrialStore:
+    """
+    Write-behind store for the per-trial results (KPIs, start time, ...)
+    that used to be written as optuna user attrs, one SQLite transaction
+    each, from every worker.
+
+    append() never touches the database: the record goes to the log
+    (<campaign>/trial_log_<k>.jsonl, one per process, shared by all
+    worker threads) and into a queue.
+    One writer thread commits the queue in batches, a single transaction
+    per batch, to the 'trial_results' table of optimization.db:
+        trial_results(study_name, number, key, value)
+    A batch is written when BATCH_SIZE records are queued or FLUSH_INTERVAL
+    seconds have passed. On start the logs are replayed (idempotent), so
+    records queued when the process died are not lost.
+
+    Read by the dashboard (StudyCache) together with the optuna tables.
+    """
+    BATCH_SIZE = 64
+    FLUSH_INTERVAL = 2.0 # s
+    LOG_PATTERN = "trial_log_*.jsonl"
+
+    def __init__(self, campaign_folder, db_file="optimization.db"):
+        self.folder = campaign_folder
+        self.db_path = os.path.join(campaign_folder, db_file)
+        self._queue = queue.Queue()
+        self._log_lock = threading.Lock()
+        self._log_file = None
+        self._n_logs = 0
+        self.n_committed = 0
+        self.failed = False
+
+        con = self._connect()
+        try:
+            con.execute("CREATE TABLE IF NOT EXISTS trial_results ("
+                        "study_name TEXT NOT NULL, number INTEGER NOT NULL, key TEXT NOT NULL, value REAL, "
+                        "PRIMARY KEY (study_name, number, key))")
+            self._commit(con, self._replay())
+        finally:
+            con.close()
+
+        self._writer = None
+
+    def _connect(self):
+        con = sqlite3.connect(self.db_path, timeout=30.0)
+        con.execute("PRAGMA journal_mode=WAL") # readers (dashboard) don't block the writer
+        return con
+
+    def append(self, study_name, number, values):
+        """Queues {key: number} of one trial. Non-numeric values are skipped."""
+        rows = [(study_name, int(number), str(k), float(v)) for k, v in values.items()
+                if isinstance(v, (int, float)) and not isinstance(v, bool)]
+        if not rows:
+            return
+        self._log(rows)
+        with self._log_lock:
+            if self._writer is None:
+                # Started on first use, again after close()
+                self._writer = threading.Thread(target=self._run, name="TrialStore", daemon=True)
+                self._writer.start()
+        for row in rows:
+            self._queue.put(row)
+
+    def _log(self, rows):
+        # optuna starts a new thread pool per optimize() call, so the log is
+        # shared rather than one per thread; a trial only writes a few rows
+        with self._log_lock:
+            if self._log_file is None:
+                path = os.path.join(self.folder, f"trial_log_{self._n_logs}.jsonl")
+                self._n_logs += 1
+                self._log_file = open(path, "a", encoding="utf-8")
+            self._log_file.write("".join(json.dumps(row) + "\n" for row in rows))
+            self._log_file.flush()
+
+    def _replay(self):
+        rows = []
+        for path in glob.glob(os.path.join(self.folder, self.LOG_PATTERN)):
+            self._n_logs = max(self._n_logs, self._log_index(path) + 1)
+            try:
+                with open(path, "r", encoding="utf-8") as f:
+                    for line in f:
+                        try:
+                            rows.append(tuple(json.loads(line)))
+                        except ValueError:
+                            continue # Torn last line
+            except OSError:
+                continue
+        if rows:
+            logger.info(f"Replaying {len(rows)} logged trial result(s)")
+        return rows
+
+    @staticmethod
+    def _log_index(path):
+        try:
+            return int(os.path.basename(path)[len("trial_log_"):-len(".jsonl")])
+        except ValueError:
+            return 0
+
+    def _commit(self, con, rows):
+        if not rows:
+            return
+        with con: # one transaction
+            con.executemany("INSERT OR REPLACE INTO trial_results VALUES (?, ?, ?, ?)", rows)
+        self.n_committed += len(rows)
+
+    def _run(self):
+        con = self._connect()
+        stop = False
+        try:
+            while not stop:
+                batch = []
+                deadline = time.time() + self.FLUSH_INTERVAL
+                while len(batch) < self.BATCH_SIZE:
+                    try:
+                        row = self._queue.get(timeout=max(0.0, deadline - time.time()))
+                    except queue.Empty:
+                        break
+                    if row is None: # close()
+                        stop = True
+                        break
+                    batch.append(row)
+                try:
+                    self._commit(con, batch)
+                except sqlite3.Error as e:
+                    # Still in the logs, replayed on the next start
+                    logger.error(f"Commit of {len(batch)} trial result(s) failed: {e}")
+                    self.failed = True
+        finally:
+            con.close()
+
+    def close(self):
+        """Commits everything queued, stops the writer and drops the logs once all is in the database."""
+        with self._log_lock:
+            writer, self._writer = self._writer, None
+            if writer is not None:
+                self._queue.put(None)
+                writer.join()
+            if self._log_file is not None:
+                self._log_file.close()
+                self._log_file = None
+        if not self.failed:
+            for path in glob.glob(os.path.join(self.folder, self.LOG_PATTERN)):
+                try:
+                    os.remove(path)
+                except OSError:
+                    pass
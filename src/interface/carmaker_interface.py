@@ -1,25 +1,143 @@
+import copy
+import hashlib
 import os
 import shutil
 import subprocess
 import logging
+import threading
 import time
 import glob
 import re
 
-class CarMakerInterface:
+from src.interface.session_pool import CarMakerSessionError
+from src.interface.result_listener import ResultListener
+from src.core.parameter_manager import CompiledTemplate
+from src.utils.timing import spans
+
+class WarmBaseline:
+    """
+    Baseline snapshot of the warm start, shared by an interface and its
+    clones: taken by the first worker that needs it, the others wait for it.
+    """
     def __init__(self):
+        self.lock = threading.Lock()
+        self.key = None   # (base vehicle digest, settle time) of the snapshot
+        self.value = None # (base vehicle blocks, snapshot blocks, snapshot digest), False = failed
+
+class CarMakerInterface:
+    # Settings that decide what a trial simulates, copied to every worker (clone())
+    CONFIG = ("CM_EXEC", "PROJECT_DIR", "TEMPLATE_TESTRUN", "USER_FOLDER", "HEADLESS",
+              "RESULT_QUANTITIES", "WRITE_ERG", "EXPORT_QUANTITIES", "EXPORT_DECIMATE",
+              "SENSOR_RATES", "SENSOR_PARALLEL", "MODEL_RATES", "WARM_START", "WARM_SETTLE_TIME",
+              "WARM_BASE_VEHICLE", "FORK_QUANTITIES", "HOT_PARAMS", "KEEP_ENV", "TELEMETRY",
+              "TELEMETRY_QUANTITIES", "TELEMETRY_CYCLES")
+
+    def __init__(self, session_pool=None, scratch_dir=None):
         self.logger = logging.getLogger("CM_Interface")
         print("\n   [INFO] Loaded DIAGNOSTIC Interface (v8.0 - Humanized Driver & Soft Penalties)\n")
         
         self.CM_EXEC = r"C:\IPG\carmaker\win64-14.1\bin\CM_Office.exe"
         self.PROJECT_DIR = r"C:\Users\eracing\Desktop\CAR_MAKER\FS_race"
         self.TEMPLATE_TESTRUN = "Competition/FS_SkidPad"
+        self._testrun_tpl = None # CompiledTemplate of TEMPLATE_TESTRUN
         self.USER_FOLDER = "u2000873"
 
+        # Persistent CM_Office instances (None = kill-and-relaunch per trial)
+        self.session_pool = session_pool
+        
+        # Headless batch mode of the CM4SL app (CM_HEADLESS=1 in the environment of
+        # CM_Office): no IPG Movie unless the vehicle has GPU sensors
+        self.HEADLESS = True
+        
+        # Where this interface writes its Tcl script and debug log.
+        # Parallel workers each get their own folder from ResourceManager.
+        self.scratch_dir = scratch_dir or self.PROJECT_DIR
+        
+        # End-of-run KPIs are pushed by the CM4SL app (ResultLink) to this socket.
+        # Extra DDict quantities to report besides Time / Vhcl.Distance:
+        self.result_listener = ResultListener()
+        self.RESULT_QUANTITIES = []
+        
+        # Handling KPIs arrive with the result message (KPI.c in the CM4SL app),
+        # so the ERG is only needed for offline analysis (ResultHandler).
+        self.WRITE_ERG = True
+        
+        # Binary columnar export (BinExport.c) -> <trial folder>/results.cmbx,
+        # read zero-copy by data_handler.load_binexport().
+        # ResultHandler channels + SystemIdentifier target channels.
+        self.EXPORT_QUANTITIES = ['Car.Steer.WhlAngle', 'Car.v', 'Car.YawRate', 'Car.Fr1.Ay',
+                                  'Car.Roll', 'Car.SideSlip', 'Car.ax', 'Car.ay']
+        self.EXPORT_DECIMATE = 10 # every 10th cycle (100 Hz)
+        
+        # Sensor update rates in Hz (SensorSched.c), e.g. {'LineSensor': 100}.
+        # Sensors the vehicle doesn't have are never called anyway.
+        self.SENSOR_RATES = {}
+        # Parallel sensor stage, needs the app started with -sensorthreads <n>
+        self.SENSOR_PARALLEL = False
+        
+        # Rates of the RTW-built controller models in Hz (MultiRate.c), e.g. {'OPENXWD': 100}
+        self.MODEL_RATES = {}
+        
+        # Warm start (WarmStart.c): one short baseline run of the template vehicle
+        # exports the settled vehicle state as a snapshot data set, later trials
+        # start from it with only the keys that differ from the template replaced.
+        # The baseline is shared with the clones of this interface.
+        self.WARM_START = False
+        self.WARM_SETTLE_TIME = 0.5 # s simulated before the snapshot is taken
+        self.WARM_BASE_VEHICLE = "templates/FSE_AllWheelDrive" # ParameterManager template
+        self._warm = WarmBaseline()
+        # State of the car at a fork point (fork(), ForkSweep), sent with the trunk's result
+        self.FORK_QUANTITIES = ['Vhcl.sRoad', 'Vhcl.tRoad', 'Vhcl.v']
+        
+        # Hot parameter injection (HotParam.c), session pool only: after a cold
+        # first trial a session keeps its TestRun loaded, later trials send only
+        # the keys that differ from that trial's vehicle as an overlay and restart
+        # it (StartSim). The restart reads the files again, with KEEP_ENV not the
+        # road; saved are the LoadTestRun, vehicle copy and TestRun file.
+        self.HOT_PARAMS = False
+        
+        # Persistent environment (EnvKeep.c), session pool only: a session keeps
+        # the road loaded after a trial and reuses it while the Road.* / Env.*
+        # keys of the TestRun stay the same, only the vehicle is rebuilt.
+        self.KEEP_ENV = False
+        
+        # Live telemetry (Telemetry.c): the app publishes these quantities into the
+        # shared memory region CM_TELEMETRY, <prefix>_<cmdport> for pool sessions.
+        # Read by the dashboard (src/interface/telemetry.py), which expects the
+        # prefix "CMTelemetry". None = off.
+        self.TELEMETRY = None
+        self.TELEMETRY_QUANTITIES = ['Car.v', 'Car.YawRate', 'Car.Roll', 'Car.ay', 'Vhcl.Distance']
+        self.TELEMETRY_CYCLES = 10 # every 10th cycle (100 Hz)
+
         if not os.path.exists(self.CM_EXEC):
             print(f"❌ [ERROR] CarMaker not found at: {self.CM_EXEC}")
 
+    def clone(self, scratch_dir=None):
+        """
+        Interface for another worker: the same settings (CONFIG) and session
+        pool, its own result socket and scratch folder.
+        """
+        other = CarMakerInterface(session_pool=self.session_pool, scratch_dir=scratch_dir)
+        other.copy_config(self)
+        other._warm = self._warm
+        return other
+
+    def copy_config(self, src):
+        """Takes the settings of src (CONFIG), e.g. changed on the orchestrator's interface."""
+        for name in self.CONFIG:
+            setattr(self, name, copy.deepcopy(getattr(src, name)))
+
+    def launch_env(self):
+        """Environment for CM_Office and the app it starts."""
+        env = dict(os.environ)
+        if self.HEADLESS:
+            env["CM_HEADLESS"] = "1"
+        if self.TELEMETRY:
+            env["CM_TELEMETRY"] = self.TELEMETRY
+        return env
+
     def kill_carmaker(self):
+        # Movie too in headless mode: the app still starts it for vehicles with GPU sensors
         targets = ['CM_Office.exe', 'Movie.exe', 'ipg-movie.exe', 'wish86.exe']
         for target in targets:
             try:
@@ -28,95 +146,100 @@ class CarMakerInterface:
             except: pass
         time.sleep(1.0)
 
-    def run_test(self, vehicle_path, output_folder, trial_id):
-        self.kill_carmaker() 
-        
-        target_vehicle = f"Optimized_Car_{trial_id}"
-        testrun_name = f"Run_{trial_id}"
+    def run_test(self, vehicle_path, output_folder, trial_id, prune=None, extra_keys=None, tunables=None,
+                 vehicle_keys=None):
+        """
+        prune: optional early-stop thresholds for the app (Prune.c), e.g.
+               {'BestTime': 24.1, 'TotalDist': 75.0, 'MaxSideSlip': 0.35}
+        extra_keys: TestRun keys replacing the template's (baseline snapshot run)
+        tunables: Simulink model parameters (TunBatch.c), {'Tun.<model>.<param>': value},
+                  or other TestRun keys that change per trial
+        vehicle_keys: vehicle blocks {key: lines} replacing those of vehicle_path.
+                  Sent by hot injection only, unless the trial has to be loaded cold.
+        """
+        hot = self.session_pool is not None and self.HOT_PARAMS and extra_keys is None
+        if vehicle_keys and (not hot or self.WARM_START):
+            vehicle_path = self._keyed_vehicle(vehicle_path, vehicle_keys, trial_id)
+            vehicle_keys = None
+
+        if self.WARM_START and extra_keys is None:
+            vehicle_path = self._warm_vehicle(vehicle_path, trial_id)
+
+        if self.session_pool is not None:
+            return self._run_in_session(vehicle_path, output_folder, trial_id, prune, extra_keys, tunables,
+                                        vehicle_keys)
+
+        with spans.span("kill"):
+            self.kill_carmaker() 
         
-        # 1. Copy Vehicle
-        try:
-            vehicle_dir = os.path.join(self.PROJECT_DIR, "Data/Vehicle")
-            os.makedirs(vehicle_dir, exist_ok=True)
-            target_path = os.path.join(vehicle_dir, target_vehicle)
-            shutil.copy(vehicle_path, target_path)
-        except Exception as e:
-            self.logger.error(f"Failed to copy vehicle: {e}")
+        testrun_name = self._prepare_testrun(vehicle_path, trial_id, prune, output_folder, extra_keys, tunables)
+        if testrun_name is None:
             return {'status': 'Crash', 'lap_time': 999, 'distance': 0}
 
-        # 2. Create TestRun with HUMANIZED DRIVER (Fix #3)
-        #  "Humanización del Modelo de Conductor"
-        template_file = os.path.join(self.PROJECT_DIR, "Data/TestRun", self.TEMPLATE_TESTRUN)
-        if not os.path.exists(template_file) and os.path.exists(template_file + ".ts"):
-            template_file += ".ts"
-            
-        testrun_path = os.path.join(self.PROJECT_DIR, "Data/TestRun", f"{testrun_name}.ts")
-        
-        with open(template_file, 'r', encoding='utf-8', errors='ignore') as f: 
-            lines = f.readlines()
-        
-        modified_lines = []
-        for line in lines:
-            if line.strip().startswith("Vehicle ="):
-                modified_lines.append(f"Vehicle = {target_vehicle}\n")
-            elif "SaveConfig" in line:
-                pass # Remove old save configs to overwrite below
-            else:
-                modified_lines.append(line)
-        
-        # Inject Driver Degradation & Output Config
-        modified_lines.append("\n# --- OPTIMIZER INJECTIONS ---\n")
-        modified_lines.append("SaveConfig.Enabled = 1\n")
-        modified_lines.append("SaveConfig.Write.Enabled = 1\n")
-        
-        #  Transport Delay 150-200ms
-        modified_lines.append("Driver.ReactTime = 0.18\n") 
-        # [cite: 535] Neuromuscular Filter (approximate via steering damping/filter)
-        modified_lines.append("DrivMan.Steer.Filter.G = 4.0\n") 
-        
-        with open(testrun_path, 'w', encoding='utf-8') as f:
-            f.writelines(modified_lines)
-                    
         # 3. Generate TCL Script (Headless Execution)
-        tcl_path = os.path.join(self.PROJECT_DIR, "launch_sim.tcl")
-        debug_log = os.path.join(self.PROJECT_DIR, "debug_tcl.txt").replace("\\", "/")
-        
-        tcl_content = f"""
+        # T_<phase> marks (epoch ms) give the phase spans inside CM_Office
+        with spans.span("tcl"):
+            tcl_path = os.path.join(self.scratch_dir, "launch_sim.tcl")
+            debug_log = os.path.join(self.scratch_dir, "debug_tcl.txt").replace("\\", "/")
+            
+            tcl_content = f"""
 set log_fd [open "{debug_log}" w]
 puts $log_fd "Starting Trial {trial_id}"
+puts $log_fd "T_start [clock milliseconds]"
 LoadTestRun "{testrun_name}"
+puts $log_fd "T_loaded [clock milliseconds]"
 StartSim
 WaitForStatus running 20000
+puts $log_fd "T_running [clock milliseconds]"
 WaitForStatus idle 90000
+puts $log_fd "T_idle [clock milliseconds]"
 set simtime [erg::get Time]
 set dist [erg::get Distance]
 puts $log_fd "Simulation Time: $simtime"
 puts $log_fd "Simulation Dist: $dist"
 SaveResults
+puts $log_fd "T_saved [clock milliseconds]"
 close $log_fd
 Exit
 """
-        with open(tcl_path, "w", encoding='utf-8') as f: 
-            f.write(tcl_content)
+            with open(tcl_path, "w", encoding='utf-8') as f: 
+                f.write(tcl_content)
 
         # 4. Launch CarMaker
         cmd = [self.CM_EXEC, self.PROJECT_DIR, "-cmd", f"source {{{tcl_path.replace(os.sep, '/')}}}"]
         
         try:
             sim_start_time = time.time()
-            process = subprocess.Popen(cmd, cwd=self.PROJECT_DIR, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            process = subprocess.Popen(cmd, cwd=self.PROJECT_DIR, env=self.launch_env(),
+                                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
             
-            # Wait for result loop (simplified)
+            # Wait for result loop: block on the pushed result,
+            # the debug log is only a fallback for libs without ResultLink
             timeout = 100
             while (time.time() - sim_start_time) < timeout:
-                if process.poll() is not None: break
+                with spans.span("result_wait"):
+                    msg = self.result_listener.wait(trial_id, 1.0)
+                if msg is not None:
+                    # Let the Tcl script finish SaveResults/Exit before killing
+                    with spans.span("finish"):
+                        try:
+                            process.wait(timeout=10)
+                        except subprocess.TimeoutExpired:
+                            pass
+                    self._tcl_spans(sim_start_time)
+                    with spans.span("kill"):
+                        self.kill_carmaker()
+                    return ResultListener.to_result(msg)
                 
                 # Check debug log for "Simulation Time" AND "Distance"
-                res = self.extract_metrics_from_debug_log()
+                with spans.span("log_poll"):
+                    res = self.extract_metrics_from_debug_log()
                 if res:
-                    self.kill_carmaker()
+                    self._tcl_spans(sim_start_time)
+                    with spans.span("kill"):
+                        self.kill_carmaker()
                     return res
-                time.sleep(1)
+                if process.poll() is not None: break
             
             self.kill_carmaker()
             return {'status': 'Crash', 'lap_time': 999, 'distance': 0.0}
@@ -125,9 +248,431 @@ Exit
             self.kill_carmaker()
             return {'status': 'Crash', 'lap_time': 999, 'distance': 0.0}
 
+    def _tcl_spans(self, launch_time):
+        """Phase spans inside CM_Office from the T_<phase> marks of the debug log (benchmark only)."""
+        if not spans.enabled:
+            return
+        try:
+            with open(os.path.join(self.scratch_dir, "debug_tcl.txt"), 'r') as f:
+                marks = {m.group(1): int(m.group(2)) / 1000.0 for m in re.finditer(r'T_(\w+) (\d+)', f.read())}
+        except OSError:
+            return
+        prev_t = launch_time
+        for mark, phase in (("start", "cm_startup"), ("loaded", "load_testrun"), ("running", "wait_running"),
+                            ("idle", "sim"), ("saved", "save_results")):
+            if mark in marks:
+                spans.add(phase, max(0.0, marks[mark] - prev_t))
+                prev_t = marks[mark]
+
+    def _prepare_testrun(self, vehicle_path, trial_id, prune=None, output_folder=None, extra_keys=None, tunables=None):
+        """Copies the vehicle into the project and writes Run_{trial_id}.ts. Returns the TestRun name."""
+        target_vehicle = f"Optimized_Car_{trial_id}"
+        testrun_name = f"Run_{trial_id}"
+        
+        # 1. Copy Vehicle
+        try:
+            with spans.span("copy_vehicle"):
+                vehicle_dir = os.path.join(self.PROJECT_DIR, "Data/Vehicle")
+                os.makedirs(vehicle_dir, exist_ok=True)
+                target_path = os.path.join(vehicle_dir, target_vehicle)
+                shutil.copy(vehicle_path, target_path)
+        except Exception as e:
+            self.logger.error(f"Failed to copy vehicle: {e}")
+            return None
+
+        # 2. Create TestRun with HUMANIZED DRIVER (Fix #3)
+        #  "Humanización del Modelo de Conductor"
+        with spans.span("testrun"):
+            return self._write_testrun(target_vehicle, testrun_name, trial_id, prune, output_folder,
+                                       extra_keys, tunables)
+
+    def _write_testrun(self, target_vehicle, testrun_name, trial_id, prune, output_folder, extra_keys, tunables):
+        template = self._testrun_template()
+        if template is None:
+            return None
+        testrun_path = os.path.join(self.PROJECT_DIR, "Data/TestRun", f"{testrun_name}.ts")
+        
+        # Old save configs are removed, overwritten below
+        drop = template.keys_containing("SaveConfig") + list(extra_keys or ()) + list(tunables or ())
+        
+        modified_lines = self._injection_lines()
+        modified_lines.extend(self._trial_lines(trial_id, prune, output_folder, extra_keys, tunables))
+        self.result_listener.drain()
+        
+        CompiledTemplate.write(testrun_path, template.render({"Vehicle": target_vehicle}, drop, modified_lines))
+        return testrun_name
+
+    def _injection_lines(self):
+        # Inject Driver Degradation & Output Config
+        return ["\n# --- OPTIMIZER INJECTIONS ---\n",
+                "SaveConfig.Enabled = 1\n",
+                f"SaveConfig.Write.Enabled = {1 if self.WRITE_ERG else 0}\n",
+                #  Transport Delay 150-200ms
+                "Driver.ReactTime = 0.18\n",
+                # [cite: 535] Neuromuscular Filter (approximate via steering damping/filter)
+                "DrivMan.Steer.Filter.G = 4.0\n"]
+
+    # TestRun keys that don't change the simulated run (ResultCache)
+    NEUTRAL_KEYS = ("ResultLink.", "BinExport.", "Telemetry.", "SaveConfig.", "Prune.BestTime",
+                    "EnvKeep.")
+
+    def result_fingerprint(self, prune=None, tunables=None):
+        """
+        The TestRun of a trial as far as it changes the result (ResultCache key):
+        template hash and the injected keys, without result transport, export
+        paths and the campaign's current best time. None without a template.
+        With WARM_START the snapshot the trial starts from is part of it, the
+        baseline is taken here if there is none yet.
+        """
+        template = self._testrun_template()
+        if template is None:
+            return None
+        lines = self._injection_lines() + self._trial_lines("", prune, None, tunables=tunables)
+        keys = sorted(k for k in (line.strip() for line in lines)
+                      if k and not k.startswith("#") and not k.startswith(self.NEUTRAL_KEYS))
+        baseline = self.warm_baseline() if self.WARM_START else None
+        warm = [self.WARM_SETTLE_TIME, baseline[2]] if baseline else None # None = cold start
+        return {'template': template.digest, 'keys': keys, 'warm_start': warm}
+
+    @staticmethod
+    def tunables_set(result, tunables):
+        """
+        (Tun.* keys sent, TunBatch.n reported by the app) of a run; the count is
+        None if the run sent no result message. TunBatch.n is missing, i.e. 0,
+        in a lib built without -DCM_TUNBATCH.
+        """
+        sent = sum(1 for key in (tunables or {}) if key.startswith("Tun."))
+        msg = result.get('quantities')
+        if not msg:
+            return sent, None
+        return sent, int(msg.get("TunBatch.n", 0) or 0)
+
+    def _testrun_template(self):
+        """TEMPLATE_TESTRUN, parsed once per interface and again only when it changes."""
+        if self._testrun_tpl is None or not self._testrun_tpl.is_current():
+            template_file = os.path.join(self.PROJECT_DIR, "Data/TestRun", self.TEMPLATE_TESTRUN)
+            if not os.path.exists(template_file) and os.path.exists(template_file + ".ts"):
+                template_file += ".ts"
+            try:
+                self._testrun_tpl = CompiledTemplate(template_file)
+            except OSError as e:
+                self.logger.error(f"TestRun template not readable: {e}")
+                self._testrun_tpl = None
+        return self._testrun_tpl
+
+    def _trial_lines(self, trial_id, prune=None, output_folder=None, extra_keys=None, tunables=None):
+        """TestRun keys read by the CM4SL app that change from trial to trial."""
+        # Where the CM4SL app pushes the final KPIs (ResultLink)
+        modified_lines = self.result_listener.testrun_keys(trial_id, self.RESULT_QUANTITIES)
+        
+        # Early stop of hopeless trials (Prune.c)
+        for key, val in (prune or {}).items():
+            modified_lines.append(f"Prune.{key} = {val}\n")
+        
+        # Binary result export (BinExport.c)
+        export_file = self.export_path(output_folder)
+        if export_file:
+            modified_lines.append(f"BinExport.FName = {export_file.replace(os.sep, '/')}\n")
+            modified_lines.append(f"BinExport.Quantities = {' '.join(self.EXPORT_QUANTITIES)}\n")
+            modified_lines.append(f"BinExport.Decimate = {self.EXPORT_DECIMATE}\n")
+        
+        # Per-sensor update rates (SensorSched.c)
+        for name, rate in self.SENSOR_RATES.items():
+            modified_lines.append(f"SensorSched.{name}.Rate = {rate}\n")
+        if self.SENSOR_PARALLEL:
+            modified_lines.append("SensorSched.Parallel = 1\n")
+        
+        # Road / environment kept loaded between the trials of a session (EnvKeep.c)
+        if self.KEEP_ENV and self.session_pool is not None:
+            modified_lines.append("EnvKeep.Active = 1\n")
+        
+        # Controller model rates (MultiRate.c)
+        for name, rate in self.MODEL_RATES.items():
+            modified_lines.append(f"MultiRate.{name}.Rate = {rate}\n")
+        
+        # Live telemetry (Telemetry.c), only if the app has a region
+        if self.TELEMETRY and self.TELEMETRY_QUANTITIES:
+            modified_lines.append(f"Telemetry.Quantities = {' '.join(self.TELEMETRY_QUANTITIES)}\n")
+            modified_lines.append(f"Telemetry.Cycles = {self.TELEMETRY_CYCLES}\n")
+        
+        # Simulink model parameters (TunBatch.c)
+        for key, val in (tunables or {}).items():
+            modified_lines.append(f"{key} = {val}\n")
+        
+        for key, val in (extra_keys or {}).items():
+            modified_lines.append(f"{key} = {val}\n")
+        return modified_lines
+
+    def export_path(self, output_folder):
+        """Where the app writes the binary export of a trial (None = export disabled)."""
+        if not output_folder or not self.EXPORT_QUANTITIES:
+            return None
+        return os.path.join(os.path.abspath(output_folder), "results.cmbx")
+
+    def _run_in_session(self, vehicle_path, output_folder, trial_id, prune=None, extra_keys=None, tunables=None,
+                        vehicle_keys=None):
+        """Runs the trial on a persistent CM_Office instance from the session pool."""
+        use_hot = self.HOT_PARAMS and extra_keys is None
+        testrun_name = None
+
+        try:
+            with self.session_pool.session() as session:
+                with spans.span("hot_inject"):
+                    hot = use_hot and self._hot_start(session, vehicle_path, trial_id, prune, output_folder,
+                                                      tunables, vehicle_keys)
+                if not hot:
+                    cold_vehicle = vehicle_path
+                    if vehicle_keys:
+                        cold_vehicle = self._keyed_vehicle(vehicle_path, vehicle_keys, trial_id)
+                    testrun_name = self._prepare_testrun(cold_vehicle, trial_id, prune, output_folder,
+                                                         extra_keys, tunables)
+                    if testrun_name is None:
+                        return {'status': 'Crash', 'lap_time': 999, 'distance': 0.0}
+                    with spans.span("load_testrun"):
+                        session.execute(f'LoadTestRun "{testrun_name}"', timeout=20)
+                    # Another TestRun is loaded now (fork trunk, warm start baseline)
+                    session.hot_base = None
+                with spans.span("wait_running"):
+                    session.execute("StartSim", timeout=10)
+                    session.wait_for_status("running", 20000)
+                
+                # Block on the pushed result instead of polling
+                with spans.span("sim"):
+                    msg = self.result_listener.wait(trial_id, 95.0)
+                if msg is not None:
+                    with spans.span("finish"):
+                        session.wait_for_status("idle", 10000)
+                    result = ResultListener.to_result(msg)
+                else:
+                    # Lib without ResultLink: ask the GUI once the run is over
+                    session.wait_for_status("idle", 10000)
+                    sim_time = float(session.execute("erg::get Time", timeout=5) or 0.0)
+                    dist = float(session.execute("erg::get Distance", timeout=5) or 0.0)
+                    result = {'status': 'Complete' if sim_time > 1.0 else 'Crash',
+                              'lap_time': sim_time if sim_time > 1.0 else 999, 'distance': dist}
+                if self.WRITE_ERG:
+                    with spans.span("save_results"):
+                        session.execute("SaveResults", timeout=10)
+                session.n_runs += 1
+                
+                # This trial's TestRun stays loaded, the next trials only send their changes
+                if use_hot and not hot and msg is not None:
+                    session.hot_base = (self._vehicle_blocks(vehicle_path, vehicle_keys),
+                                        self._line_keys(self._trial_lines(trial_id, prune, output_folder,
+                                                                          tunables=tunables)))
+                    session.app_addr = self.result_listener.app_addr
+        except (CarMakerSessionError, ValueError) as e:
+            self.logger.error(f"Trial {trial_id} failed in session: {e}")
+            return {'status': 'Crash', 'lap_time': 999, 'distance': 0.0}
+
+        return result
+
+    @staticmethod
+    def _line_keys(lines):
+        return [line.split('=')[0].strip() for line in lines]
+
+    def _hot_start(self, session, vehicle_path, trial_id, prune=None, output_folder=None, tunables=None,
+                   vehicle_keys=None):
+        """
+        Sends the vehicle keys that differ from the session's loaded TestRun and
+        this trial's TestRun keys to the app (HotParam.c). False = the trial has
+        to be loaded cold (no base yet, keys removed, or no acknowledge).
+        """
+        if session.hot_base is None or session.app_addr is None:
+            return False
+        base, base_keys = session.hot_base
+        trial = self._vehicle_blocks(vehicle_path, vehicle_keys)
+        trial_lines = self._trial_lines(trial_id, prune, output_folder, tunables=tunables)
+        # No way to remove a key from the loaded Info Files
+        if any(k not in trial for k in base if not k.startswith('#')) or self._line_keys(trial_lines) != base_keys:
+            return False
+
+        lines, n_keys = [], len(trial_lines)
+        for key, block in trial.items():
+            if not key.startswith('#') and base.get(key) != block:
+                lines.append("Vhcl " + block[0])
+                lines.extend(block[1:])
+                n_keys += 1
+        lines.extend("TestRun " + line for line in trial_lines)
+
+        self.result_listener.drain()
+        n = self.result_listener.send_hot_params(session.app_addr, lines)
+        if n != n_keys:
+            self.logger.warning(f"Trial {trial_id}: hot parameters not taken (ack {n}), loading cold")
+            self.result_listener.send_hot_params(session.app_addr, [])
+            return False
+        self.logger.info(f"🔥 Trial {trial_id}: {n_keys - len(trial_lines)} vehicle key(s) hot injected")
+        return True
+
+    @staticmethod
+    def _infofile_blocks(path):
+        """
+        Infofile as {key: lines}. A block is a 'Key = value' line or a 'Key:'
+        line with its tab-indented continuation lines; comments keep their own block.
+        """
+        blocks, key = {}, None
+        with open(path, 'r', encoding='utf-8', errors='ignore') as f:
+            for i, line in enumerate(f):
+                if key is not None and line[:1] in ('\t', ' ') and line.strip():
+                    blocks[key].append(line)
+                    continue
+                stripped = line.strip()
+                if not stripped or stripped.startswith('#'):
+                    key = f"#{i}"
+                else:
+                    key = re.split(r'\s*[=:]', stripped, maxsplit=1)[0]
+                blocks[key] = [line]
+        return blocks
+
+    def _vehicle_blocks(self, vehicle_path, vehicle_keys=None):
+        blocks = self._infofile_blocks(vehicle_path)
+        blocks.update(vehicle_keys or {})
+        return blocks
+
+    def _keyed_vehicle(self, vehicle_path, vehicle_keys, trial_id):
+        """Vehicle file with the blocks of vehicle_keys replaced, for a cold load."""
+        keyed_path = os.path.join(self.scratch_dir, f"KeyedVehicle_{trial_id}")
+        blocks = self._vehicle_blocks(vehicle_path, vehicle_keys)
+        CompiledTemplate.write(keyed_path, "".join(line for block in blocks.values() for line in block))
+        return keyed_path
+
+    def _take_snapshot(self, vehicle_path, trial_id, limits, prune=None):
+        """
+        Run of vehicle_path that exports the vehicle state at its end (WarmStart.Take),
+        limits: Snapshot.TimeLimit / Snapshot.DistLimit. Returns (result, snapshot blocks),
+        the blocks are None if the app wrote no snapshot.
+        """
+        snap_file = os.path.join(os.path.abspath(self.scratch_dir), f"{trial_id}_Snapshot.info")
+        if os.path.exists(snap_file):
+            os.remove(snap_file)
+
+        keys = {"WarmStart.Take": 1, "Snapshot.FName": snap_file.replace(os.sep, '/')}
+        keys.update(limits)
+        result = self.run_test(vehicle_path, None, trial_id, prune=prune, extra_keys=keys)
+
+        # Written by the app at the end of the Test Run
+        deadline = time.time() + 10.0
+        while not os.path.exists(snap_file) and time.time() < deadline:
+            time.sleep(0.2)
+        if not os.path.exists(snap_file):
+            return result, None
+        return result, self._infofile_blocks(snap_file)
+
+    # Simulated time the baseline run may go past WARM_SETTLE_TIME (end of the cycle, s)
+    WARM_SETTLE_SLACK = 0.05
+
+    def _take_baseline_snapshot(self, vehicle_path):
+        """
+        Short run of the baseline vehicle, returns (vehicle blocks, snapshot blocks,
+        snapshot digest) or None. A run that went on past the settle time (the app
+        ignored Snapshot.TimeLimit) has a snapshot of the wrong state and is rejected.
+        """
+        result, snapshot = self._take_snapshot(vehicle_path, "WarmBase",
+                                               {"Snapshot.TimeLimit": self.WARM_SETTLE_TIME})
+        if snapshot is None:
+            self.logger.warning(f"Warm start: no snapshot ({result.get('status')}), trials start cold")
+            return None
+        sim_time = result.get('lap_time', 0.0)
+        if sim_time > self.WARM_SETTLE_TIME + self.WARM_SETTLE_SLACK:
+            self.logger.warning(f"Warm start: baseline run ended at {sim_time} s, not after "
+                                f"{self.WARM_SETTLE_TIME} s ({result.get('status')}), trials start cold")
+            return None
+
+        start_time = result.get('quantities', {}).get('WarmStart.StartTime')
+        self.logger.info(f"🔥 Warm start baseline taken (cold start phase {start_time} s)")
+        # Without the comments (header of the export)
+        digest = hashlib.sha1("".join(line for key, block in snapshot.items() if not key.startswith('#')
+                                      for line in block).encode("utf-8")).hexdigest()
+        return self._infofile_blocks(vehicle_path), snapshot, digest
+
+    def warm_baseline(self):
+        """
+        (base vehicle blocks, snapshot blocks, snapshot digest) of the warm start
+        baseline of WARM_BASE_VEHICLE, shared with the clones and taken on first
+        use. None if there is none, the trials start cold then.
+        """
+        try:
+            with open(self.WARM_BASE_VEHICLE, 'rb') as f:
+                key = (hashlib.sha1(f.read()).hexdigest(), self.WARM_SETTLE_TIME)
+        except OSError as e:
+            self.logger.warning(f"Warm start: baseline vehicle not readable ({e}), trials start cold")
+            return None
+        with self._warm.lock:
+            if self._warm.key != key:
+                self._warm.value = self._take_baseline_snapshot(self.WARM_BASE_VEHICLE) or False
+                self._warm.key = key
+            return self._warm.value or None
+
+    def _warm_vehicle(self, vehicle_path, trial_id):
+        """
+        Trial vehicle for a warm start: the baseline snapshot data set with the
+        keys that differ between this vehicle and the baseline vehicle replaced.
+        Unchanged subsystems keep their settled state. Falls back to the cold vehicle.
+        """
+        baseline = self.warm_baseline()
+        if baseline is None:
+            return vehicle_path
+
+        base, snapshot, _ = baseline
+        return self._snapshot_vehicle(base, snapshot, vehicle_path,
+                                      os.path.join(self.scratch_dir, f"WarmVehicle_{trial_id}"))
+
+    def fork(self, vehicle_path, fork_dist, trial_id="ForkTrunk"):
+        """
+        Trunk run of a fork (ForkSweep): vehicle_path driven fork_dist metres, where the
+        app exports the vehicle state. Returns the fork point {'vehicle', 'snapshot',
+        'time', 'distance', 'sroad', 'troad', 'v'}, None if the trunk didn't get there.
+        """
+        quantities = self.RESULT_QUANTITIES
+        self.RESULT_QUANTITIES = list(quantities) + [q for q in self.FORK_QUANTITIES if q not in quantities]
+        try:
+            # Prune.Horizon ends the run at the fork point in any case
+            result, snapshot = self._take_snapshot(vehicle_path, trial_id, {"Snapshot.DistLimit": fork_dist},
+                                                   prune={'Horizon': fork_dist})
+        finally:
+            self.RESULT_QUANTITIES = quantities
+
+        msg = result.get('quantities', {})
+        if snapshot is None or result.get('stop_reason') not in (None, 'horizon') \
+                or any(q not in msg for q in self.FORK_QUANTITIES):
+            self.logger.warning(f"Fork at {fork_dist} m: no fork point ({result.get('status')}, "
+                                f"{result.get('stop_reason')})")
+            return None
+        return {'vehicle': self._infofile_blocks(vehicle_path), 'snapshot': snapshot,
+                'time': float(msg.get("Time", 0.0)), 'distance': result.get('distance', 0.0),
+                'sroad': float(msg["Vhcl.sRoad"]), 'troad': float(msg["Vhcl.tRoad"]),
+                'v': float(msg["Vhcl.v"])}
+
+    def fork_variant(self, fork, vehicle_path, trial_id):
+        """
+        A variant continuing from the fork point: (vehicle file, TestRun keys). The vehicle
+        is the fork's snapshot with the keys in which vehicle_path differs from the trunk
+        vehicle replaced, the TestRun starts at the fork's route position and speed.
+        """
+        vehicle = self._snapshot_vehicle(fork['vehicle'], fork['snapshot'], vehicle_path,
+                                         os.path.join(self.scratch_dir, f"ForkVehicle_{trial_id}"))
+        keys = {"Vehicle.StartPos": f"{fork['sroad']:.4f} {fork['troad']:.4f}",
+                "DrivMan.Man.Start.Velocity": f"{3.6 * fork['v']:.4f}"} # DrivMan.SpeedUnit = kmh
+        return vehicle, keys
+
+    def _snapshot_vehicle(self, base, snapshot, vehicle_path, out_path):
+        """Snapshot data set with the blocks in which vehicle_path differs from base replaced."""
+        trial = self._infofile_blocks(vehicle_path)
+        changed = {k: v for k, v in trial.items() if not k.startswith('#') and base.get(k) != v}
+
+        lines = []
+        for key, block in snapshot.items():
+            lines.extend(changed.pop(key, block))
+        for block in changed.values():
+            lines.extend(block)
+
+        with open(out_path, 'w', encoding='utf-8') as f:
+            f.writelines(lines)
+        return out_path
+
     def extract_metrics_from_debug_log(self):
         """Extract time AND distance for Soft Penalties"""
-        debug_log = os.path.join(self.PROJECT_DIR, "debug_tcl.txt")
+        debug_log = os.path.join(self.scratch_dir, "debug_tcl.txt")
         if not os.path.exists(debug_log): return None
         
         time_val = None
@@ -0,0 +1,137 @@
+import json
+import math
+import socket
+import logging
+import time
+
+
+class ResultListener:
+    """
+    Receives the end-of-run KPI datagram pushed by the CM4SL app
+    (ResultLink.c, sent from User_TestRun_End).
+
+    Message: one JSON object per datagram, e.g.
+        {"Tag": "42", "Time": 10.213, "Vhcl.Distance": 75.4}
+
+    The TestRun tells CarMaker where to send it:
+        ResultLink.Port = <self.port>
+        ResultLink.Tag  = <trial id>
+
+    KPI.* entries are the streaming handling KPIs (KPI.c), mapped onto
+    the ResultHandler.process_results() names so no ERG has to be parsed.
+
+    The app also reads datagrams sent back to the address its results come
+    from (app_addr), used for hot parameter injection (HotParam.c).
+    """
+    KPI_MAP = {
+        "KPI.UndersteerGrad": "understeer_grad",
+        "KPI.MaxRoll": "max_roll",
+        "KPI.StabilityIndex": "stability_index",
+        "KPI.ResponseLag": "response_lag",
+        "KPI.SteeringRMS": "steering_rms",
+    }
+    # Prune.Reason codes (tPruneReason in Prune.h)
+    PRUNE_REASONS = ["", "slow", "spin", "stall", "off track", "horizon"]
+    # HOTPARAM_MSGMAX in HotParam.h
+    HOTPARAM_MSGMAX = 16384
+
+    def __init__(self, host="127.0.0.1"):
+        self.logger = logging.getLogger("ResultListener")
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind((host, 0)) # Ephemeral port, one listener per worker
+        self.port = self.sock.getsockname()[1]
+        self.app_addr = None # sender of the last matching message
+
+    def testrun_keys(self, trial_id, quantities=()):
+        """Info File lines to append to the TestRun."""
+        lines = [f"ResultLink.Port = {self.port}\n", f"ResultLink.Tag = {trial_id}\n"]
+        if quantities:
+            lines.append(f"ResultLink.Quantities = {' '.join(quantities)}\n")
+        return lines
+
+    def drain(self):
+        """Drops stale datagrams (e.g. from an aborted previous trial)."""
+        self.sock.setblocking(False)
+        try:
+            while True:
+                self.sock.recv(65535)
+        except (BlockingIOError, OSError):
+            pass
+        finally:
+            self.sock.setblocking(True)
+
+    def wait(self, trial_id, timeout):
+        """
+        Blocks until the result of 'trial_id' arrives or 'timeout' (s) expires.
+        Returns the decoded message dict, or None on timeout.
+        """
+        deadline = time.time() + timeout
+        while True:
+            remaining = deadline - time.time()
+            if remaining <= 0:
+                return None
+            self.sock.settimeout(remaining)
+            try:
+                data, addr = self.sock.recvfrom(65535)
+            except socket.timeout:
+                return None
+
+            try:
+                msg = json.loads(data.decode("utf-8", errors="ignore"))
+            except ValueError:
+                self.logger.warning(f"Malformed result message: {data[:80]!r}")
+                continue
+
+            if str(msg.get("Tag", "")) == str(trial_id):
+                self.app_addr = addr
+                return msg
+
+    def send_hot_params(self, addr, lines, timeout=1.0):
+        """
+        Sends a HotParam message ('<Vhcl|TestRun> <key> = <value>' lines) to
+        the app at 'addr'. Returns the number of keys it acknowledged, -1 if
+        it rejected the message, None on timeout.
+        """
+        data = ("HotParam\n" + "".join(lines)).encode("utf-8")
+        if len(data) >= self.HOTPARAM_MSGMAX:
+            return -1
+        self.sock.sendto(data, addr)
+        msg = self.wait("HotParam", timeout)
+        return int(msg.get("HotParam.n", -1)) if msg is not None else None
+
+    @staticmethod
+    def to_result(msg):
+        """Maps a ResultLink message onto the run_test() result dict."""
+        sim_time = float(msg.get("Time", 0.0))
+        dist = float(msg.get("Vhcl.Distance", msg.get("Distance", 0.0)))
+        if not math.isfinite(sim_time): sim_time = 0.0
+        if not math.isfinite(dist): dist = 0.0
+        status = 'Complete' if sim_time > 1.0 else 'Crash'
+        result = {'status': status, 'lap_time': sim_time if sim_time > 1.0 else 999,
+                  'distance': dist, 'quantities': msg, 'kpis': ResultListener.to_kpis(msg)}
+        
+        # Stopped early by the app: Time/Distance are the partial pace
+        reason = int(msg.get("Prune.Reason", 0) or 0)
+        if 0 < reason < len(ResultListener.PRUNE_REASONS):
+            result['status'] = 'Stopped'
+            result['stop_reason'] = ResultListener.PRUNE_REASONS[reason]
+        
+        # Start phase wall clock time (WarmStart.c)
+        if "WarmStart.StartTime" in msg:
+            result['start_time'] = float(msg["WarmStart.StartTime"])
+        return result
+
+    @staticmethod
+    def to_kpis(msg):
+        """KPIs computed in the app, {} if the lib has no KPI module or inputs were missing."""
+        if not msg.get("KPI.Valid"):
+            return {}
+        kpis = {}
+        for key, name in ResultListener.KPI_MAP.items():
+            val = msg.get(key)
+            if val is not None and math.isfinite(float(val)):
+                kpis[name] = float(val)
+        return kpis
+
+    def close(self):
+        self.sock.close()
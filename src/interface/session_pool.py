@@ -0,0 +1,195 @@
+import queue
+import socket
+import subprocess
+import logging
+import threading
+import time
+from contextlib import contextmanager
+
+
+class CarMakerSessionError(Exception):
+    """Raised when a CarMaker session stops answering or reports an error."""
+    pass
+
+
+class CarMakerSession:
+    """
+    One long-lived CM_Office instance, remote controlled through its
+    Tcl command port (CM_Office.exe <project> -cmdport <port>).
+
+    Protocol: each command is sent terminated by '\\r'. CarMaker answers
+    with 'O<result>' (ok) or 'E<message>' (error), terminated by '\\r\\n\\r\\n'.
+    """
+    TERMINATOR = b"\r\n\r\n"
+
+    def __init__(self, cm_exec, project_dir, port, startup_timeout=60.0, env=None):
+        self.logger = logging.getLogger(f"CM_Session:{port}")
+        self.cm_exec = cm_exec
+        self.project_dir = project_dir
+        self.port = port
+        self.startup_timeout = startup_timeout
+        self.env = env # None = inherit
+
+        self.process = None
+        self.sock = None
+        self.n_runs = 0
+        # Hot parameter injection (CarMakerInterface._hot_start): the loaded
+        # TestRun's base keys and the app's ResultLink address
+        self.hot_base = None
+        self.app_addr = None
+
+    def start(self):
+        """Launches CM_Office and waits until the command port accepts connections."""
+        cmd = [self.cm_exec, self.project_dir, "-cmdport", str(self.port)]
+        env = self.env
+        if env is not None and env.get("CM_TELEMETRY"):
+            # One live telemetry region per instance (Telemetry.c)
+            env = dict(env, CM_TELEMETRY=f"{env['CM_TELEMETRY']}_{self.port}")
+        self.process = subprocess.Popen(cmd, cwd=self.project_dir, env=env,
+                                        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+        t_start = time.time()
+        while (time.time() - t_start) < self.startup_timeout:
+            if self.process.poll() is not None:
+                raise CarMakerSessionError(f"CM_Office exited during startup (rc={self.process.returncode})")
+            try:
+                self.sock = socket.create_connection(("localhost", self.port), timeout=2.0)
+                self.logger.info(f"   -> Session up on port {self.port} ({time.time() - t_start:.1f}s)")
+                return True
+            except OSError:
+                time.sleep(0.5)
+
+        self.close()
+        raise CarMakerSessionError(f"Command port {self.port} not reachable after {self.startup_timeout:.0f}s")
+
+    def is_alive(self):
+        return self.process is not None and self.process.poll() is None and self.sock is not None
+
+    def execute(self, command, timeout=30.0):
+        """Sends one Tcl command and returns its result string."""
+        if not self.is_alive():
+            raise CarMakerSessionError("Session is not running")
+
+        try:
+            self.sock.settimeout(timeout)
+            self.sock.sendall((command + "\r").encode("utf-8"))
+
+            data = b""
+            while not data.endswith(self.TERMINATOR):
+                chunk = self.sock.recv(4096)
+                if not chunk:
+                    raise CarMakerSessionError("Command port closed by CarMaker")
+                data += chunk
+        except socket.timeout:
+            raise CarMakerSessionError(f"Timeout ({timeout:.0f}s) on '{command}'")
+        except OSError as e:
+            raise CarMakerSessionError(f"Socket error on '{command}': {e}")
+
+        reply = data[:-len(self.TERMINATOR)].decode("utf-8", errors="ignore")
+        if reply.startswith("E"):
+            raise CarMakerSessionError(f"'{command}' failed: {reply[1:]}")
+        return reply[1:] if reply.startswith("O") else reply
+
+    def wait_for_status(self, status, timeout_ms):
+        """WaitForStatus returns non-zero when the state was not reached in time."""
+        rc = self.execute(f"WaitForStatus {status} {int(timeout_ms)}", timeout=timeout_ms / 1000.0 + 5.0)
+        if rc.strip() not in ("", "0"):
+            raise CarMakerSessionError(f"Status '{status}' not reached within {timeout_ms / 1000.0:.0f}s")
+
+    def restart(self):
+        self.logger.warning(f"   -> Restarting session on port {self.port}")
+        self.close()
+        self.n_runs = 0
+        self.hot_base = None
+        self.app_addr = None
+        return self.start()
+
+    def close(self):
+        if self.sock is not None:
+            try:
+                self.sock.close()
+            except OSError:
+                pass
+            self.sock = None
+
+        if self.process is not None and self.process.poll() is None:
+            # Kill only this instance's process tree, never all CM_Office.exe
+            try:
+                subprocess.call(['taskkill', '/F', '/PID', str(self.process.pid), '/T'],
+                                stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            except OSError:
+                self.process.kill()
+        self.process = None
+
+
+class SessionPool:
+    """
+    N persistent CarMaker sessions shared between trials.
+    A session is only restarted when it crashed or timed out.
+
+    Usage:
+        with pool.session() as s:
+            s.execute('LoadTestRun "Run_0"')
+    """
+    def __init__(self, cm_exec, project_dir, size=1, base_port=16660, env=None):
+        self.logger = logging.getLogger("SessionPool")
+        self.size = size
+        self.sessions = [CarMakerSession(cm_exec, project_dir, base_port + i, env=env) for i in range(size)]
+        self._idle = queue.Queue()
+        self._lock = threading.Lock()
+        self._started = False
+
+    def start(self):
+        with self._lock:
+            if self._started:
+                return
+            for s in self.sessions:
+                try:
+                    s.start()
+                except CarMakerSessionError as e:
+                    # Keep the slot, it gets another chance on first acquire
+                    self.logger.error(f"Session {s.port} failed to start: {e}")
+                self._idle.put(s)
+            self._started = True
+            self.logger.info(f"🔌 Session pool ready ({self.size} instance(s))")
+
+    def acquire(self, timeout=None):
+        self.start()
+        s = self._idle.get(timeout=timeout)
+        if not s.is_alive():
+            try:
+                s.restart()
+            except CarMakerSessionError as e:
+                self._idle.put(s)
+                raise e
+        return s
+
+    def release(self, s, healthy=True):
+        if not healthy:
+            try:
+                s.restart()
+            except CarMakerSessionError as e:
+                self.logger.error(f"Session {s.port} restart failed: {e}")
+        self._idle.put(s)
+
+    @contextmanager
+    def session(self, timeout=None):
+        s = self.acquire(timeout)
+        healthy = True
+        try:
+            yield s
+        except CarMakerSessionError:
+            healthy = False
+            raise
+        finally:
+            self.release(s, healthy)
+
+    def shutdown(self):
+        for s in self.sessions:
+            try:
+                s.execute("Exit", timeout=5.0)
+            except CarMakerSessionError:
+                pass
+            s.close()
+        self._idle = queue.Queue()
+        self._started = False
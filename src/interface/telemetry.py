@@ -0,0 +1,167 @@
+import glob
+import mmap
+import os
+import struct
+import sys
+
+import numpy as np
+
+
+def region_name(prefix, port=None):
+    """Shared memory name of one CarMaker instance (port = its session command port)."""
+    return prefix if port is None else f"{prefix}_{port}"
+
+
+class TelemetryReader:
+    """
+    Maps the live telemetry region written by the CM4SL app (Telemetry.c,
+    from MainThread_FinishCycle) read-only. The app never waits for readers.
+
+    Layout as tTelemetryShm in Telemetry.h: a header with the quantity
+    names, Seq and two frames. Frame[Seq & 1] is the last complete one;
+    it is copied out of the mapping (numpy view) and kept only if Seq
+    didn't change meanwhile.
+
+    Usage:
+        r = TelemetryReader("CMTelemetry_16660")
+        if r.open():
+            f = r.read() # {'run': 3, 'tag': '42', 'time': 12.3, 'simulating': True,
+                         #  'values': {'Car.v': 17.2, ...}}
+    """
+    MAGIC = 0x4c544d43 # "CMTL"
+    VERSION = 1
+    HEADER = struct.Struct("<8I") # Magic .. RunNo
+    TAG_LEN = 64
+    NAME_LEN = 64
+    FRAME_HEAD = struct.Struct("<QdIi") # CycleNo, Time, Layout, Simulate
+    RETRIES = 20
+
+    def __init__(self, name):
+        self.name = name
+        self.mm = None
+        self._layout = None
+        self.names = []
+        self.run_no = 0
+        self.tag = ""
+
+    def open(self):
+        """True if the region exists and was created by a running app."""
+        self.close()
+        try:
+            if sys.platform == "win32":
+                # Opens the app's named file mapping; a new one (zeros) if it doesn't exist
+                size = self._size_hint()
+                self.mm = mmap.mmap(-1, size, tagname=self.name, access=mmap.ACCESS_READ)
+            else:
+                with open(os.path.join("/dev/shm", self.name), "rb") as f:
+                    self.mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (OSError, ValueError):
+            self.mm = None
+            return False
+
+        magic, version, max_quants, frame_offset, frame_size = self.HEADER.unpack_from(self.mm, 0)[:5]
+        if magic != self.MAGIC or version != self.VERSION or len(self.mm) < frame_offset + 2 * frame_size:
+            self.close()
+            return False
+
+        self.max_quants = max_quants
+        self.frame_offset = frame_offset
+        self.frame_size = frame_size
+        self.seq_offset = frame_offset - 8
+        # Zero-copy views onto the values of both frames
+        self._values = [np.frombuffer(self.mm, dtype="<f8", count=max_quants,
+                                      offset=frame_offset + k * frame_size + self.FRAME_HEAD.size)
+                        for k in (0, 1)]
+        return True
+
+    @classmethod
+    def _size_hint(cls):
+        # sizeof(tTelemetryShm) with TELEMETRY_MAXQUANTS = 64
+        return cls.HEADER.size + cls.TAG_LEN + 64 * cls.NAME_LEN + 8 + 2 * (cls.FRAME_HEAD.size + 64 * 8)
+
+    def _u32(self, offset):
+        return struct.unpack_from("<I", self.mm, offset)[0]
+
+    def _load_layout(self):
+        """Quantity names, run number and trial tag; False while the app changes them."""
+        for _ in range(self.RETRIES):
+            layout = self._u32(20)
+            if layout & 1:
+                continue
+            n_quants, run_no = struct.unpack_from("<2I", self.mm, 24)
+            tag = self.mm[32:32 + self.TAG_LEN]
+            base = 32 + self.TAG_LEN
+            names = [self.mm[base + i * self.NAME_LEN: base + (i + 1) * self.NAME_LEN]
+                     for i in range(min(n_quants, self.max_quants))]
+            if self._u32(20) != layout:
+                continue
+            self._layout = layout
+            self.run_no = run_no
+            self.tag = tag.split(b"\0", 1)[0].decode("utf-8", errors="ignore")
+            self.names = [n.split(b"\0", 1)[0].decode("utf-8", errors="ignore") for n in names]
+            return True
+        return False
+
+    def read_frame(self):
+        """(cycle, time, simulating, values array) of the last frame, None if not available."""
+        if self.mm is None:
+            return None
+        if self._u32(0) != self.MAGIC:
+            self.close() # app exited
+            return None
+
+        for _ in range(self.RETRIES):
+            seq = self._u32(self.seq_offset)
+            if seq == 0:
+                return None # nothing published yet
+            k = seq & 1
+            cycle, t, layout, simulate = self.FRAME_HEAD.unpack_from(self.mm, self.frame_offset + k * self.frame_size)
+            if layout != self._layout and not self._load_layout():
+                continue
+            values = self._values[k][:len(self.names)].copy()
+            if self._u32(self.seq_offset) != seq:
+                continue
+            if layout != self._layout:
+                continue # frame of the previous layout
+            return cycle, t, bool(simulate), values
+        return None
+
+    def read(self):
+        """Last frame as a dict, None if not available."""
+        frame = self.read_frame()
+        if frame is None:
+            return None
+        cycle, t, simulating, values = frame
+        return {
+            'run': self.run_no,
+            'tag': self.tag,
+            'cycle': cycle,
+            'time': t,
+            'simulating': simulating,
+            'values': dict(zip(self.names, values.tolist())),
+        }
+
+    def close(self):
+        if self.mm is not None:
+            self._values = None
+            try:
+                self.mm.close()
+            except BufferError:
+                pass # a caller still holds a view, released with it
+            self.mm = None
+        self._layout = None
+
+
+def discover(prefix, ports=()):
+    """Regions of the running apps: Linux lists /dev/shm, Windows tries the given session ports."""
+    if sys.platform == "win32":
+        names = [region_name(prefix)] + [region_name(prefix, p) for p in ports]
+    else:
+        names = sorted(os.path.basename(p) for p in glob.glob(os.path.join("/dev/shm", prefix + "*")))
+
+    readers = []
+    for name in names:
+        r = TelemetryReader(name)
+        if r.open():
+            readers.append(r)
+    return readers
@@ -0,0 +1,73 @@
+import threading
+import time
+from contextlib import contextmanager
+
+import numpy as np
+
+
+class PhaseSpans:
+    """
+    Wall clock spans of the phases of a trial (kill, testrun, sim, ...).
+
+    Disabled by default; run_benchmark.py enables it. The instrumented code
+    wraps a phase in 'with spans.span("name"):' or adds a span it measured
+    itself (add()). Spans belong to the trial set with 'with spans.trial(id):'
+    on the calling thread, several spans of one phase in a trial (log
+    polling) are summed up.
+    """
+    def __init__(self):
+        self.enabled = False
+        self._lock = threading.Lock()
+        self._local = threading.local()
+        self.records = [] # (trial, phase, seconds)
+
+    @contextmanager
+    def trial(self, trial_id):
+        prev = getattr(self._local, "trial", None)
+        self._local.trial = trial_id
+        try:
+            yield
+        finally:
+            self._local.trial = prev
+
+    @contextmanager
+    def span(self, phase):
+        if not self.enabled:
+            yield
+            return
+        t0 = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.add(phase, time.perf_counter() - t0)
+
+    def add(self, phase, seconds):
+        if self.enabled:
+            with self._lock:
+                self.records.append((getattr(self._local, "trial", None), phase, seconds))
+
+    def reset(self):
+        with self._lock:
+            self.records = []
+
+    def per_trial(self):
+        """{phase: [seconds of each trial]}, in order of first appearance."""
+        totals = {}
+        with self._lock:
+            for trial, phase, seconds in self.records:
+                per = totals.setdefault(phase, {})
+                per[trial] = per.get(trial, 0.0) + seconds
+        return {phase: list(per.values()) for phase, per in totals.items()}
+
+    def summary(self):
+        """{phase: {'n', 'mean', 'p50', 'p95'}} in seconds per trial."""
+        out = {}
+        for phase, values in self.per_trial().items():
+            v = np.asarray(values)
+            out[phase] = {'n': len(v), 'mean': float(v.mean()),
+                          'p50': float(np.percentile(v, 50)), 'p95': float(np.percentile(v, 95))}
+        return out
+
+
+# Shared by all modules of the optimizer
+spans = PhaseSpans()
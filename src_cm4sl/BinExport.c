@@ -0,0 +1,241 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Binary columnar result export (see BinExport.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - BinExport_TestRun_Start ()
+ * - BinExport_Out ()
+ * - BinExport_TestRun_End ()
+ * - BinExport_Cleanup ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <CarMaker.h>
+
+#include "BinExport.h"
+
+static struct {
+    char         FName[1024];
+    int          nChan;
+    char         Name[BINEXPORT_MAXCHAN][BINEXPORT_NAMELEN];
+    tDDictEntry *Quant[BINEXPORT_MAXCHAN];   /* [0] unused, Time */
+
+    int          Decimate, DecCnt;
+
+    /* Row buffer, kept across Test Runs and only grown */
+    float       *Data;
+    size_t       Size;                       /* allocated floats */
+    size_t       nRows, MaxRows;
+    int          Overflow;
+} BX;
+
+static void
+AddChannel(char const *name, tDDictEntry *e)
+{
+    if (BX.nChan >= BINEXPORT_MAXCHAN) {
+        LogWarnF(EC_General, "BinExport: too many quantities, '%s' ignored", name);
+        return;
+    }
+    strncpy(BX.Name[BX.nChan], name, BINEXPORT_NAMELEN - 1);
+    BX.Name[BX.nChan][BINEXPORT_NAMELEN - 1] = '\0';
+    BX.Quant[BX.nChan] = e;
+    BX.nChan++;
+}
+
+/*
+ * BinExport_TestRun_Start ()
+ *
+ * Read the BinExport.* keys, resolve the quantities and preallocate
+ * the row buffer for BinExport.MaxTime seconds.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - when starting a new Test Run, after all models are read in
+ */
+
+int
+BinExport_TestRun_Start(struct tInfos *Inf)
+{
+    char const *s;
+    double      maxTime;
+    size_t      need;
+
+    BX.FName[0] = '\0';
+    BX.nChan    = 0;
+    BX.nRows    = 0;
+    BX.DecCnt   = 0;
+    BX.Overflow = 0;
+
+    s = iGetStrOpt(Inf, "BinExport.FName", "");
+    if (s == NULL || *s == '\0') {
+        return 0;
+    }
+
+    BX.Decimate = iGetIntOpt(Inf, "BinExport.Decimate", 1);
+    if (BX.Decimate < 1) {
+        BX.Decimate = 1;
+    }
+    maxTime = iGetDblOpt(Inf, "BinExport.MaxTime", 120.0);
+
+    AddChannel("Time", NULL);
+    if ((s = iGetStrOpt(Inf, "BinExport.Quantities", NULL)) != NULL) {
+        char  buf[2048], *tok;
+        strncpy(buf, s, sizeof(buf) - 1);
+        buf[sizeof(buf) - 1] = '\0';
+        for (tok = strtok(buf, " \t,"); tok != NULL; tok = strtok(NULL, " \t,")) {
+            tDDictEntry *e;
+            if (strcmp(tok, "Time") == 0) {
+                continue;
+            }
+            if ((e = DDictGetEntry(tok)) == NULL) {
+                LogWarnF(EC_General, "BinExport: unknown quantity '%s'", tok);
+                continue;
+            }
+            AddChannel(tok, e);
+        }
+    }
+
+    BX.MaxRows = (size_t) (maxTime / SimCore.DeltaT / BX.Decimate) + 1;
+    need = BX.MaxRows * BX.nChan;
+    if (need > BX.Size) {
+        float *p = (float *) realloc(BX.Data, need * sizeof(float));
+        if (p == NULL) {
+            LogErrF(EC_Init, "BinExport: can't allocate %lu rows", (unsigned long) BX.MaxRows);
+            return -1;
+        }
+        BX.Data = p;
+        BX.Size = need;
+    }
+
+    s = iGetStrOpt(Inf, "BinExport.FName", "");
+    strncpy(BX.FName, s, sizeof(BX.FName) - 1);
+    BX.FName[sizeof(BX.FName) - 1] = '\0';
+
+    return 0;
+}
+
+/*
+ * BinExport_Out ()
+ *
+ * Append one row. No allocation, no file access.
+ *
+ * Call:
+ * - in RT context, from User_Out() (MainThread_FinishCycle()),
+ *   in SCState_Simulate only
+ */
+
+void
+BinExport_Out(void)
+{
+    float *row;
+    int    i;
+
+    if (BX.FName[0] == '\0' || BX.Overflow) {
+        return;
+    }
+    if (BX.DecCnt++ % BX.Decimate != 0) {
+        return;
+    }
+    if (BX.nRows >= BX.MaxRows) {
+        BX.Overflow = 1;
+        return;
+    }
+
+    row = BX.Data + BX.nRows * BX.nChan;
+    row[0] = (float) SimCore.Time;
+    for (i = 1; i < BX.nChan; i++) {
+        row[i] = (float) DDictGetValue(BX.Quant[i]);
+    }
+    BX.nRows++;
+}
+
+/*
+ * BinExport_TestRun_End ()
+ *
+ * Write the recorded rows to BinExport.FName.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), User_TestRun_End()
+ */
+
+int
+BinExport_TestRun_End(void)
+{
+    FILE     *fp;
+    uint32_t  hdr[BINEXPORT_HDRSIZE / 4];
+    char      name[BINEXPORT_NAMELEN];
+    int       i, rv = 0;
+
+    if (BX.FName[0] == '\0') {
+        return 0;
+    }
+    if (BX.Overflow) {
+        LogWarnF(EC_General, "BinExport: buffer full, recording stopped at %lu rows",
+            (unsigned long) BX.nRows);
+    }
+
+    if ((fp = fopen(BX.FName, "wb")) == NULL) {
+        LogErrF(EC_General, "BinExport: can't open '%s'", BX.FName);
+        BX.FName[0] = '\0';
+        return -1;
+    }
+
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(&hdr[0], "CMBX", 4);
+    hdr[1] = BINEXPORT_VERSION;
+    hdr[2] = (uint32_t) BX.nChan;
+    hdr[3] = (uint32_t) BX.nRows;
+    hdr[4] = (uint32_t) (BINEXPORT_HDRSIZE + BX.nChan * BINEXPORT_NAMELEN);
+
+    if (fwrite(hdr, sizeof(hdr), 1, fp) != 1) {
+        rv = -1;
+    }
+    for (i = 0; rv == 0 && i < BX.nChan; i++) {
+        memset(name, 0, sizeof(name));
+        strncpy(name, BX.Name[i], sizeof(name) - 1);
+        if (fwrite(name, sizeof(name), 1, fp) != 1) {
+            rv = -1;
+        }
+    }
+    if (rv == 0 && BX.nRows > 0
+        && fwrite(BX.Data, sizeof(float) * BX.nChan, BX.nRows, fp) != BX.nRows) {
+        rv = -1;
+    }
+    if (fclose(fp) != 0) {
+        rv = -1;
+    }
+    if (rv != 0) {
+        LogErrF(EC_General, "BinExport: writing '%s' failed", BX.FName);
+    }
+
+    BX.FName[0] = '\0';
+    return rv;
+}
+
+/*
+ * BinExport_Cleanup ()
+ *
+ * Call:
+ * - once at end of program, just before exit
+ */
+
+void
+BinExport_Cleanup(void)
+{
+    free(BX.Data);
+    memset(&BX, 0, sizeof(BX));
+}
@@ -0,0 +1,56 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Binary columnar result export
+ *
+ * A chosen subset of DDict quantities is sampled at the end of each
+ * simulation cycle (User_Out(), called from MainThread_FinishCycle())
+ * into memory preallocated at Test Run start and written in one go
+ * after the Test Run, outside of realtime conditions.
+ *
+ * File layout (little endian), memory-mappable as float32[nRows][nChannels]:
+ *	char     Magic[4]        "CMBX"
+ *	uint32   Version         1
+ *	uint32   nChannels
+ *	uint32   nRows
+ *	uint32   DataOffset      bytes from file start to the first row
+ *	uint32   Reserved[3]
+ *	char     Name[nChannels][BINEXPORT_NAMELEN]
+ *	float32  Data[nRows][nChannels]   (channel 0 is always Time)
+ *
+ * Test Run Info File keys (no file name = disabled):
+ *	BinExport.FName      = <output file>
+ *	BinExport.Quantities = <DDict names, separated by blanks>
+ *	BinExport.Decimate   = <record every n-th cycle, default 1>
+ *	BinExport.MaxTime    = <buffer size in simulation seconds, default 120>
+ *
+ *****************************************************************************
+ */
+
+#ifndef _BINEXPORT_H__
+#define _BINEXPORT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+#define BINEXPORT_VERSION   1
+#define BINEXPORT_NAMELEN   64
+#define BINEXPORT_MAXCHAN   64
+#define BINEXPORT_HDRSIZE   32
+
+int  BinExport_TestRun_Start(struct tInfos *Inf);
+void BinExport_Out(void);
+int  BinExport_TestRun_End(void);
+void BinExport_Cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _BINEXPORT_H__ */
@@ -39,6 +39,15 @@
  *		CM_Main_End ()				(CM4SL)
  *
  *
+ * Batch build (Makefile target 'batch', -DCM_BATCH), feature switches
+ * that compile out subsystems an offline optimization run doesn't use,
+ * with their Init / Cleanup and per cycle calls:
+ *	CM_NO_XCP	XCP / CCP calibration (CM_XCP_*, CM_CCP_*)
+ *	CM_NO_ADTF	ADTF coupling
+ *	CM_NO_BUSIF	CAN / FlexRay interfaces, RBS / SIP rest bus
+ *	CM_NO_SENSORS	sensor models except BdyFrame, Collision and
+ *			PylonDetect; Sensor.Param of the vehicle is ignored
+ *
  * Special options for debugging
  * - DeltaT = const = SimCore.DeltaT
  * - Initialisation not in a second Thread
@@ -63,6 +72,7 @@
 # include <process.h>
 #endif
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -104,6 +114,10 @@
 
 #include "User.h"
 #include "IOVec.h"
+#include "CycleProf.h"
+#include "SensorSched.h"
+#include "Telemetry.h"
+#include "EnvKeep.h"
 #include <can_interface.h>
 #include <flex.h>
 
@@ -131,21 +145,28 @@ ProcessApoMessages(void)
     int  ch, len, who;
 
     while (AposGetAppMsgFrom(&ch, &MsgBuf, &len, &who) != 0) {
+#if !defined(CM_NO_XCP)
         if (CM_XCP_ApoMsg_Eval(ch, MsgBuf, len) >= 0) {
             continue;
         }
         if (CM_CCP_ApoMsg_Eval(ch, MsgBuf, len) >= 0) {
             continue;
         }
+#endif
+#if !defined(CM_NO_ADTF)
         if (ADTF_ApoMsg_Eval(ch, MsgBuf, len) >= 0) {
             continue;
         }
+#endif
         if (User_ApoMsg_Eval(ch, MsgBuf, len, who) < 0 && SimCore_ApoMsg_Eval(ch, MsgBuf, len, who) < 0) {
             SimCore_UnknownApoMsgWarn(ch, MsgBuf, len);
         }
     }
 }
 
+/* Headless mode: the vehicle of this Test Run has sensors rendered by IPG Movie */
+static int GPUSensorsUsed = 1;
+
 static void
 GatherGPUSensorInstances(void)
 {
@@ -154,11 +175,16 @@ GatherGPUSensorInstances(void)
 
     while (!SimCore_GPUSensor_MinInstRegistered()) {
         if (SimCore.OnlyOneSimulation || CMTh_AttribGet(CMTh_Kind_TestRun_Start, CMTh_Attrb_MultiThread)) {
-            SysUSleep(50000);
-            AposPoll(SimCore.AposPollTime);
+            if (UserHeadless) {
+                /* wake up on the registration message instead of sleeping */
+                AposPoll(50);
+            } else {
+                SysUSleep(50000);
+                AposPoll(SimCore.AposPollTime);
+            }
             ProcessApoMessages();
         } else {
-            SysUSleep(50000);
+            SysUSleep(UserHeadless ? 5000 : 50000);
         }
         if (SysGetTime() - tstart > timeout_s) {
             break;
@@ -167,6 +193,32 @@ GatherGPUSensorInstances(void)
     SimCore_GPUSensor_PrintSensorInfo();
 }
 
+/*
+ * HasGPUSensors ()
+ *
+ * Any raw signal interface sensor (CameraRSI, LidarRSI, RadarRSI,
+ * USonicRSI) in the vehicle's sensor parameter sets.
+ */
+
+static int
+HasGPUSensors(struct tInfos *Inf)
+{
+    char        sbuf[64];
+    char const *type;
+    int         i, n, len;
+
+    n = iGetIntOpt(Inf, "Sensor.Param.N", 0);
+    for (i = 0; i < n; i++) {
+        sprintf(sbuf, "Sensor.Param.%d.Type", i);
+        type = iGetStrOpt(Inf, sbuf, "");
+        len  = (int) strlen(type);
+        if (len >= 3 && strcmp(type + len - 3, "RSI") == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 /*
  * ExitFcn ()
  *
@@ -202,14 +254,18 @@ App_Init_First(int argc, char **argv)
     SimCore_Init_First(argc, argv);
 
     IO_Init_First();
+#if !defined(CM_NO_BUSIF)
     CANIf_Init_First();
     FC_Init_First();
     RBS_Init_First();
     SIP_Init_First();
+#endif
 
     User_Init_First();
+#if !defined(CM_NO_XCP)
     CM_XCP_Init_First(NULL);
     CM_CCP_Init_First(NULL);
+#endif
     CycControl_Init_First();
     return 0;
 }
@@ -248,16 +304,23 @@ App_Init(void)
     Traffic_Init();
     PylonDetect_Init();
     BdyFrame_Init();
+#if !defined(CM_NO_SENSORS)
     InertialSensor_Init();
     SAngleSensor_Init();
+#endif
+#if !defined(CM_NO_ADTF)
     ADTF_Init();
+#endif
+#if !defined(CM_NO_SENSORS)
     ObjectSensor_Init();
     FSpaceSensor_Init();
     RoadSensor_Init();
     TSignSensor_Init();
     LineSensor_Init();
     RadarSensor_Init();
+#endif
     CollisionSensor_Init();
+#if !defined(CM_NO_SENSORS)
     GNavSensor_Init();
     USonicRSI_Init();
     RadarRSI_Init();
@@ -267,6 +330,8 @@ App_Init(void)
     CameraRSI_Init();
     GroundTruthSensor_Init();
     SensorAssembly_Init();
+#endif
+#if !defined(CM_NO_BUSIF)
     if (IO_CAN_IF) {
         if (CANIf_Param_Get(SimCore.TestRig.ECUParam.Inf, NULL) != 0) {
             return -1;
@@ -283,21 +348,31 @@ App_Init(void)
     if (SIP_Param_Get(SimCore.TestRig.ECUParam.Inf, NULL) != 0) {
         return -1;
     }
+#endif
     if (IO_Init() < 0) {
         return -1;
     }
+#if !defined(CM_NO_BUSIF)
     if (CANIf_Init() < 0) {
         return -1;
     }
     if (FC_Init() < 0) {
         return -1;
     }
+#endif
     if (User_Init() < 0) {
         return -1;
     }
-    if (CM_XCP_Init() != 0 || CM_CCP_Init() != 0 || RBS_Init() != 0 || SIP_Init() != 0) {
+#if !defined(CM_NO_XCP)
+    if (CM_XCP_Init() != 0 || CM_CCP_Init() != 0) {
         return -1;
     }
+#endif
+#if !defined(CM_NO_BUSIF)
+    if (RBS_Init() != 0 || SIP_Init() != 0) {
+        return -1;
+    }
+#endif
 
     Plugins_Init();
 
@@ -329,16 +404,21 @@ App_DeclQuants(void)
 {
     SimCore_DeclQuants();
     CycControl_DeclQuants();
+    CYCLEPROF_DECLQUANTS();
     Env_DeclQuants();
     TrfLight_DeclQuants();
     DrivMan_DeclQuants();
     VehicleControl_DeclQuants();
     Vhcl_DeclQuants();
     User_DeclQuants();
+#if !defined(CM_NO_XCP)
     CM_XCP_DeclQuants();
     CM_CCP_DeclQuants();
+#endif
+#if !defined(CM_NO_BUSIF)
     RBS_DeclQuants();
     SIP_DeclQuants();
+#endif
     CM4SL_DeclQuants(SimCore.ApopxInfo);
     App_ExportConfig();
     return 0;
@@ -381,8 +461,10 @@ App_TestRun_Start(void *arg)
     int nError = Log_nError;
 
     /* Send connect request to movies and wait for them to connect*/
-    SimCore_GPUSensor_TriggerMovies(SimCore.TestRun.Options);
-    GatherGPUSensorInstances();
+    if (!UserHeadless) {
+        SimCore_GPUSensor_TriggerMovies(SimCore.TestRun.Options);
+        GatherGPUSensorInstances();
+    }
     if (!SimCore.Reconfig.Active) {
         if (SimCore_TestRun_Start() < 0) {
             rv = -1;
@@ -409,6 +491,15 @@ App_TestRun_Start(void *arg)
             goto ErrorReturn;
         }
     }
+    if (UserHeadless) {
+        /* Movies only for GPU sensors, decided once the vehicle is read in */
+        GPUSensorsUsed = HasGPUSensors(SimCore.Vhcl.Inf);
+        if (GPUSensorsUsed) {
+            SimCore_GPUSensor_TriggerMovies(SimCore.TestRun.Options);
+            GatherGPUSensorInstances();
+        }
+    }
+#if !defined(CM_NO_XCP)
     if (SimCore.TestRig.ECUParam.WasRead) {
         if (CM_XCP_Param_Get(SimCore.TestRig.ECUParam.Inf, "XCP") != 0) {
             rv = -6;
@@ -417,6 +508,7 @@ App_TestRun_Start(void *arg)
             rv = -7;
         }
     }
+#endif
 
     /* Delete all body frames for body sensor calculation before new registration */
     BdyFrame_Delete();
@@ -431,7 +523,7 @@ App_TestRun_Start(void *arg)
         goto ErrorReturn;
     }
 
-    if (Env_New() < 0) {
+    if (EnvKeep_Env_New(SimCore.TestRun.Inf) < 0) {
         rv = -5;
         goto ErrorReturn;
     }
@@ -474,18 +566,26 @@ App_TestRun_Start(void *arg)
         goto ErrorReturn;
     }
 
+#if defined(CM_NO_SENSORS)
+    if (iGetIntOpt(SimCore.Vhcl.Inf, "Sensor.Param.N", 0) > 0) {
+        Log("Batch build: sensors of the vehicle are not simulated\n");
+    }
+#else
     /* SensorAssembly_New() has to be called before Sensor*New() functions */
     if (SensorAssembly_New() < 0) {
         rv = -44;
         goto ErrorReturn;
     }
 
+#endif
+
     /* Surrounding_New() has to be called before any module (Radar, Camera, ...)
        calls the Surrounding_Register() function */
     if (Surrounding_New() < 0) {
         rv = -42;
         goto ErrorReturn;
     }
+#if !defined(CM_NO_SENSORS)
     if (InertialSensor_New() < 0) {
         rv = -10;
         goto ErrorReturn;
@@ -514,10 +614,12 @@ App_TestRun_Start(void *arg)
         rv = -15;
         goto ErrorReturn;
     }
+#endif
     if (CollisionSensor_New() < 0) {
         rv = -16;
         goto ErrorReturn;
     }
+#if !defined(CM_NO_SENSORS)
     if (RadarSensor_New() < 0) {
         rv = -30;
         goto ErrorReturn;
@@ -527,10 +629,12 @@ App_TestRun_Start(void *arg)
         rv = -27;
         goto ErrorReturn;
     }
+#endif
     if (PylonDetect_New() < 0) {
         rv = -17;
         goto ErrorReturn;
     }
+#if !defined(CM_NO_SENSORS)
     if (USonicRSI_New() < 0) {
         rv = -31;
         goto ErrorReturn;
@@ -559,6 +663,7 @@ App_TestRun_Start(void *arg)
         rv = -41;
         goto ErrorReturn;
     }
+#endif
 
     // SimCore_GPUSensor_SendVisClientCfg() has to be called after all sensors' initialization,
     // as the sensor clusters must be already registered and assigned.
@@ -582,6 +687,7 @@ App_TestRun_Start(void *arg)
         rv = -21;
         goto ErrorReturn;
     }
+#if !defined(CM_NO_XCP)
     if (CM_XCP_TestRun_Start(NULL, NULL) != 0) {
         rv = -22;
         goto ErrorReturn;
@@ -590,6 +696,7 @@ App_TestRun_Start(void *arg)
         rv = -23;
         goto ErrorReturn;
     }
+#endif
 
     if (Plugins_New() < 0) {
         rv = -28;
@@ -645,7 +752,9 @@ App_TestRun_Start(void *arg)
     }
 
 OkReturn:
+#if !defined(CM_NO_ADTF)
     ADTF_UpdateMapping();
+#endif
     if (SimCore_TestRun_Start_End() < 0) {
         goto ErrorReturn_2nd;
     }
@@ -653,7 +762,9 @@ OkReturn:
     goto DoReturn;
 
 ErrorReturn:
+#if !defined(CM_NO_ADTF)
     ADTF_UpdateMapping();
+#endif
     SimCore_TestRun_Start_End();
 
 ErrorReturn_2nd:
@@ -698,6 +809,12 @@ App_TestRun_Start_Finalize(void)
         rv = -1;
     }
 
+    if (SensorSched_TestRun_Start_Finalize(SimCore.TestRun.Inf) < 0) {
+        rv = -1;
+    }
+
+    CYCLEPROF_RESET();
+
     if (SimCore_TestRun_Start_Finalize() < 0) {
         rv = -2;
     }
@@ -733,8 +850,10 @@ App_TestRun_Calc_Part(double dt, CyclePart_t part)
 {
     static int rv = 0;
     int        i;
+    CYCLEPROF_MARK(cpT);
 
     if (IN_ENVIRONMENT_PART(part)) {
+        CYCLEPROF_RESTART(cpT);
         rv = 0; /* !!Init */
 
         if (SimCore.State == SCState_Simulate) {
@@ -750,9 +869,11 @@ App_TestRun_Calc_Part(double dt, CyclePart_t part)
         if (TrfLight_Calc() < 0) {
             rv = -1;
         }
+        CYCLEPROF_LAP(CPSlot_Env, cpT);
     }
 
     if (IN_DRIVMAN_PART(part)) {
+        CYCLEPROF_RESTART(cpT);
         if ((i = DrivMan_Calc(dt)) != 0) {
             if (i < 0) {
                 rv = -2; /* := error	*/
@@ -780,18 +901,22 @@ App_TestRun_Calc_Part(double dt, CyclePart_t part)
         Plugins_CalcBefore(DVA_DM, dt);
         DVA_HandleWriteAccess(DVA_DM);
         Plugins_CalcAfter(DVA_DM, dt);
+        CYCLEPROF_LAP(CPSlot_DrivMan, cpT);
     }
 
     if (IN_VEHICLECONTROL_PART(part)) {
+        CYCLEPROF_RESTART(cpT);
         if (VehicleControl_Calc() < 0) {
             rv = -6;
         }
         if (Traffic_Lighting_Calc(dt) < 0) {
             rv = -5;
         }
+        CYCLEPROF_LAP(CPSlot_VehicleControl, cpT);
     }
 
     if (IN_VEHICLECONTROLUPD_PART(part)) {
+        CYCLEPROF_RESTART(cpT);
         Plugins_CalcBefore(DVA_VC, dt);
         DVA_HandleWriteAccess(DVA_VC);
         Plugins_CalcAfter(DVA_VC, dt);
@@ -803,80 +928,29 @@ App_TestRun_Calc_Part(double dt, CyclePart_t part)
         if (VehicleControl_CalcPost() < 0) {
             rv = -6;
         }
+        CYCLEPROF_LAP(CPSlot_VehicleControlUpd, cpT);
     }
 
     if (IN_VEHICLE_PART(part)) {
+        CYCLEPROF_RESTART(cpT);
         if (Vhcl_Calc_Part(dt, part) < 0) {
             rv = -3;
         }
+        CYCLEPROF_LAP(CPSlot_Vhcl, cpT);
 
         if (part == CyclePart_Vhcl_Last || part == CyclePart_All) {
-            if (BdyFrame_Calc() < 0) {
-                rv = -12;
-            }
-            if (InertialSensor_Calc(dt) < 0) {
-                rv = -7;
-            }
-            if (SAngleSensor_Calc(dt) < 0) {
-                rv = -17;
-            }
-            if (ObjectSensor_Calc(dt) < 0) {
-                rv = -8;
-            }
-            if (GroundTruthSensor_Calc(dt) < 0) {
-                rv = -24;
-            }
-            if (FSpaceSensor_Calc(dt) < 0) {
-                rv = -9;
-            }
-            if (RoadSensor_Calc(dt) < 0) {
-                rv = -10;
-            }
-            if (TSignSensor_Calc(dt) < 0) {
-                rv = -11;
-            }
-            if (LineSensor_Calc(dt) < 0) {
-                rv = -14;
-            }
-            if (CollisionSensor_Calc(dt) < 0) {
-                rv = -15;
-            }
-            if (GNavSensor_Calc(dt) < 0) {
-                rv = -16;
-            }
-            if (PylonDetect_Calc(dt) < 0) {
-                rv = -13;
-            }
-            if (RadarSensor_Calc(dt) < 0) {
-                rv = -18;
-            }
-            if (USonicRSI_Calc(dt) < 0) {
-                rv = -19;
-            }
-            if (RadarRSI_Calc(dt) < 0) {
-                rv = -20;
-            }
-            if (LidarRSI_Calc(dt) < 0) {
-                rv = -22;
-            }
-            if (ObjByLane_Calc(dt) < 0) {
-                rv = -23;
-            }
-            if (CameraSensor_Calc(dt) < 0) {
-                rv = -40;
-            }
-            if (CameraRSI_Calc(dt) < 0) {
-                rv = -41;
-            }
+            rv = SensorSched_Calc(dt, rv);
         }
     }
 
     if (IN_USER_PART(part)) {
+        CYCLEPROF_RESTART(cpT);
         UserCalcCalledByAppTestRunCalc = 1;
         if (User_Calc(dt) < 0) {
             rv = -4;
         }
         UserCalcCalledByAppTestRunCalc = 0;
+#if !defined(CM_NO_XCP)
         if (CM_XCP_Calc() != 0) {
             if (SimCore.State == SCState_StartSim) {
                 SimCore.Start.IsReady = 0;
@@ -887,6 +961,9 @@ App_TestRun_Calc_Part(double dt, CyclePart_t part)
                 SimCore.Start.IsReady = 0;
             }
         }
+#endif
+        CYCLEPROF_LAP(CPSlot_User, cpT);
+        CYCLEPROF_PUBLISH();
 
         /* Delayed return of the real return code! */
         return rv;
@@ -913,7 +990,10 @@ App_TestRun_End(void *arg)
         Vhcl_Snapshot_Export2Inf();
     }
 
+    CYCLEPROF_DUMP();
+#if !defined(CM_NO_XCP)
     CM_XCP_TestRun_End();
+#endif
     User_TestRun_End();
     ADASRP_StopClient();
 
@@ -922,15 +1002,19 @@ App_TestRun_End(void *arg)
     Traffic_Delete();
     Surrounding_Cleanup();
     PylonDetect_Delete();
+#if !defined(CM_NO_SENSORS)
     RoadSensor_Delete();
     TSignSensor_Delete();
     LineSensor_Delete();
     RadarSensor_Delete();
     CameraSensor_Delete();
     GroundTruthSensor_Delete();
+#endif
 
     /* At the end free the Road-Handle after free all model own RoadEval-Handles before */
-    Env_Delete();
+    if (!EnvKeep_TestRun_End()) {
+        Env_Delete();
+    }
 
     SimCore_TestRun_End();
     SimCore.End.Tid = 0;
@@ -962,11 +1046,15 @@ App_ShutDown(int ShutDownForced)
 static void
 App_End(void)
 {
+#if !defined(CM_NO_XCP)
     CM_XCP_End();
     CM_CCP_End();
+#endif
     User_End();
 
+#if !defined(CM_NO_ADTF)
     ADTF_End();
+#endif
     DrivMan_Delete();
     ExtInp_File_Delete();
     TrfLight_Delete();
@@ -991,15 +1079,23 @@ App_Cleanup(void)
 {
     Plugins_Cleanup();
     CycControl_Cleanup();
+#if !defined(CM_NO_XCP)
     CM_XCP_Cleanup();
     CM_CCP_Cleanup();
+#endif
+#if !defined(CM_NO_BUSIF)
     RBS_Cleanup();
     SIP_Cleanup();
     FC_Cleanup();
     CANIf_Cleanup();
+#endif
     IO_Cleanup();
+#if !defined(CM_NO_ADTF)
     ADTF_Cleanup();
+#endif
     User_Cleanup();
+    SensorSched_Cleanup();
+#if !defined(CM_NO_SENSORS)
     GroundTruthSensor_CleanUp();
     ObjectSensor_Cleanup();
     RadarSensor_CleanUp();
@@ -1015,6 +1111,7 @@ App_Cleanup(void)
     LidarRSI_Cleanup();
     CameraSensor_Cleanup();
     CameraRSI_Cleanup();
+#endif
     Surrounding_Cleanup();
     BdyFrame_CleanUp();
     Traffic_Cleanup();
@@ -1026,7 +1123,9 @@ App_Cleanup(void)
     SimCore_Cleanup();
     LogCleanup();
     CMTh_Cleanup();
+#if !defined(CM_NO_SENSORS)
     SensorAssembly_Cleanup();
+#endif
 }
 
 /*** Main Program *************************************************************/
@@ -1062,6 +1161,11 @@ MainThread_Init(void)
         rv = -1;
     }
 
+    /*** Worker threads of the parallel sensor stage */
+    if (SensorSched_Init() < 0) {
+        rv = -1;
+    }
+
     /*** Add quantities to the data dictionary (can be displayed, saved)
      *   and export configuration
      */
@@ -1114,6 +1218,7 @@ MainThread_Init(void)
 #endif
     CycControl_InitSleepTS();
 
+#if !defined(CM_NO_BUSIF)
     if (FC_Start() < 0) {
         return -1;
     }
@@ -1125,6 +1230,10 @@ MainThread_Init(void)
     if (RBS_Start() != 0 || SIP_Start() != 0) {
         return -1;
     }
+#endif
+#if defined(CM_BATCH)
+    Log("CM4SL batch build\n");
+#endif
 
     if (SimCore.State == SCState_Idle) {
         char tmp[64];
@@ -1150,7 +1259,9 @@ MainThread_BeginCycle(unsigned long long CycleNo64)
 
     SimNet_WaitForSync();
 
-    /*** wait until cycle time passed */
+    /*** wait until cycle time passed
+     * Headless mode too: the cycles are clocked by Simulink and the time
+     * acceleration of the CarMaker session, this isn't a loop of our own */
     if ((DeltaT = SimCore_WaitForNextLoop(CycleNo64)) <= 0) {
         return 1;
     }
@@ -1178,18 +1289,26 @@ MainThread_BeginCycle(unsigned long long CycleNo64)
         ADASRP_Receive();
 
         /*** Input from hardware */
+#if !defined(CM_NO_BUSIF)
         CANIf_In((unsigned) CycleNo64);
         FC_In((unsigned) CycleNo64);
+#endif
         IO_In((unsigned) CycleNo64);
         RMA_In();
+#if !defined(CM_NO_BUSIF)
         RBS_In((unsigned) CycleNo64);
         SIP_In((unsigned) CycleNo64);
+#endif
+#if !defined(CM_NO_XCP)
         CM_XCP_In();
         CM_CCP_In();
+#endif
         Plugins_CalcBefore(DVA_IO_In, SimCore.DeltaT);
         DVA_HandleWriteAccess(DVA_IO_In);
         Plugins_CalcAfter(DVA_IO_In, SimCore.DeltaT);
+#if !defined(CM_NO_ADTF)
         ADTF_In();
+#endif
         SimNet_In();
         User_In((unsigned) CycleNo64);
         SessionCmds_Eval();
@@ -1206,7 +1325,8 @@ MainThread_DoCycle(unsigned long long CycleNo64, CyclePart_t part)
     static int RampingDone;
     int        rv;
 
-    while (SimCore.Anim.Sync_State != SyncOff && SimCore.State == SCState_Simulate) {
+    while (SimCore.Anim.Sync_State != SyncOff && SimCore.State == SCState_Simulate
+           && !(UserHeadless && !GPUSensorsUsed)) {
         if (SimCore_SyncVDS_Eval() == 0 || SysGetTime() - SimCore.Cycle.TimeWCAbs > 0.25) {
             break;
         }
@@ -1246,7 +1366,10 @@ MainThread_DoCycle(unsigned long long CycleNo64, CyclePart_t part)
 
         case SCState_StartWaitAnim:
             User_Calc(DeltaT);
-            if (SimCore.TimeWC <= SimCore.Anim.Wait_UntilWC) {
+            if (UserHeadless && !GPUSensorsUsed) {
+                /* no animation clients to wait for */
+                SimCore_State_Set(SCState_StartSim);
+            } else if (SimCore.TimeWC <= SimCore.Anim.Wait_UntilWC) {
                 if (SimCore_GPUSensor_AllReady() && SimCore_AnmWait_NoneRegistered()) {
                     SimCore_State_Set(SCState_StartSim);
                 }
@@ -1271,7 +1394,9 @@ MainThread_DoCycle(unsigned long long CycleNo64, CyclePart_t part)
                         User_Calc(DeltaT);
                         RampingDone = User_TestRun_RampUp(DeltaT);
                         RampingDone = SimCore_TestRun_RampUp() && RampingDone;
+#if !defined(CM_NO_ADTF)
                         RampingDone = ADTF_IsReady() && RampingDone;
+#endif
                     } else {
                         SimCore.Start.IsReady = 1;
                         calcfailed            = 0;
@@ -1501,19 +1626,29 @@ MainThread_FinishCycle(unsigned long long CycleNo64)
     if (SimCore_InSyncWithVDS()) {
         TestMgrCmds_Eval();
         User_Out((unsigned) CycleNo64); /* -> IO */
+#if !defined(CM_NO_BUSIF)
         RBS_OutMap((unsigned) CycleNo64);
         SIP_OutMap((unsigned) CycleNo64);
+#endif
         SimNet_Out();
         Plugins_CalcBefore(DVA_IO_Out, SimCore.DeltaT);
         DVA_HandleWriteAccess(DVA_IO_Out);
         Plugins_CalcAfter(DVA_IO_Out, SimCore.DeltaT);
+#if !defined(CM_NO_ADTF)
         ADTF_Out();
+#endif
+#if !defined(CM_NO_XCP)
         CM_XCP_Out((unsigned) CycleNo64);
+#endif
+#if !defined(CM_NO_BUSIF)
         RBS_Out((unsigned) CycleNo64);
         SIP_Out((unsigned) CycleNo64);
+#endif
         RMA_Out();
         IO_Out((unsigned) CycleNo64); /* IO -> Hardware */
+#if !defined(CM_NO_BUSIF)
         CANIf_Out((unsigned) CycleNo64);
+#endif
         ADASRP_Send();
 
         if (SimCore.State == SCState_Simulate) {
@@ -1526,6 +1661,7 @@ MainThread_FinishCycle(unsigned long long CycleNo64)
                 }
             }
         }
+        Telemetry_Publish(CycleNo64);
     }
 
     /* APO-Server: Poll -- evaluate messages from clients */
@@ -1534,10 +1670,14 @@ MainThread_FinishCycle(unsigned long long CycleNo64)
     ProcessApoMessages();
 
     /* APO-Server: Send, generate and send messages to clients */
+#if !defined(CM_NO_XCP)
     CM_XCP_ApoMsg_Send(TimeGlobal, (unsigned) CycleNo64);
     CM_CCP_ApoMsg_Send(TimeGlobal, (unsigned) CycleNo64);
+#endif
     User_ApoMsg_Send(TimeGlobal, (unsigned) CycleNo64);
+#if !defined(CM_NO_ADTF)
     ADTF_ApoMsg_Send();
+#endif
     SimCore_ApoMsg_Send(TimeGlobal, (unsigned) CycleNo64);
 }
 
@@ -1607,12 +1747,14 @@ CM_Main_Begin(int argc, char **argv, struct ApopxInfo_t *apopxinfo, struct CMShl
         char MsgBuf[APO_ADMMAX];
         int  ch, len, who;
         while (AposGetAppMsgFrom(&ch, &MsgBuf, &len, &who) != 0) {
+#if !defined(CM_NO_XCP)
             if (CM_XCP_ApoMsg_Eval(ch, MsgBuf, len) >= 0) {
                 continue;
             }
             if (CM_CCP_ApoMsg_Eval(ch, MsgBuf, len) >= 0) {
                 continue;
             }
+#endif
             SimCore_ApoMsg_Eval(ch, MsgBuf, len, who);
         }
     }
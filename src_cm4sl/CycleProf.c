@@ -0,0 +1,257 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Cycle profiling of App_TestRun_Calc_Part() (see CycleProf.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - CycleProf_Now ()
+ * - CycleProf_Add ()
+ * - CycleProf_DeclQuants ()
+ * - CycleProf_Reset ()
+ * - CycleProf_Publish ()
+ * - CycleProf_Dump ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include "CycleProf.h"
+
+#if defined(CM_CYCLEPROF)
+
+#if defined(WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <CarMaker.h>
+
+/* 4 log buckets per octave, bucket 159 ~ 1100 s */
+#define CP_NBUCKETS        160
+/* Publish the DDict quantities every n calls of CycleProf_Publish() */
+#define CP_PUBLISH_CYCLES  1000
+
+static char const *SlotName[CPSlot_Count] = {
+    "Env", "DrivMan", "VehicleControl", "VehicleControlUpd", "Vhcl", "User",
+    "BdyFrame", "InertialSensor", "SAngleSensor", "ObjectSensor",
+    "GroundTruthSensor", "FSpaceSensor", "RoadSensor", "TSignSensor",
+    "LineSensor", "CollisionSensor", "GNavSensor", "PylonDetect",
+    "RadarSensor", "USonicRSI", "RadarRSI", "LidarRSI", "ObjByLane",
+    "CameraSensor", "CameraRSI", "SensorStage"
+};
+
+static struct {
+    unsigned long long n;
+    unsigned long long Sum;       /* ns */
+    unsigned long long Max;       /* ns */
+    unsigned int       Hist[CP_NBUCKETS];
+} Slot[CPSlot_Count];
+
+/* Published values, us */
+static struct {
+    double Mean, P95, Max;
+} Pub[CPSlot_Count];
+
+static unsigned PublishCnt;
+
+#if defined(WIN32)
+static LARGE_INTEGER QPCFreq;
+#endif
+
+tCycleProfTick
+CycleProf_Now(void)
+{
+#if defined(WIN32)
+    LARGE_INTEGER c;
+    QueryPerformanceCounter(&c);
+    return (tCycleProfTick) (c.QuadPart / QPCFreq.QuadPart) * 1000000000ULL
+        + (tCycleProfTick) (c.QuadPart % QPCFreq.QuadPart) * 1000000000ULL / QPCFreq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (tCycleProfTick) ts.tv_sec * 1000000000ULL + (tCycleProfTick) ts.tv_nsec;
+#endif
+}
+
+static int
+Bucket(tCycleProfTick ns)
+{
+    int msb, idx;
+
+    if (ns < 4) {
+        return (int) ns;
+    }
+#if defined(__GNUC__)
+    msb = 63 - __builtin_clzll(ns);
+#else
+    for (msb = 2; (ns >> (msb + 1)) != 0; msb++)
+        ;
+#endif
+    idx = 4 * (msb - 1) + (int) ((ns >> (msb - 2)) & 3);
+    return idx < CP_NBUCKETS ? idx : CP_NBUCKETS - 1;
+}
+
+/* Bucket midpoint, ns */
+static double
+BucketValue(int idx)
+{
+    int msb;
+
+    if (idx < 4) {
+        return (double) idx;
+    }
+    msb = idx / 4 + 1;
+    return ((4 + idx % 4) + 0.5) * (double) (1ULL << (msb - 2));
+}
+
+static double
+Percentile(int s, double q)
+{
+    unsigned long long target, acc = 0;
+    int                i;
+
+    if (Slot[s].n == 0) {
+        return 0.0;
+    }
+    target = (unsigned long long) (q * (double) Slot[s].n);
+    for (i = 0; i < CP_NBUCKETS; i++) {
+        acc += Slot[s].Hist[i];
+        if (acc > target) {
+            break;
+        }
+    }
+    return BucketValue(i < CP_NBUCKETS ? i : CP_NBUCKETS - 1);
+}
+
+/*
+ * CycleProf_Add ()
+ *
+ * Call:
+ * - in RT context, via CYCLEPROF_LAP()
+ */
+
+void
+CycleProf_Add(tCycleProfSlot slot, tCycleProfTick ns)
+{
+    Slot[slot].n++;
+    Slot[slot].Sum += ns;
+    if (ns > Slot[slot].Max) {
+        Slot[slot].Max = ns;
+    }
+    Slot[slot].Hist[Bucket(ns)]++;
+}
+
+/*
+ * CycleProf_DeclQuants ()
+ *
+ * Call:
+ * - once at program start, App_DeclQuants()
+ */
+
+void
+CycleProf_DeclQuants(void)
+{
+    int  s;
+    char sbuf[64];
+
+#if defined(WIN32)
+    QueryPerformanceFrequency(&QPCFreq);
+#endif
+
+    for (s = 0; s < CPSlot_Count; s++) {
+        sprintf(sbuf, "CycleProf.%s.Mean", SlotName[s]);
+        DDefDouble(NULL, sbuf, "us", &Pub[s].Mean, DVA_None);
+        sprintf(sbuf, "CycleProf.%s.P95", SlotName[s]);
+        DDefDouble(NULL, sbuf, "us", &Pub[s].P95, DVA_None);
+        sprintf(sbuf, "CycleProf.%s.Max", SlotName[s]);
+        DDefDouble(NULL, sbuf, "us", &Pub[s].Max, DVA_None);
+    }
+}
+
+/*
+ * CycleProf_Reset ()
+ *
+ * Call:
+ * - RT context, App_TestRun_Start_Finalize()
+ */
+
+void
+CycleProf_Reset(void)
+{
+    memset(Slot, 0, sizeof(Slot));
+    memset(Pub, 0, sizeof(Pub));
+    PublishCnt = 0;
+}
+
+/*
+ * CycleProf_Publish ()
+ *
+ * Update the DDict quantities, every CP_PUBLISH_CYCLES calls.
+ *
+ * Call:
+ * - RT context, once per cycle
+ */
+
+void
+CycleProf_Publish(void)
+{
+    int s;
+
+    if (++PublishCnt < CP_PUBLISH_CYCLES) {
+        return;
+    }
+    PublishCnt = 0;
+
+    for (s = 0; s < CPSlot_Count; s++) {
+        if (Slot[s].n == 0) {
+            continue;
+        }
+        Pub[s].Mean = (double) Slot[s].Sum / (double) Slot[s].n * 1e-3;
+        Pub[s].P95  = Percentile(s, 0.95) * 1e-3;
+        Pub[s].Max  = (double) Slot[s].Max * 1e-3;
+    }
+}
+
+/*
+ * CycleProf_Dump ()
+ *
+ * Write the statistics of the Test Run to the log.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), App_TestRun_End()
+ */
+
+void
+CycleProf_Dump(void)
+{
+    int s;
+
+    Log("CycleProf: %-18s %10s %9s %9s %9s %9s %9s  [us]\n",
+        "Slot", "n", "mean", "p50", "p95", "p99", "max");
+    for (s = 0; s < CPSlot_Count; s++) {
+        if (Slot[s].n == 0) {
+            continue;
+        }
+        Log("CycleProf: %-18s %10llu %9.2f %9.2f %9.2f %9.2f %9.2f\n", SlotName[s], Slot[s].n,
+            (double) Slot[s].Sum / (double) Slot[s].n * 1e-3,
+            Percentile(s, 0.50) * 1e-3, Percentile(s, 0.95) * 1e-3,
+            Percentile(s, 0.99) * 1e-3, (double) Slot[s].Max * 1e-3);
+    }
+}
+
+#else
+
+/* ISO C forbids an empty translation unit */
+typedef int tCycleProf_Disabled;
+
+#endif /* CM_CYCLEPROF */
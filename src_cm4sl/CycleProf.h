@@ -0,0 +1,105 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Cycle profiling of App_TestRun_Calc_Part()
+ *
+ * Wall clock time of each cycle part and each sensor call is collected
+ * into a log-scale histogram per slot (4 buckets per octave, ~19%
+ * resolution). Once per second of simulation the statistics are
+ * published as DDict quantities
+ *	CycleProf.<Slot>.Mean / .P95 / .Max	[us]
+ * and at Test Run end a table with n, mean, p50, p95, p99 and max is
+ * written to the log.
+ *
+ * Compile with -DCM_CYCLEPROF to enable; otherwise all CYCLEPROF_*
+ * macros are empty and nothing is compiled in.
+ *
+ *****************************************************************************
+ */
+
+#ifndef _CYCLEPROF_H__
+#define _CYCLEPROF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    /* Cycle parts */
+    CPSlot_Env = 0,
+    CPSlot_DrivMan,
+    CPSlot_VehicleControl,
+    CPSlot_VehicleControlUpd,
+    CPSlot_Vhcl,
+    CPSlot_User,
+
+    /* Sensors after CyclePart_Vhcl_Last, in calling order */
+    CPSlot_BdyFrame,
+    CPSlot_InertialSensor,
+    CPSlot_SAngleSensor,
+    CPSlot_ObjectSensor,
+    CPSlot_GroundTruthSensor,
+    CPSlot_FSpaceSensor,
+    CPSlot_RoadSensor,
+    CPSlot_TSignSensor,
+    CPSlot_LineSensor,
+    CPSlot_CollisionSensor,
+    CPSlot_GNavSensor,
+    CPSlot_PylonDetect,
+    CPSlot_RadarSensor,
+    CPSlot_USonicRSI,
+    CPSlot_RadarRSI,
+    CPSlot_LidarRSI,
+    CPSlot_ObjByLane,
+    CPSlot_CameraSensor,
+    CPSlot_CameraRSI,
+
+    /* Parallel sensor stage as a whole (SensorSched.c) */
+    CPSlot_SensorStage,
+
+    CPSlot_Count
+} tCycleProfSlot;
+
+#if defined(CM_CYCLEPROF)
+
+typedef unsigned long long tCycleProfTick;   /* ns */
+
+tCycleProfTick CycleProf_Now(void);
+void           CycleProf_Add(tCycleProfSlot slot, tCycleProfTick ns);
+void           CycleProf_DeclQuants(void);
+void           CycleProf_Reset(void);
+void           CycleProf_Publish(void);
+void           CycleProf_Dump(void);
+
+/* Declare a time stamp variable and take the first stamp */
+# define CYCLEPROF_MARK(t)      tCycleProfTick t = CycleProf_Now()
+/* Account the time since the last stamp to slot, restart the stamp */
+# define CYCLEPROF_LAP(slot, t) \
+    do { tCycleProfTick _cp_now = CycleProf_Now(); CycleProf_Add(slot, _cp_now - (t)); (t) = _cp_now; } while (0)
+# define CYCLEPROF_RESTART(t)   ((t) = CycleProf_Now())
+
+# define CYCLEPROF_DECLQUANTS() CycleProf_DeclQuants()
+# define CYCLEPROF_RESET()      CycleProf_Reset()
+# define CYCLEPROF_PUBLISH()    CycleProf_Publish()
+# define CYCLEPROF_DUMP()       CycleProf_Dump()
+
+#else
+
+# define CYCLEPROF_MARK(t)
+# define CYCLEPROF_LAP(slot, t)
+# define CYCLEPROF_RESTART(t)
+# define CYCLEPROF_DECLQUANTS()
+# define CYCLEPROF_RESET()
+# define CYCLEPROF_PUBLISH()
+# define CYCLEPROF_DUMP()
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _CYCLEPROF_H__ */
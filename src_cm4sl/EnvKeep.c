@@ -0,0 +1,146 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Persistent road / environment across Test Runs (see EnvKeep.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - EnvKeep_Env_New ()
+ * - EnvKeep_TestRun_End ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <CarMaker.h>
+
+#include "EnvKeep.h"
+
+/* Test Run keys read by Env_New() */
+static char const *const EnvKeep_Prefix[] = { "Road.", "Env." };
+
+#define EK_NPREFIX ((int) (sizeof(EnvKeep_Prefix) / sizeof(EnvKeep_Prefix[0])))
+
+static struct {
+    int                Active;  /* EnvKeep.Active of the current Test Run */
+    int                Loaded;  /* environment of Fp is still loaded */
+    unsigned long long Fp;
+    int                nReused;
+} EK;
+
+/* FNV-1a, including the terminating '\0' as separator */
+static unsigned long long
+Hash_Str(unsigned long long h, char const *s)
+{
+    do {
+        h ^= (unsigned char) *s;
+        h *= 1099511628211ULL;
+    } while (*s++ != '\0');
+    return h;
+}
+
+static unsigned long long
+Fingerprint(struct tInfos *Inf)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    int                p, i, j;
+
+    for (p = 0; p < EK_NPREFIX; p++) {
+        char **keys = InfoListKeys(Inf, EnvKeep_Prefix[p], 0);
+
+        if (keys == NULL) {
+            continue;
+        }
+        for (i = 0; keys[i] != NULL; i++) {
+            char const *s = iGetStrOpt(Inf, keys[i], NULL);
+
+            h = Hash_Str(h, keys[i]);
+            if (s != NULL) {
+                h = Hash_Str(h, s);
+            } else {
+                char **txt = iGetTxtOpt(Inf, keys[i], NULL);
+                for (j = 0; txt != NULL && txt[j] != NULL; j++) {
+                    h = Hash_Str(h, txt[j]);
+                }
+            }
+        }
+        free(keys);
+    }
+    return h;
+}
+
+/*
+ * EnvKeep_Env_New ()
+ *
+ * Env_New(), unless the environment kept from the Test Run before has
+ * the same fingerprint. A kept environment that doesn't match is
+ * deleted first. Returns the result of Env_New(), 0 if reused.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - App_TestRun_Start(), instead of Env_New()
+ */
+
+int
+EnvKeep_Env_New(struct tInfos *Inf)
+{
+    unsigned long long fp = 0;
+    int                rv;
+
+    EK.Active = iGetIntOpt(Inf, "EnvKeep.Active", 0) != 0;
+    if (EK.Active || EK.Loaded) {
+        fp = Fingerprint(Inf);
+    }
+
+    if (EK.Loaded) {
+        if (EK.Active && fp == EK.Fp) {
+            if (EK.nReused++ == 0) {
+                Log("EnvKeep: environment reused\n");
+            }
+            return 0;
+        }
+        Log("EnvKeep: %s, environment read in again\n", EK.Active ? "road/environment changed" : "not active");
+        Env_Delete();
+        EK.Loaded  = 0;
+        EK.nReused = 0;
+    }
+
+    if ((rv = Env_New()) < 0) {
+        return rv;
+    }
+    if (EK.Active) {
+        EK.Loaded = 1;
+        EK.Fp     = fp;
+    }
+    return rv;
+}
+
+/*
+ * EnvKeep_TestRun_End ()
+ *
+ * Returns 1 if the environment stays loaded for the next Test Run,
+ * 0 if App_TestRun_End() deletes it.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - App_TestRun_End(), instead of Env_Delete()
+ */
+
+int
+EnvKeep_TestRun_End(void)
+{
+    if (EK.Active && EK.Loaded) {
+        return 1;
+    }
+    EK.Loaded  = 0;
+    EK.nReused = 0;
+    return 0;
+}
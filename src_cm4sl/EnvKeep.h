@@ -0,0 +1,44 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Persistent road / environment across Test Runs
+ *
+ * App_TestRun_End() deletes the environment (Env_Delete()) after every
+ * Test Run and the next App_TestRun_Start() reads in and preprocesses
+ * the same road again. With EnvKeep.Active = 1 the environment stays
+ * loaded at the end of a Test Run. The next Test Run reuses it if the
+ * fingerprint of its Road.* and Env.* keys is the same, otherwise the
+ * kept environment is deleted and the new one is read in. Vehicle,
+ * driver, traffic and sensors are rebuilt as before.
+ *
+ * Only for static scenes (skidpad, track without road events): a
+ * reused environment continues with the state of the run before, and
+ * a road file that changed on disk under the same name isn't noticed.
+ * Only useful with a persistent CM_Office session.
+ *
+ * Test Run Info File keys:
+ *	EnvKeep.Active = 1	keep the environment for the next Test Run
+ *
+ *****************************************************************************
+ */
+
+#ifndef _ENVKEEP_H__
+#define _ENVKEEP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+int  EnvKeep_Env_New(struct tInfos *Inf);
+int  EnvKeep_TestRun_End(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ENVKEEP_H__ */
@@ -0,0 +1,305 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Hot parameter injection (see HotParam.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - HotParam_Eval ()
+ * - HotParam_ApoMsg_Eval ()
+ * - HotParam_Poll ()
+ * - HotParam_TestRun_Start_atBegin ()
+ * - HotParam_TestRun_End_First ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <CarMaker.h>
+
+#include "HotParam.h"
+#include "ResultLink.h"
+
+typedef enum {
+    HPTarget_Vhcl = 0,
+    HPTarget_TestRun
+} tHPTarget;
+
+typedef struct {
+    int nKeys;
+    struct {
+        tHPTarget Target;
+        int       Key;        /* offsets into Text */
+        int       Val;
+    } Item[HOTPARAM_MAXKEYS];
+    int  TextLen;
+    char Text[HOTPARAM_MSGMAX];
+} tHPOverlay;
+
+static tHPOverlay Pending;    /* used by the next start */
+static tHPOverlay Parse;      /* message being parsed */
+static int        Applied;    /* keys applied in the current Test Run */
+
+static char Line[HOTPARAM_MSGMAX];
+
+static int
+IsHotParamMsg(char const *Msg, int len)
+{
+    return len >= 8 && strncmp(Msg, "HotParam", 8) == 0
+        && (len == 8 || Msg[8] == ' ' || Msg[8] == '\t' || Msg[8] == '\r' || Msg[8] == '\n');
+}
+
+static int
+AddText(tHPOverlay *ov, char const *s, int n)
+{
+    if (ov->TextLen + n + 1 > (int) sizeof(ov->Text)) {
+        return -1;
+    }
+    memcpy(ov->Text + ov->TextLen, s, n);
+    ov->TextLen += n;
+    ov->Text[ov->TextLen] = '\0';
+    return 0;
+}
+
+static char *
+Trim(char *s)
+{
+    char *e;
+
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    for (e = s + strlen(s); e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'); e--)
+        ;
+    *e = '\0';
+    return s;
+}
+
+/* "<Vhcl|TestRun> <key> = <value>" or "<Vhcl|TestRun> <key>:" */
+static int
+ParseKeyLine(tHPOverlay *ov, char *s, int *multiline)
+{
+    char *key, *val, *sep;
+    int   i = ov->nKeys;
+
+    if (ov->nKeys >= HOTPARAM_MAXKEYS) {
+        return -1;
+    }
+    if (strncmp(s, "Vhcl ", 5) == 0) {
+        ov->Item[i].Target = HPTarget_Vhcl;
+        key = s + 5;
+    } else if (strncmp(s, "TestRun ", 8) == 0) {
+        ov->Item[i].Target = HPTarget_TestRun;
+        key = s + 8;
+    } else {
+        return -1;
+    }
+
+    if ((sep = strpbrk(key, "=:")) == NULL) {
+        return -1;
+    }
+    *multiline = *sep == ':';
+    val        = sep + 1;
+    *sep       = '\0';
+    key        = Trim(key);
+    val        = Trim(val);
+    if (*key == '\0' || strpbrk(key, " \t") != NULL || (*multiline && *val != '\0')) {
+        return -1;
+    }
+
+    ov->Item[i].Key = ov->TextLen;
+    if (AddText(ov, key, (int) strlen(key) + 1) < 0) {
+        return -1;
+    }
+    ov->Item[i].Val = ov->TextLen;
+    if (AddText(ov, val, (int) strlen(val)) < 0) {
+        return -1;
+    }
+    ov->nKeys++;
+    return 0;
+}
+
+/*
+ * HotParam_Eval ()
+ *
+ * Parse a HotParam message; it replaces the pending overlay if it is
+ * well-formed.
+ *
+ * Return:
+ *   >=0 : number of keys in the overlay
+ *    -1 : message rejected
+ *
+ * Call:
+ * - in the main loop
+ */
+
+int
+HotParam_Eval(char const *Msg, int len)
+{
+    char *s, *next;
+    int   multiline = 0, first = 1;
+
+    if (!IsHotParamMsg(Msg, len)) {
+        return -1;
+    }
+    if (SimCore.State == SCState_Start) {
+        /* start thread may be reading the overlay */
+        LogWarnF(EC_General, "HotParam: message ignored while starting a Test Run");
+        return -1;
+    }
+    if (len >= (int) sizeof(Line)) {
+        LogWarnF(EC_General, "HotParam: message too long (%d bytes)", len);
+        return -1;
+    }
+    memcpy(Line, Msg, len);
+    Line[len] = '\0';
+    Parse.nKeys   = 0;
+    Parse.TextLen = 0;
+
+    for (s = Line; s != NULL; s = next) {
+        if ((next = strchr(s, '\n')) != NULL) {
+            *next++ = '\0';
+        }
+
+        if (first) {
+            /* "HotParam" header line */
+            first = 0;
+            continue;
+        }
+
+        if (multiline && (*s == '\t' || *s == ' ')) {
+            /* row of a multi-line value */
+            char *row = Trim(s);
+            if (*row == '\0') {
+                continue;
+            }
+            if ((Parse.Text[Parse.TextLen - 1] != '\0' && AddText(&Parse, "\n", 1) < 0)
+                || AddText(&Parse, row, (int) strlen(row)) < 0) {
+                goto BadMsg;
+            }
+            continue;
+        }
+        if (*Trim(s) == '\0') {
+            continue;
+        }
+        if (AddText(&Parse, "", 1) < 0 || ParseKeyLine(&Parse, Trim(s), &multiline) < 0) {
+            goto BadMsg;
+        }
+    }
+
+    memcpy(&Pending, &Parse, sizeof(Pending));
+    return Pending.nKeys;
+
+BadMsg:
+    LogWarnF(EC_General, "HotParam: malformed message, line '%.60s'", s);
+    return -1;
+}
+
+/*
+ * HotParam_ApoMsg_Eval ()
+ *
+ * Return:
+ *   0 : message evaluated
+ *  -1 : message not handled
+ *
+ * Call:
+ * - in the main loop, User_ApoMsg_Eval()
+ */
+
+int
+HotParam_ApoMsg_Eval(int Ch, char const *Msg, int len)
+{
+    if (Ch != ApoCh_CarMaker || !IsHotParamMsg(Msg, len)) {
+        return -1;
+    }
+    HotParam_Eval(Msg, len);
+    return 0;
+}
+
+/*
+ * HotParam_Poll ()
+ *
+ * Read HotParam messages sent to the ResultLink socket and acknowledge them.
+ *
+ * Call:
+ * - in the main loop, User_ApoMsg_Send()
+ */
+
+void
+HotParam_Poll(unsigned CycleNo)
+{
+    static char Rx[HOTPARAM_MSGMAX];
+    char        ack[64];
+    int         n;
+
+    if (CycleNo % HOTPARAM_POLLCYCLES != 0) {
+        return;
+    }
+    while ((n = ResultLink_Recv(Rx, sizeof(Rx))) > 0) {
+        if (!IsHotParamMsg(Rx, n)) {
+            continue;
+        }
+        sprintf(ack, "{\"Tag\": \"HotParam\", \"HotParam.n\": %d}\n", HotParam_Eval(Rx, n));
+        ResultLink_Reply(ack);
+    }
+}
+
+/*
+ * HotParam_TestRun_Start_atBegin ()
+ *
+ * Write the pending overlay into the vehicle and Test Run Info File
+ * handles. Used once, the overlay is cleared.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), User_TestRun_Start_atBegin()
+ * - after the Info Files are read in, before Vhcl_New()
+ */
+
+int
+HotParam_TestRun_Start_atBegin(void)
+{
+    int i, rv = 0;
+
+    Applied = 0;
+    if (Pending.nKeys == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < Pending.nKeys; i++) {
+        struct tInfos *inf = Pending.Item[i].Target == HPTarget_Vhcl
+            ? SimCore.Vhcl.Inf : SimCore.TestRun.Inf;
+        char const    *key = Pending.Text + Pending.Item[i].Key;
+
+        if (InfoSetStr(inf, key, Pending.Text + Pending.Item[i].Val) < 0) {
+            LogErrF(EC_Init, "HotParam: can't set '%s'", key);
+            rv = -1;
+        } else {
+            Applied++;
+        }
+    }
+    Log("HotParam: %d key(s) applied\n", Applied);
+
+    Pending.nKeys = 0;
+    return rv;
+}
+
+/*
+ * HotParam_TestRun_End_First ()
+ *
+ * Call:
+ * - in main task (realtime conditions), User_TestRun_End_First()
+ */
+
+void
+HotParam_TestRun_End_First(void)
+{
+    ResultLink_Add("HotParam.n", Applied);
+}
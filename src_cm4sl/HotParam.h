@@ -0,0 +1,69 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Hot parameter injection: an overlay of changed keys, applied on restart
+ *
+ * The optimizer sends only the parameters that differ from the vehicle
+ * data set of the session's last cold trial (SuspF.Spring, SuspR.Stabi,
+ * ...) and the trial's TestRun keys. They are kept as an overlay and
+ * written into the Info File handles with InfoSetStr() in
+ * User_TestRun_Start_atBegin(), i.e. after the Info Files are read in
+ * and before Vhcl_New() parses them.
+ *
+ * Every hot trial restarts the loaded Test Run (StartSim), and the
+ * restart reads the Test Run and vehicle files again (with EnvKeep.Active,
+ * EnvKeep.h, not the road). A hot trial saves the LoadTestRun, the vehicle
+ * copy into the project and the trial's TestRun file of a cold trial; the
+ * optimizer still writes the trial's vehicle file to compute the diff.
+ * A vehicle reconfiguration (SimCore.Reconfig) isn't used: it needs a
+ * running simulation and continues its time, route position and driver
+ * state, while a trial has to start a new lap.
+ *
+ * Message (text, one per datagram / APO message):
+ *	HotParam
+ *	<Vhcl|TestRun> <key> = <value>
+ *	<Vhcl|TestRun> <key>:
+ *		<row>			multi-line value, as in the Info File
+ *	...
+ * Each message replaces the pending overlay; no key lines clear it.
+ * TestRun keys are seen by the app's own modules only (ResultLink.Tag,
+ * Prune.*, BinExport.*, ...), they are read after the overlay.
+ *
+ * Transport:
+ * - APO message on ApoCh_CarMaker, User_ApoMsg_Eval()
+ * - datagram to the ResultLink socket (the optimizer answers to the
+ *   address the results come from), acknowledged with
+ *	{"Tag": "HotParam", "HotParam.n": <number of keys, -1 = rejected>}
+ *
+ * The number of keys applied is reported as HotParam.n with the
+ * ResultLink message.
+ *
+ *****************************************************************************
+ */
+
+#ifndef _HOTPARAM_H__
+#define _HOTPARAM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOTPARAM_MAXKEYS    128
+#define HOTPARAM_MSGMAX     16384
+/* Poll the ResultLink socket every n main loop cycles */
+#define HOTPARAM_POLLCYCLES 10
+
+int  HotParam_Eval(char const *Msg, int len);
+int  HotParam_ApoMsg_Eval(int Ch, char const *Msg, int len);
+void HotParam_Poll(unsigned CycleNo);
+int  HotParam_TestRun_Start_atBegin(void);
+void HotParam_TestRun_End_First(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _HOTPARAM_H__ */
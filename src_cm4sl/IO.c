@@ -22,6 +22,13 @@
  * - CalOut ()
  * - CalOutF ()
  * - LimitInt ()
+ * - iGetCalVec ()
+ * - CalVec_Delete ()
+ * - CalInVec ()
+ * - CalInVecF ()
+ * - CalOutVec ()
+ * - CalOutVecF ()
+ * - IO_CalBench ()
  * - IO_Init_First ()
  * - IO_Init_Finalize ()
  * - IO_Init ()
@@ -52,6 +59,11 @@
 # include <FailSafeTester.h>
 #endif /* defined(CM_HIL) */
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define CAL_SSE2
+#endif
+
 #include "IOVec.h"
 
 /*** I/O vector */
@@ -197,6 +209,421 @@ LimitInt(float fValue, int Min, int Max)
     return Value;
 }
 
+/*
+ * iGetCalVec()
+ *
+ * Read the calibration parameters of n channels into a struct of arrays,
+ * keys[i] as for iGetCal(). A table loaded before is released first, cv
+ * must be zeroed before the first call.
+ *
+ * Return:
+ *   0 : ok
+ *  -1 : out of memory
+ */
+
+int
+iGetCalVec(tInfos *Inf, char const *const *keys, int n, tCalVec *cv, int optional)
+{
+    tCal  cal;
+    float *mem;
+    int   i;
+
+    CalVec_Delete(cv);
+    if (n <= 0) {
+        return 0;
+    }
+    if ((mem = (float *) malloc(7 * n * sizeof(float))) == NULL) {
+        LogErrF(EC_Init, "Calibration table: out of memory (%d channels)", n);
+        return -1;
+    }
+
+    cv->n         = n;
+    cv->Min       = mem;
+    cv->Max       = mem + 1 * n;
+    cv->LimitLow  = mem + 2 * n;
+    cv->LimitHigh = mem + 3 * n;
+    cv->Factor    = mem + 4 * n;
+    cv->Offset    = mem + 5 * n;
+    cv->Rezip     = (unsigned *) (mem + 6 * n);
+
+    for (i = 0; i < n; i++) {
+        iGetCal(Inf, keys[i], &cal, optional);
+        cv->Min[i]       = cal.Min;
+        cv->Max[i]       = cal.Max;
+        cv->LimitLow[i]  = cal.LimitLow;
+        cv->LimitHigh[i] = cal.LimitHigh;
+        cv->Factor[i]    = cal.Factor;
+        cv->Offset[i]    = cal.Offset;
+        cv->Rezip[i]     = cal.Rezip ? ~0u : 0u;
+    }
+    return 0;
+}
+
+void
+CalVec_Delete(tCalVec *cv)
+{
+    if (cv->Min != NULL) {
+        free(cv->Min);
+    }
+    memset(cv, 0, sizeof(*cv));
+}
+
+/*
+ * CalInVecF() / CalInVec()
+ *
+ * CalInF() for all channels of cv, In[i] -> Out[i].
+ *
+ * As in CalInF(), Max is only updated if the value is not below Min
+ * and the upper limit only applies if the value is not below the lower
+ * one; the masks below keep this order. The reciprocal is computed
+ * with a true division (no rcpps), 1 / 1 on the channels without Rezip.
+ *
+ * Call:
+ * - in the main loop, IO_In()
+ */
+
+#if defined(CAL_SSE2)
+/* m ? a : b, m all ones or all zeros per lane */
+# define CAL_SEL(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#endif
+
+void
+CalInVecF(tCalVec *cv, float const *In, float *Out)
+{
+    int i = 0;
+
+#if defined(CAL_SSE2)
+    __m128 const one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= cv->n; i += 4) {
+        __m128 rez = _mm_castsi128_ps(_mm_loadu_si128((__m128i const *) (cv->Rezip + i)));
+        __m128 r   = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(In + i), _mm_loadu_ps(cv->Offset + i)),
+                                _mm_loadu_ps(cv->Factor + i));
+        __m128 mn, mx, lo, hi, lt, gt;
+
+        r  = CAL_SEL(rez, _mm_div_ps(one, CAL_SEL(rez, r, one)), r);
+
+        mn = _mm_loadu_ps(cv->Min + i);
+        mx = _mm_loadu_ps(cv->Max + i);
+        lt = _mm_cmplt_ps(r, mn);
+        gt = _mm_andnot_ps(lt, _mm_cmpgt_ps(r, mx));
+        _mm_storeu_ps(cv->Min + i, CAL_SEL(lt, r, mn));
+        _mm_storeu_ps(cv->Max + i, CAL_SEL(gt, r, mx));
+
+        lo = _mm_loadu_ps(cv->LimitLow + i);
+        hi = _mm_loadu_ps(cv->LimitHigh + i);
+        lt = _mm_cmplt_ps(r, lo);
+        gt = _mm_andnot_ps(lt, _mm_cmpgt_ps(r, hi));
+        _mm_storeu_ps(Out + i, CAL_SEL(lt, lo, CAL_SEL(gt, hi, r)));
+    }
+#endif
+
+    for (; i < cv->n; i++) {
+        float r = (In[i] - cv->Offset[i]) * cv->Factor[i];
+        int   lt, gt;
+
+        r  = cv->Rezip[i] ? 1.0f / r : r;
+
+        lt = r < cv->Min[i];
+        gt = !lt && r > cv->Max[i];
+        cv->Min[i] = lt ? r : cv->Min[i];
+        cv->Max[i] = gt ? r : cv->Max[i];
+
+        lt = r < cv->LimitLow[i];
+        gt = !lt && r > cv->LimitHigh[i];
+        Out[i] = lt ? cv->LimitLow[i] : gt ? cv->LimitHigh[i] : r;
+    }
+}
+
+void
+CalInVec(tCalVec *cv, int const *In, float *Out)
+{
+    int i;
+
+    for (i = 0; i < cv->n; i++) {
+        Out[i] = (float) In[i];
+    }
+    CalInVecF(cv, Out, Out);
+}
+
+/*
+ * CalOutVecF() / CalOutVec()
+ *
+ * CalOutF() for all channels of cv, In[i] -> Out[i].
+ * Rezip:  1 / (Value * Factor) + Offset
+ * else:   Value / Factor + Offset
+ * as one division with selected numerator and denominator.
+ *
+ * Call:
+ * - in the main loop, IO_Out()
+ */
+
+void
+CalOutVecF(tCalVec *cv, float const *In, float *Out)
+{
+    int i = 0;
+
+#if defined(CAL_SSE2)
+    __m128 const one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= cv->n; i += 4) {
+        __m128 rez = _mm_castsi128_ps(_mm_loadu_si128((__m128i const *) (cv->Rezip + i)));
+        __m128 v   = _mm_loadu_ps(In + i);
+        __m128 f   = _mm_loadu_ps(cv->Factor + i);
+        __m128 mn, mx, lo, hi, lt, gt;
+
+        mn = _mm_loadu_ps(cv->Min + i);
+        mx = _mm_loadu_ps(cv->Max + i);
+        lt = _mm_cmplt_ps(v, mn);
+        gt = _mm_andnot_ps(lt, _mm_cmpgt_ps(v, mx));
+        _mm_storeu_ps(cv->Min + i, CAL_SEL(lt, v, mn));
+        _mm_storeu_ps(cv->Max + i, CAL_SEL(gt, v, mx));
+
+        lo = _mm_loadu_ps(cv->LimitLow + i);
+        hi = _mm_loadu_ps(cv->LimitHigh + i);
+        lt = _mm_cmplt_ps(v, lo);
+        gt = _mm_andnot_ps(lt, _mm_cmpgt_ps(v, hi));
+        v  = CAL_SEL(lt, lo, CAL_SEL(gt, hi, v));
+
+        v  = _mm_div_ps(CAL_SEL(rez, one, v), CAL_SEL(rez, _mm_mul_ps(v, f), f));
+        _mm_storeu_ps(Out + i, _mm_add_ps(v, _mm_loadu_ps(cv->Offset + i)));
+    }
+#endif
+
+    for (; i < cv->n; i++) {
+        float v = In[i];
+        int   lt, gt;
+
+        lt = v < cv->Min[i];
+        gt = !lt && v > cv->Max[i];
+        cv->Min[i] = lt ? v : cv->Min[i];
+        cv->Max[i] = gt ? v : cv->Max[i];
+
+        lt = v < cv->LimitLow[i];
+        gt = !lt && v > cv->LimitHigh[i];
+        v  = lt ? cv->LimitLow[i] : gt ? cv->LimitHigh[i] : v;
+
+        Out[i] = (cv->Rezip[i] ? 1.0f / (v * cv->Factor[i]) : v / cv->Factor[i]) + cv->Offset[i];
+    }
+}
+
+void
+CalOutVec(tCalVec *cv, float const *In, int *Out)
+{
+    float buf[64];
+    int   i, j, n = cv->n;
+
+    /* in blocks, the table pointers are advanced on a copy of cv */
+    for (i = 0; i < n; i += 64) {
+        tCalVec blk = *cv;
+        blk.n          = n - i < 64 ? n - i : 64;
+        blk.Min       += i;
+        blk.Max       += i;
+        blk.LimitLow  += i;
+        blk.LimitHigh += i;
+        blk.Factor    += i;
+        blk.Offset    += i;
+        blk.Rezip     += i;
+        CalOutVecF(&blk, In + i, buf);
+        for (j = 0; j < blk.n; j++) {
+            Out[i + j] = (int) buf[j];
+        }
+    }
+}
+
+#if defined(CM_CALBENCH)
+
+/*
+ * IO_CalBench ()
+ *
+ * Microbenchmark of the calibration, n channels: CalInF() / CalOutF()
+ * in a loop over tCal against CalInVecF() / CalOutVecF(). First all
+ * results and Min / Max are compared bit by bit, then both paths are
+ * timed over nCycles cycles. Output to stdout.
+ *
+ * Return:
+ *   number of mismatches
+ *
+ * Call:
+ * - command line option -calbench <n>, before the application starts
+ * - only built with -DCM_CALBENCH
+ */
+
+#define CALBENCH_NVEC 16
+
+static unsigned CalBenchSeed;
+
+static float
+CalBenchRand(float lo, float hi)
+{
+    CalBenchSeed = CalBenchSeed * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float) (CalBenchSeed >> 8) / 16777216.0f;
+}
+
+static int
+CalBenchCmp(char const *what, float const *a, float const *b, int n)
+{
+    int i, nBad = 0;
+
+    for (i = 0; i < n; i++) {
+        if (memcmp(a + i, b + i, sizeof(float)) != 0) {
+            if (nBad++ < 4) {
+                printf("CalBench: %s mismatch, channel %d: %.9g != %.9g\n", what, i, a[i], b[i]);
+            }
+        }
+    }
+    return nBad;
+}
+
+#endif /* defined(CM_CALBENCH) */
+
+int
+IO_CalBench(int n, int nCycles)
+{
+    static char const *Phase[2] = { "CalIn", "CalOut" };
+    tInfos           *inf  = NULL;
+    tCal             *cal  = NULL;
+    tCalVec           cv;
+    char            (*kbuf)[32] = NULL;
+    char const      **keys = NULL;
+    float            *inA  = NULL, *inB = NULL, *out = NULL, *vout = NULL, *tmp = NULL;
+    volatile float    sink = 0.0f;
+    double            tScalar[2], tVec[2];
+    clock_t           t0;
+    char              sbuf[128];
+    int               i, c, p, nBad = 0;
+
+    memset(&cv, 0, sizeof(cv));
+    if (n <= 0 || nCycles <= 0) {
+        return 0;
+    }
+
+    inf  = InfoNew();
+    cal  = (tCal *) malloc(n * sizeof(tCal));
+    kbuf = (char (*)[32]) malloc(n * sizeof(*kbuf));
+    keys = (char const **) malloc(n * sizeof(*keys));
+    inA  = (float *) malloc(CALBENCH_NVEC * n * sizeof(float));
+    inB  = (float *) malloc(CALBENCH_NVEC * n * sizeof(float));
+    out  = (float *) malloc(n * sizeof(float));
+    vout = (float *) malloc(n * sizeof(float));
+    tmp  = (float *) malloc(2 * n * sizeof(float));
+    if (inf == NULL || cal == NULL || kbuf == NULL || keys == NULL || inA == NULL
+        || inB == NULL || out == NULL || vout == NULL || tmp == NULL) {
+        printf("CalBench: out of memory\n");
+        nBad = -1;
+        goto EndReturn;
+    }
+
+    /* Calibration entries as in the I/O parameters, every 8th channel Rezip */
+    CalBenchSeed = 1;
+    for (i = 0; i < n; i++) {
+        sprintf(kbuf[i], "CalBench.%d", i);
+        sprintf(sbuf, "%g %g %g %g %d", CalBenchRand(-200.0f, -50.0f), CalBenchRand(50.0f, 200.0f),
+            CalBenchRand(0.5f, 20.0f), CalBenchRand(-1.0f, 1.0f), i % 8 == 7);
+        InfoSetStr(inf, kbuf[i], sbuf);
+        keys[i] = kbuf[i];
+        iGetCal(inf, keys[i], &cal[i], 0);
+    }
+    if (iGetCalVec(inf, keys, n, &cv, 0) < 0) {
+        nBad = -1;
+        goto EndReturn;
+    }
+
+    /* inA: mostly within the limits, inB: limits reached on CalOut */
+    for (i = 0; i < CALBENCH_NVEC * n; i++) {
+        inA[i] = CalBenchRand(-20.0f, 20.0f);
+        inB[i] = CalBenchRand(-250.0f, 250.0f);
+    }
+    if (n > 7) {
+        inA[7] = cal[7].Offset; /* 1 / 0 */
+    }
+
+    /*** Bit compatibility, including Min / Max */
+    for (c = 0; c < CALBENCH_NVEC; c++) {
+        float const *a = inA + c * n, *b = inB + c * n;
+
+        for (i = 0; i < n; i++) {
+            out[i] = CalInF(&cal[i], a[i]);
+        }
+        CalInVecF(&cv, a, vout);
+        nBad += CalBenchCmp("CalIn", out, vout, n);
+
+        for (i = 0; i < n; i++) {
+            out[i] = CalOutF(&cal[i], b[i]);
+        }
+        CalOutVecF(&cv, b, vout);
+        nBad += CalBenchCmp("CalOut", out, vout, n);
+    }
+    for (i = 0; i < n; i++) {
+        tmp[i]     = cal[i].Min;
+        tmp[n + i] = cal[i].Max;
+    }
+    nBad += CalBenchCmp("Min", tmp, cv.Min, n);
+    nBad += CalBenchCmp("Max", tmp + n, cv.Max, n);
+
+    /*** Timing */
+    for (p = 0; p < 2; p++) {
+        float const *in = p == 0 ? inA : inB;
+
+        t0 = clock();
+        for (c = 0; c < nCycles; c++) {
+            float const *v = in + (c % CALBENCH_NVEC) * n;
+            if (p == 0) {
+                for (i = 0; i < n; i++) {
+                    out[i] = CalInF(&cal[i], v[i]);
+                }
+            } else {
+                for (i = 0; i < n; i++) {
+                    out[i] = CalOutF(&cal[i], v[i]);
+                }
+            }
+            sink += out[c % n];
+        }
+        tScalar[p] = (double) (clock() - t0) / CLOCKS_PER_SEC;
+
+        t0 = clock();
+        for (c = 0; c < nCycles; c++) {
+            float const *v = in + (c % CALBENCH_NVEC) * n;
+            if (p == 0) {
+                CalInVecF(&cv, v, vout);
+            } else {
+                CalOutVecF(&cv, v, vout);
+            }
+            sink += vout[c % n];
+        }
+        tVec[p] = (double) (clock() - t0) / CLOCKS_PER_SEC;
+    }
+
+    printf("CalBench: %d channels, %d cycles, %s\n", n, nCycles,
+#if defined(CAL_SSE2)
+        "SSE2"
+#else
+        "generic"
+#endif
+    );
+    for (p = 0; p < 2; p++) {
+        double ns = 1e9 / ((double) n * nCycles);
+        printf("CalBench: %-6s  scalar %7.3f ns/ch  vector %7.3f ns/ch  speedup %5.2f\n", Phase[p],
+            tScalar[p] * ns, tVec[p] * ns, tVec[p] > 0.0 ? tScalar[p] / tVec[p] : 0.0);
+    }
+    printf("CalBench: %d mismatch(es)\n", nBad);
+
+EndReturn:
+    CalVec_Delete(&cv);
+    if (inf != NULL) {
+        InfoDelete(inf);
+    }
+    free(cal);
+    free(kbuf);
+    free(keys);
+    free(inA);
+    free(inB);
+    free(out);
+    free(vout);
+    free(tmp);
+    return nBad;
+}
+
 /*****************************************************************************/
 
 /*
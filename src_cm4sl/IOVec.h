@@ -50,6 +50,37 @@ int   CalOut(tCal *cal, float Value);
 float CalOutF(tCal *cal, float Value);
 int   LimitInt(float fValue, int Min, int Max);
 
+/*
+ * Batch calibration, struct of arrays
+ *
+ * One table for n channels, loaded once with iGetCalVec() from the same
+ * Info File entries as iGetCal(). CalInVecF() / CalOutVecF() convert a
+ * whole channel vector in one call (SSE2 on x86-64, a branchless loop
+ * otherwise) and update Min / Max per channel. The results and the
+ * Min / Max tracking are bit-identical to CalInF() / CalOutF() applied
+ * channel by channel. In and Out may be the same vector.
+ */
+typedef struct tCalVec {
+    int       n;
+    float    *Min;
+    float    *Max;
+    float    *LimitLow;
+    float    *LimitHigh;
+    float    *Factor;
+    float    *Offset;
+    unsigned *Rezip;      /* 0 or ~0, select mask */
+} tCalVec;
+
+int  iGetCalVec(struct tInfos *Inf, char const *const *keys, int n, tCalVec *cv, int optional);
+void CalVec_Delete(tCalVec *cv);
+void CalInVec(tCalVec *cv, int const *In, float *Out);
+void CalInVecF(tCalVec *cv, float const *In, float *Out);
+void CalOutVec(tCalVec *cv, float const *In, int *Out);
+void CalOutVecF(tCalVec *cv, float const *In, float *Out);
+#if defined(CM_CALBENCH)
+int  IO_CalBench(int n, int nCycles);
+#endif
+
 int IO_Init_First(void);
 int IO_Init(void);
 int IO_Init_Finalize(void);
@@ -0,0 +1,305 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Streaming handling KPIs (see KPI.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - KPI_DeclQuants ()
+ * - KPI_TestRun_Start ()
+ * - KPI_Calc ()
+ * - KPI_TestRun_End_First ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <CarMaker.h>
+
+#include "KPI.h"
+#include "ResultLink.h"
+
+#define KPI_RAD2DEG 57.296
+#define KPI_G       9.81
+
+/* Input channels, same names as in ResultHandler.process_results() */
+static struct {
+    tDDictEntry *Steer;     /* rad, at wheel */
+    tDDictEntry *Speed;     /* m/s */
+    tDDictEntry *YawRate;   /* rad/s */
+    tDDictEntry *Ay;        /* m/s^2 */
+    tDDictEntry *Roll;      /* rad */
+    tDDictEntry *SideSlip;  /* rad, optional */
+} In;
+
+/* Running accumulators of the current Test Run */
+static struct {
+    /* Steer [deg] vs. ay [g] regression, cornering only (Welford) */
+    long   nCorner;
+    double mX, mY, Mxx, Mxy;
+
+    /* Steer angle mean/variance, all samples */
+    long   nSteer;
+    double mSteer, M2Steer;
+
+    double MaxRoll;
+
+    /* Sideslip rate, cornering only */
+    int    HaveBeta;
+    double BetaPrev;
+    double BetaRateSum;
+
+    /* Decimated steer/yaw signals (ring of the past yaw rates) and per-lag
+       correlation moments */
+    int    DecCnt;
+    double DecSteer, DecYaw, DecDt;
+    double DtSum;
+    long   nDec;
+    double SumS, SumY;
+    int    RingPos;
+    double Ring[KPI_LAG_N];
+    double Sxy[KPI_LAG_N], Sx[KPI_LAG_N], Sy[KPI_LAG_N];
+    long   nLag[KPI_LAG_N];
+} Acc;
+
+/* Results, visible in the data dictionary */
+static struct {
+    double UndersteerGrad;
+    double MaxRoll;
+    double StabilityIndex;
+    double ResponseLag;
+    double SteeringRMS;
+    double nCornering;
+    double Valid;
+} KPI;
+
+static tDDictEntry *
+GetQuant(char const *name, int required)
+{
+    tDDictEntry *e = DDictGetEntry(name);
+
+    if (e == NULL && required) {
+        LogWarnF(EC_General, "KPI: unknown quantity '%s', KPIs disabled", name);
+    }
+    return e;
+}
+
+/*
+ * KPI_DeclQuants ()
+ *
+ * Call:
+ * - once at program start, from User_DeclQuants()
+ * - no realtime conditions
+ */
+
+void
+KPI_DeclQuants(void)
+{
+    memset(&KPI, 0, sizeof(KPI));
+
+    DDefDouble(NULL, "KPI.UndersteerGrad", "deg/g", &KPI.UndersteerGrad, DVA_None);
+    DDefDouble(NULL, "KPI.MaxRoll",        "rad",   &KPI.MaxRoll,        DVA_None);
+    DDefDouble(NULL, "KPI.StabilityIndex", "",      &KPI.StabilityIndex, DVA_None);
+    DDefDouble(NULL, "KPI.ResponseLag",    "ms",    &KPI.ResponseLag,    DVA_None);
+    DDefDouble(NULL, "KPI.SteeringRMS",    "rad",   &KPI.SteeringRMS,    DVA_None);
+    DDefDouble(NULL, "KPI.nCornering",     "",      &KPI.nCornering,     DVA_None);
+    DDefDouble(NULL, "KPI.Valid",          "",      &KPI.Valid,          DVA_None);
+}
+
+/*
+ * KPI_TestRun_Start ()
+ *
+ * Reset the accumulators and resolve the input quantities.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - when starting a new Test Run, after all models are read in
+ */
+
+int
+KPI_TestRun_Start(void)
+{
+    memset(&Acc, 0, sizeof(Acc));
+    memset(&KPI, 0, sizeof(KPI));
+
+    In.Steer    = GetQuant("Car.Steer.WhlAngle", 1);
+    In.Speed    = GetQuant("Car.v", 1);
+    In.YawRate  = GetQuant("Car.YawRate", 1);
+    In.Ay       = GetQuant("Car.Fr1.Ay", 1);
+    In.Roll     = GetQuant("Car.Roll", 1);
+    In.SideSlip = GetQuant("Car.SideSlip", 0);
+
+    KPI.Valid = In.Steer != NULL && In.Speed != NULL && In.YawRate != NULL
+        && In.Ay != NULL && In.Roll != NULL;
+
+    return 0;
+}
+
+static void
+Lag_Push(double steer, double yaw)
+{
+    int k, nk;
+
+    Acc.RingPos = (Acc.RingPos + 1) % KPI_LAG_N;
+    Acc.Ring[Acc.RingPos] = yaw;
+    Acc.nDec++;
+    Acc.SumS += steer;
+    Acc.SumY += yaw;
+
+    /* steer(t) against yaw(t-k): term k of np.correlate(steer, yaw),
+       the yaw rate leading the steering by k samples */
+    nk = Acc.nDec < KPI_LAG_N ? (int) Acc.nDec : KPI_LAG_N;
+    for (k = 0; k < nk; k++) {
+        double y = Acc.Ring[(Acc.RingPos - k + KPI_LAG_N) % KPI_LAG_N];
+        Acc.Sxy[k] += steer * y;
+        Acc.Sx[k]  += steer;
+        Acc.Sy[k]  += y;
+        Acc.nLag[k]++;
+    }
+}
+
+/*
+ * KPI_Calc ()
+ *
+ * Update the accumulators with the current sample, O(1) per cycle
+ * (O(KPI_LAG_N) every KPI_LAG_DECIM cycles).
+ *
+ * Call:
+ * - in RT context, from User_Calc(), in SCState_Simulate only
+ */
+
+void
+KPI_Calc(double dt)
+{
+    double steer, v, yaw, ay, roll, d;
+    int    cornering;
+
+    if (!KPI.Valid || dt <= 0.0) {
+        return;
+    }
+
+    steer = DDictGetValue(In.Steer);
+    v     = DDictGetValue(In.Speed);
+    yaw   = DDictGetValue(In.YawRate);
+    ay    = DDictGetValue(In.Ay);
+    roll  = DDictGetValue(In.Roll);
+
+    cornering = v > 10.0 && fabs(ay) > 5.0;
+
+    /* Understeer gradient: running regression moments */
+    if (cornering) {
+        double x = ay / KPI_G;
+        double y = steer * KPI_RAD2DEG;
+        double dx;
+
+        Acc.nCorner++;
+        dx = x - Acc.mX;
+        Acc.mX  += dx / Acc.nCorner;
+        Acc.mY  += (y - Acc.mY) / Acc.nCorner;
+        Acc.Mxx += dx * (x - Acc.mX);
+        Acc.Mxy += dx * (y - Acc.mY);
+    }
+
+    /* Steering standard deviation */
+    Acc.nSteer++;
+    d = steer - Acc.mSteer;
+    Acc.mSteer  += d / Acc.nSteer;
+    Acc.M2Steer += d * (steer - Acc.mSteer);
+
+    if (fabs(roll) > Acc.MaxRoll) {
+        Acc.MaxRoll = fabs(roll);
+    }
+
+    /* Sideslip rate integral */
+    if (In.SideSlip != NULL) {
+        double beta = DDictGetValue(In.SideSlip);
+        if (Acc.HaveBeta && cornering) {
+            Acc.BetaRateSum += fabs(beta - Acc.BetaPrev) / dt;
+        }
+        Acc.BetaPrev = beta;
+        Acc.HaveBeta = 1;
+    }
+
+    /* Steer -> yaw lag: box-car averaged, decimated samples */
+    Acc.DecSteer += steer;
+    Acc.DecYaw   += yaw;
+    Acc.DecDt    += dt;
+    if (++Acc.DecCnt >= KPI_LAG_DECIM) {
+        Lag_Push(Acc.DecSteer / Acc.DecCnt, Acc.DecYaw / Acc.DecCnt);
+        Acc.DtSum += Acc.DecDt;
+        Acc.DecSteer = Acc.DecYaw = Acc.DecDt = 0.0;
+        Acc.DecCnt = 0;
+    }
+
+    KPI.MaxRoll    = Acc.MaxRoll;
+    KPI.nCornering = (double) Acc.nCorner;
+}
+
+/*
+ * KPI_TestRun_End_First ()
+ *
+ * Finalize the KPIs and add them to the result message.
+ *
+ * Call:
+ * - in main task (realtime conditions), User_TestRun_End_First()
+ */
+
+void
+KPI_TestRun_End_First(void)
+{
+    int k, kBest = 0;
+
+    if (!KPI.Valid) {
+        ResultLink_Add("KPI.Valid", 0.0);
+        return;
+    }
+
+    KPI.UndersteerGrad = 0.0;
+    if (Acc.nCorner > 50 && Acc.Mxx > 0.0) {
+        KPI.UndersteerGrad = Acc.Mxy / Acc.Mxx;
+    }
+
+    KPI.SteeringRMS = Acc.nSteer > 0 ? sqrt(Acc.M2Steer / Acc.nSteer) : 0.0;
+    KPI.MaxRoll     = Acc.MaxRoll;
+
+    KPI.StabilityIndex = 1.0;
+    if (In.SideSlip != NULL && Acc.nCorner > 0) {
+        double meanRate = Acc.BetaRateSum / Acc.nCorner;
+        KPI.StabilityIndex = meanRate * 5.0 < 1.0 ? 1.0 - meanRate * 5.0 : 0.0;
+    }
+
+    /* Peak of the mean-free cross-correlation sum over the overlap, using the
+       global means, as process_results(): a yaw rate lagging the steering
+       peaks at a negative lag there, clipped to 0, i.e. k = 0 here */
+    KPI.ResponseLag = 50.0;
+    if (Acc.nDec > KPI_LAG_N) {
+        double ms = Acc.SumS / Acc.nDec, my = Acc.SumY / Acc.nDec;
+        double c, cBest = 0.0;
+
+        for (k = 0; k < KPI_LAG_N; k++) {
+            c = Acc.Sxy[k] - my * Acc.Sx[k] - ms * Acc.Sy[k] + Acc.nLag[k] * ms * my;
+            if (k == 0 || c > cBest) {
+                cBest = c;
+                kBest = k;
+            }
+        }
+        KPI.ResponseLag = kBest * (Acc.DtSum / Acc.nDec) * 1000.0;
+    }
+
+    ResultLink_Add("KPI.UndersteerGrad", KPI.UndersteerGrad);
+    ResultLink_Add("KPI.MaxRoll",        KPI.MaxRoll);
+    ResultLink_Add("KPI.StabilityIndex", KPI.StabilityIndex);
+    ResultLink_Add("KPI.ResponseLag",    KPI.ResponseLag);
+    ResultLink_Add("KPI.SteeringRMS",    KPI.SteeringRMS);
+    ResultLink_Add("KPI.nCornering",     KPI.nCornering);
+    ResultLink_Add("KPI.Valid",          KPI.Valid);
+}
@@ -0,0 +1,49 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Streaming handling KPIs
+ *
+ * The KPIs of ResultHandler.process_results() (src/database/data_handler.py)
+ * are accumulated cycle by cycle in User_Calc(), so the optimizer gets them
+ * with the ResultLink message instead of reading back the whole ERG file:
+ *
+ *	KPI.UndersteerGrad	deg/g	slope of steer [deg] vs. ay [g], cornering only
+ *	KPI.MaxRoll		rad	max |Car.Roll|
+ *	KPI.StabilityIndex	-	1 - 5 * mean |d(SideSlip)/dt|, cornering only
+ *	KPI.ResponseLag		ms	yaw rate lead over the steering at the peak of
+ *					np.correlate(steer, yaw), 0 if it lags
+ *	KPI.SteeringRMS		rad	standard deviation of the steer angle
+ *	KPI.nCornering		-	number of cycles inside the cornering mask
+ *	KPI.Valid		-	1 if all input quantities were found
+ *
+ * Cornering mask: Car.v > 10 m/s and |ay| > 5 m/s^2 (same as Python).
+ *
+ *****************************************************************************
+ */
+
+#ifndef _KPI_H__
+#define _KPI_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Steer/yaw cross-correlation: decimated to KPI_LAG_DECIM cycles,
+   lags 0 .. KPI_LAG_N-1 decimated samples (10 ms steps up to 310 ms
+   at 1 kHz cycles) */
+#define KPI_LAG_DECIM 10
+#define KPI_LAG_N     32
+
+void KPI_DeclQuants(void);
+int  KPI_TestRun_Start(void);
+void KPI_Calc(double dt);
+void KPI_TestRun_End_First(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _KPI_H__ */
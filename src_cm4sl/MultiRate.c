@@ -0,0 +1,170 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Multi-rate execution of RTW-built Simulink models (see MultiRate.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - MultiRate_Register ()
+ * - MultiRate_TestRun_Start ()
+ * - MultiRate_Steps ()
+ * - MultiRate_dt ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include "MultiRate.h"
+
+#if defined(CM_MULTIRATE)
+
+#include <stdio.h>
+#include <string.h>
+
+#include <CarMaker.h>
+
+#include "MatSupp.h"
+
+static struct {
+    int n;
+    struct {
+        char             Name[64];
+        double           DtModel;   /* compiled step */
+        double           dt;        /* step in this Test Run */
+        tMatSuppSampling Samp;
+    } Model[MULTIRATE_MAXMODELS];
+} MR;
+
+/*
+ * MultiRate_Register ()
+ *
+ * Return:
+ *  >=0 : id for MultiRate_Steps() / MultiRate_dt()
+ *   -1 : too many models
+ *
+ * Call:
+ * - in the model's wrapper, XXX_New()
+ * - no realtime conditions
+ */
+
+int
+MultiRate_Register(char const *model, double dtmodel)
+{
+    int i;
+
+    for (i = 0; i < MR.n; i++) {
+        if (strcmp(MR.Model[i].Name, model) == 0) {
+            break;
+        }
+    }
+    if (i == MR.n) {
+        if (MR.n >= MULTIRATE_MAXMODELS) {
+            LogErrF(EC_Init, "MultiRate: too many models, '%s' ignored", model);
+            return -1;
+        }
+        strncpy(MR.Model[i].Name, model, sizeof(MR.Model[i].Name) - 1);
+        MR.Model[i].Name[sizeof(MR.Model[i].Name) - 1] = '\0';
+        MR.n++;
+    }
+
+    MR.Model[i].DtModel             = dtmodel;
+    MR.Model[i].dt                  = dtmodel;
+    MR.Model[i].Samp.OverSampFac    = 1;
+    MR.Model[i].Samp.UnderSampFac   = 1;
+    MR.Model[i].Samp.UnderSampCount = 0;
+    return i;
+}
+
+/*
+ * MultiRate_TestRun_Start ()
+ *
+ * Read MultiRate.<model>.Rate and set up the sampling of every
+ * registered model. A rate that is no integer multiple or fraction of
+ * the application rate is an error, the model then runs every cycle.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), User_TestRun_Start_atEnd()
+ */
+
+int
+MultiRate_TestRun_Start(struct tInfos *Inf)
+{
+    char sbuf[128];
+    int  i, rv = 0;
+
+    for (i = 0; i < MR.n; i++) {
+        double rate, dt;
+
+        sprintf(sbuf, "MultiRate.%s.Rate", MR.Model[i].Name);
+        rate = iGetDblOpt(Inf, sbuf, 0.0);
+        dt   = rate > 0.0 ? 1.0 / rate : MR.Model[i].DtModel;
+        if (dt <= 0.0) {
+            dt = SimCore.DeltaT;
+        }
+
+        if (MatSupp_Sampling(&MR.Model[i].Samp, SimCore.DeltaT, dt) != 0) {
+            LogErrF(EC_Init, "MultiRate: %s: step %g s doesn't fit the application step %g s",
+                MR.Model[i].Name, dt, SimCore.DeltaT);
+            MR.Model[i].Samp.OverSampFac  = 1;
+            MR.Model[i].Samp.UnderSampFac = 1;
+            dt                            = SimCore.DeltaT;
+            rv                            = -1;
+        }
+        MR.Model[i].dt = dt;
+        /* first cycle is a tick */
+        MR.Model[i].Samp.UnderSampCount = MR.Model[i].Samp.UnderSampFac - 1;
+
+        Log("MultiRate: %-20s %8.1f Hz (every %d cycle(s), %d step(s))\n", MR.Model[i].Name,
+            1.0 / dt, MR.Model[i].Samp.UnderSampFac, MR.Model[i].Samp.OverSampFac);
+    }
+    return rv;
+}
+
+/*
+ * MultiRate_Steps ()
+ *
+ * Number of model steps to compute in this cycle, 0 = hold.
+ *
+ * Call:
+ * - in RT context, once per cycle from the model's XXX_Calc()
+ */
+
+int
+MultiRate_Steps(int id)
+{
+    tMatSuppSampling *s;
+
+    if (id < 0 || id >= MR.n) {
+        return 1;
+    }
+    s = &MR.Model[id].Samp;
+    if (++s->UnderSampCount < s->UnderSampFac) {
+        return 0;
+    }
+    s->UnderSampCount = 0;
+    return s->OverSampFac;
+}
+
+/*
+ * MultiRate_dt ()
+ *
+ * Model step in this Test Run [s].
+ */
+
+double
+MultiRate_dt(int id)
+{
+    return id >= 0 && id < MR.n ? MR.Model[id].dt : SimCore.DeltaT;
+}
+
+#else
+
+/* ISO C forbids an empty translation unit */
+typedef int tMultiRate_Disabled;
+
+#endif /* CM_MULTIRATE */
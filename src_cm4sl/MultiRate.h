@@ -0,0 +1,60 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Multi-rate execution of RTW-built Simulink models
+ *
+ * The controller models (OPENXWD, TorqueVect, DRS_B, ...) don't need to
+ * run at the application step. Each model registers once from its
+ * wrapper with its compiled step and gets its rate per Test Run:
+ *	MultiRate.<model>.Rate = <Hz>	(default: 1 / compiled step)
+ * MatSupp_Sampling() turns the rate into OverSampFac/UnderSampFac; the
+ * under-sampling counter lets the model compute only on its ticks. In
+ * between the wrapper skips the model, its outputs hold their last
+ * values. The vehicle model step is not changed.
+ *
+ * In the wrapper:
+ *	XXX_New():	id = MultiRate_Register("OPENXWD", <compiled step>);
+ *	XXX_Calc():	if ((n = MultiRate_Steps(id)) == 0)
+ *			    return 0;	-- hold
+ *			for (i = 0; i < n; i++) <one model step>;
+ * A model built for 1 / Rate, or one that integrates with the step
+ * from MultiRate_dt(), gives the same results at the lower rate.
+ *
+ * Compile with -DCM_MULTIRATE and link $(MATSUPP_LIB) (see Makefile);
+ * otherwise the MultiRate_* calls in User.c are empty.
+ *
+ *****************************************************************************
+ */
+
+#ifndef _MULTIRATE_H__
+#define _MULTIRATE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+#define MULTIRATE_MAXMODELS 16
+
+#if defined(CM_MULTIRATE)
+
+int    MultiRate_Register(char const *model, double dtmodel);
+int    MultiRate_TestRun_Start(struct tInfos *Inf);
+int    MultiRate_Steps(int id);
+double MultiRate_dt(int id);
+
+#else
+
+# define MultiRate_TestRun_Start(Inf) 0
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _MULTIRATE_H__ */
@@ -0,0 +1,202 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Early termination of hopeless optimizer trials (see Prune.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - Prune_TestRun_Start ()
+ * - Prune_Calc ()
+ * - Prune_HasStopped ()
+ * - Prune_Reason ()
+ * - Prune_TestRun_End_First ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <CarMaker.h>
+
+#include "Prune.h"
+#include "ResultLink.h"
+
+/* Sideslip must stay above the limit this long to count as a spin, s */
+#define PRUNE_SPIN_TIME   0.3
+/* Minimum progress within Prune.StallTime, m */
+#define PRUNE_STALL_DIST  0.5
+
+static struct {
+    /* Thresholds */
+    double BestTime;
+    double TotalDist;
+    double Margin;
+    double MinDist;
+    double MaxSideSlip;
+    double StallTime;
+    double OffTrackMax;
+    double Horizon;
+
+    tDDictEntry *Distance;
+    tDDictEntry *SideSlip;
+    tDDictEntry *OffTrack;
+
+    /* State */
+    int          Enabled;
+    double       tSpin;
+    double       StallDist, tStall;
+    tPruneReason Reason;
+    double       tStop;
+} Prune;
+
+/*
+ * Prune_TestRun_Start ()
+ *
+ * Read the Prune.* keys of the Test Run.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - when starting a new Test Run, after all models are read in
+ */
+
+int
+Prune_TestRun_Start(struct tInfos *Inf)
+{
+    char const *s;
+
+    memset(&Prune, 0, sizeof(Prune));
+
+    Prune.BestTime    = iGetDblOpt(Inf, "Prune.BestTime",    0.0);
+    Prune.TotalDist   = iGetDblOpt(Inf, "Prune.TotalDist",   0.0);
+    Prune.Margin      = iGetDblOpt(Inf, "Prune.Margin",      1.15);
+    Prune.MinDist     = iGetDblOpt(Inf, "Prune.MinDist",     10.0);
+    Prune.MaxSideSlip = iGetDblOpt(Inf, "Prune.MaxSideSlip", 0.0);
+    Prune.StallTime   = iGetDblOpt(Inf, "Prune.StallTime",   0.0);
+    Prune.OffTrackMax = iGetDblOpt(Inf, "Prune.OffTrack.Max", 0.0);
+    Prune.Horizon     = iGetDblOpt(Inf, "Prune.Horizon",     0.0);
+
+    Prune.Distance = DDictGetEntry("Vhcl.Distance");
+    if (Prune.MaxSideSlip > 0.0 && (Prune.SideSlip = DDictGetEntry("Car.SideSlip")) == NULL) {
+        LogWarnF(EC_General, "Prune: unknown quantity 'Car.SideSlip', spin check disabled");
+    }
+    if ((s = iGetStrOpt(Inf, "Prune.OffTrack.Quant", NULL)) != NULL && *s != '\0') {
+        if ((Prune.OffTrack = DDictGetEntry(s)) == NULL) {
+            LogWarnF(EC_General, "Prune: unknown quantity '%s', off track check disabled", s);
+        }
+    }
+
+    Prune.Enabled = (Prune.BestTime > 0.0 && Prune.TotalDist > 0.0)
+        || Prune.SideSlip != NULL || Prune.StallTime > 0.0 || Prune.OffTrack != NULL
+        || Prune.Horizon > 0.0;
+    if (Prune.Distance == NULL) {
+        Prune.Enabled = 0;
+    }
+
+    return 0;
+}
+
+static void
+Stop(tPruneReason reason)
+{
+    static char const *Names[] = {"", "slow", "spin", "stall", "off track", "horizon"};
+
+    Prune.Reason = reason;
+    Prune.tStop  = SimCore.Time;
+    Log("Prune: Test Run stopped at t=%.2fs (%s)\n", SimCore.Time, Names[reason]);
+    SimStop();
+}
+
+/*
+ * Prune_Calc ()
+ *
+ * Call:
+ * - in RT context, from User_Calc(), in SCState_Simulate only
+ */
+
+void
+Prune_Calc(double dt)
+{
+    double t = SimCore.Time, dist;
+
+    if (!Prune.Enabled || Prune.Reason != PruneReason_None) {
+        return;
+    }
+
+    dist = DDictGetValue(Prune.Distance);
+
+    /* Lap time projection at the current pace */
+    if (Prune.BestTime > 0.0 && Prune.TotalDist > 0.0) {
+        double limit = Prune.BestTime * Prune.Margin;
+        if (t > limit || (dist > Prune.MinDist && t / dist * Prune.TotalDist > limit)) {
+            Stop(PruneReason_Slow);
+            return;
+        }
+    }
+
+    if (Prune.SideSlip != NULL) {
+        if (fabs(DDictGetValue(Prune.SideSlip)) > Prune.MaxSideSlip) {
+            if ((Prune.tSpin += dt) >= PRUNE_SPIN_TIME) {
+                Stop(PruneReason_Spin);
+                return;
+            }
+        } else {
+            Prune.tSpin = 0.0;
+        }
+    }
+
+    if (Prune.StallTime > 0.0) {
+        if (dist - Prune.StallDist > PRUNE_STALL_DIST) {
+            Prune.StallDist = dist;
+            Prune.tStall    = t;
+        } else if (t - Prune.tStall > Prune.StallTime) {
+            Stop(PruneReason_Stall);
+            return;
+        }
+    }
+
+    if (Prune.OffTrack != NULL && fabs(DDictGetValue(Prune.OffTrack)) > Prune.OffTrackMax) {
+        Stop(PruneReason_OffTrack);
+        return;
+    }
+
+    if (Prune.Horizon > 0.0 && dist >= Prune.Horizon) {
+        Stop(PruneReason_Horizon);
+    }
+}
+
+int
+Prune_HasStopped(void)
+{
+    return Prune.Reason != PruneReason_None;
+}
+
+tPruneReason
+Prune_Reason(void)
+{
+    return Prune.Reason;
+}
+
+/*
+ * Prune_TestRun_End_First ()
+ *
+ * Call:
+ * - in main task (realtime conditions), User_TestRun_End_First()
+ */
+
+void
+Prune_TestRun_End_First(void)
+{
+    if (!Prune.Enabled) {
+        return;
+    }
+    ResultLink_Add("Prune.Reason", (double) Prune.Reason);
+    ResultLink_Add("Prune.Time",   Prune.tStop);
+}
@@ -0,0 +1,60 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Early termination of hopeless optimizer trials
+ *
+ * The Test Run is stopped as soon as the trial can no longer beat the
+ * best result so far. Time and Vhcl.Distance at the stop are reported
+ * through ResultLink as usual, so the optimizer still gets the partial
+ * pace for its projected-time penalty.
+ *
+ * Test Run Info File keys (all optional, 0 = check disabled):
+ *	Prune.BestTime      = <best lap time so far, s>
+ *	Prune.TotalDist     = <lap length, m>
+ *	Prune.Margin        = <stop if projected time > BestTime * Margin, default 1.15>
+ *	Prune.MinDist       = <no projection before this distance, m, default 10>
+ *	Prune.MaxSideSlip   = <spin: |Car.SideSlip| above this, rad>
+ *	Prune.StallTime     = <stall: less than 0.5 m progress within this time, s>
+ *	Prune.OffTrack.Quant = <DDict quantity, off track if |value| > OffTrack.Max>
+ *	Prune.OffTrack.Max   = <limit>
+ *	Prune.Horizon     = <stop once Vhcl.Distance reaches this, m>
+ *		short-horizon screening run of a multi-fidelity optimizer,
+ *		checked after the other criteria
+ *
+ * Reported: Prune.Reason (see tPruneReason), Prune.Time.
+ *
+ *****************************************************************************
+ */
+
+#ifndef _PRUNE_H__
+#define _PRUNE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+typedef enum {
+    PruneReason_None = 0,
+    PruneReason_Slow,       /* projected lap time can't beat BestTime */
+    PruneReason_Spin,       /* sideslip limit exceeded */
+    PruneReason_Stall,      /* no progress */
+    PruneReason_OffTrack,
+    PruneReason_Horizon     /* screening distance reached */
+} tPruneReason;
+
+int          Prune_TestRun_Start(struct tInfos *Inf);
+void         Prune_Calc(double dt);
+int          Prune_HasStopped(void);
+tPruneReason Prune_Reason(void);
+void         Prune_TestRun_End_First(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _PRUNE_H__ */
@@ -0,0 +1,361 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Result hand-off to the optimizer (see ResultLink.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - ResultLink_Init ()
+ * - ResultLink_TestRun_Start ()
+ * - ResultLink_IsActive ()
+ * - ResultLink_Add ()
+ * - ResultLink_AddQuants ()
+ * - ResultLink_Send ()
+ * - ResultLink_Recv ()
+ * - ResultLink_Reply ()
+ * - ResultLink_Cleanup ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#if defined(WIN32)
+# include <winsock2.h>
+# include <windows.h>
+#else
+# include <sys/types.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <sys/select.h>
+# include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <CarMaker.h>
+
+#include "ResultLink.h"
+
+#if defined(WIN32)
+typedef SOCKET tRLSocket;
+# define RL_INVALID_SOCKET INVALID_SOCKET
+# define RL_CLOSE(s)       closesocket(s)
+#else
+typedef int tRLSocket;
+# define RL_INVALID_SOCKET (-1)
+# define RL_CLOSE(s)       close(s)
+#endif
+
+static struct {
+    tRLSocket          Sock;
+    struct sockaddr_in Addr;
+    int                Port;
+    int                Bound;     /* local port assigned by the first sendto() */
+    struct sockaddr_in From;      /* sender of the last received datagram */
+    char               Tag[64];
+
+    /* Quantities captured at Test Run end */
+    int                nQuants;
+    char               QuantName[RESULTLINK_MAXITEMS][64];
+    tDDictEntry       *Quant[RESULTLINK_MAXITEMS];
+
+    /* Message under construction */
+    int                nItems;
+    char               ItemName[RESULTLINK_MAXITEMS][64];
+    double             ItemValue[RESULTLINK_MAXITEMS];
+} RL;
+
+/* Always present in the message, besides Time */
+static char const *DefaultQuants[] = {"Vhcl.Distance", NULL};
+
+static void
+AddQuantName(char const *name)
+{
+    if (RL.nQuants >= RESULTLINK_MAXITEMS) {
+        LogWarnF(EC_General, "ResultLink: too many quantities, '%s' ignored", name);
+        return;
+    }
+    if ((RL.Quant[RL.nQuants] = DDictGetEntry(name)) == NULL) {
+        LogWarnF(EC_General, "ResultLink: unknown quantity '%s'", name);
+        return;
+    }
+    strncpy(RL.QuantName[RL.nQuants], name, sizeof(RL.QuantName[0]) - 1);
+    RL.QuantName[RL.nQuants][sizeof(RL.QuantName[0]) - 1] = '\0';
+    RL.nQuants++;
+}
+
+/*
+ * ResultLink_Init ()
+ *
+ * Call:
+ * - once at program start
+ * - no realtime conditions
+ */
+
+int
+ResultLink_Init(void)
+{
+    memset(&RL, 0, sizeof(RL));
+    RL.Sock = RL_INVALID_SOCKET;
+
+#if defined(WIN32)
+    {
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+            LogErrF(EC_Init, "ResultLink: WSAStartup failed");
+            return -1;
+        }
+    }
+#endif
+    return 0;
+}
+
+/*
+ * ResultLink_TestRun_Start ()
+ *
+ * Reads the ResultLink.* keys of the Test Run and resolves the
+ * quantities to be reported.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - when starting a new Test Run, after all models are read in
+ */
+
+int
+ResultLink_TestRun_Start(struct tInfos *Inf)
+{
+    char const *s;
+    int         i;
+
+    RL.Port    = iGetIntOpt(Inf, "ResultLink.Port", 0);
+    RL.nQuants = 0;
+    RL.nItems  = 0;
+
+    s = iGetStrOpt(Inf, "ResultLink.Tag", "");
+    strncpy(RL.Tag, s, sizeof(RL.Tag) - 1);
+    RL.Tag[sizeof(RL.Tag) - 1] = '\0';
+
+    if (RL.Port <= 0) {
+        return 0;
+    }
+
+    if (RL.Sock == RL_INVALID_SOCKET) {
+        if ((RL.Sock = socket(AF_INET, SOCK_DGRAM, 0)) == RL_INVALID_SOCKET) {
+            LogErrF(EC_Init, "ResultLink: can't create socket");
+            RL.Port = 0;
+            return -1;
+        }
+    }
+    memset(&RL.Addr, 0, sizeof(RL.Addr));
+    RL.Addr.sin_family      = AF_INET;
+    RL.Addr.sin_port        = htons((unsigned short) RL.Port);
+    RL.Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (i = 0; DefaultQuants[i] != NULL; i++) {
+        AddQuantName(DefaultQuants[i]);
+    }
+
+    if ((s = iGetStrOpt(Inf, "ResultLink.Quantities", NULL)) != NULL) {
+        char  buf[1024], *tok;
+        strncpy(buf, s, sizeof(buf) - 1);
+        buf[sizeof(buf) - 1] = '\0';
+        for (tok = strtok(buf, " \t,"); tok != NULL; tok = strtok(NULL, " \t,")) {
+            AddQuantName(tok);
+        }
+    }
+
+    return 0;
+}
+
+int
+ResultLink_IsActive(void)
+{
+    return RL.Port > 0 && RL.Sock != RL_INVALID_SOCKET;
+}
+
+/*
+ * ResultLink_Add ()
+ *
+ * Add a named value to the result message of the current Test Run.
+ * An existing entry with the same name is overwritten.
+ */
+
+void
+ResultLink_Add(char const *name, double value)
+{
+    int i;
+
+    if (!ResultLink_IsActive()) {
+        return;
+    }
+
+    for (i = 0; i < RL.nItems; i++) {
+        if (strcmp(RL.ItemName[i], name) == 0) {
+            RL.ItemValue[i] = value;
+            return;
+        }
+    }
+    if (RL.nItems >= RESULTLINK_MAXITEMS) {
+        return;
+    }
+    strncpy(RL.ItemName[RL.nItems], name, sizeof(RL.ItemName[0]) - 1);
+    RL.ItemName[RL.nItems][sizeof(RL.ItemName[0]) - 1] = '\0';
+    RL.ItemValue[RL.nItems] = value;
+    RL.nItems++;
+}
+
+/*
+ * ResultLink_AddQuants ()
+ *
+ * Capture the current values of all registered quantities.
+ *
+ * Call:
+ * - in main task (realtime conditions), User_TestRun_End_First()
+ */
+
+void
+ResultLink_AddQuants(void)
+{
+    int i;
+
+    for (i = 0; i < RL.nQuants; i++) {
+        ResultLink_Add(RL.QuantName[i], DDictGetValue(RL.Quant[i]));
+    }
+}
+
+/*
+ * ResultLink_Send ()
+ *
+ * Send the result message as one JSON datagram:
+ *	{"Tag": "<tag>", "<name>": <value>, ...}
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), User_TestRun_End()
+ */
+
+int
+ResultLink_Send(void)
+{
+    char msg[RESULTLINK_MSGMAX];
+    int  i, n;
+
+    if (!ResultLink_IsActive()) {
+        return 0;
+    }
+
+    n = snprintf(msg, sizeof(msg), "{\"Tag\": \"%s\"", RL.Tag);
+    for (i = 0; i < RL.nItems && n < (int) sizeof(msg) - 96; i++) {
+        double v = RL.ItemValue[i];
+        if (isnan(v) || isinf(v)) {
+            /* JSON has no nan/inf literals, python's json module reads these */
+            n += snprintf(msg + n, sizeof(msg) - n, ", \"%s\": %s", RL.ItemName[i],
+                isnan(v) ? "NaN" : (v > 0 ? "Infinity" : "-Infinity"));
+        } else {
+            n += snprintf(msg + n, sizeof(msg) - n, ", \"%s\": %.9g", RL.ItemName[i], v);
+        }
+    }
+    n += snprintf(msg + n, sizeof(msg) - n, "}\n");
+
+    RL.nItems = 0;
+
+    if (sendto(RL.Sock, msg, n, 0, (struct sockaddr *) &RL.Addr, sizeof(RL.Addr)) != n) {
+        LogWarnF(EC_General, "ResultLink: sending result to port %d failed", RL.Port);
+        return -1;
+    }
+    RL.Bound = 1;
+    return 0;
+}
+
+/*
+ * ResultLink_Recv ()
+ *
+ * Non-blocking receive of a datagram sent back to the ResultLink socket
+ * (the optimizer answers to the address the results come from).
+ * The message is '\0' terminated.
+ *
+ * Return:
+ *   >0 : length of the message
+ *    0 : nothing received
+ *
+ * Call:
+ * - in the main loop
+ */
+
+int
+ResultLink_Recv(char *buf, int size)
+{
+    struct timeval tv = {0, 0};
+    fd_set         rfds;
+#if defined(WIN32)
+    int            alen = sizeof(RL.From);
+#else
+    socklen_t      alen = sizeof(RL.From);
+#endif
+    int            n;
+
+    if (!RL.Bound || RL.Sock == RL_INVALID_SOCKET) {
+        return 0;
+    }
+
+    FD_ZERO(&rfds);
+    FD_SET(RL.Sock, &rfds);
+    if (select((int) RL.Sock + 1, &rfds, NULL, NULL, &tv) <= 0) {
+        return 0;
+    }
+    n = (int) recvfrom(RL.Sock, buf, size - 1, 0, (struct sockaddr *) &RL.From, &alen);
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+/*
+ * ResultLink_Reply ()
+ *
+ * Answer to the sender of the last datagram from ResultLink_Recv().
+ */
+
+int
+ResultLink_Reply(char const *msg)
+{
+    int n = (int) strlen(msg);
+
+    if (!RL.Bound || RL.Sock == RL_INVALID_SOCKET) {
+        return -1;
+    }
+    if (sendto(RL.Sock, msg, n, 0, (struct sockaddr *) &RL.From, sizeof(RL.From)) != n) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * ResultLink_Cleanup ()
+ *
+ * Call:
+ * - once at end of program, just before exit
+ */
+
+void
+ResultLink_Cleanup(void)
+{
+    if (RL.Sock != RL_INVALID_SOCKET) {
+        RL_CLOSE(RL.Sock);
+        RL.Sock = RL_INVALID_SOCKET;
+    }
+    RL.Bound = 0;
+#if defined(WIN32)
+    WSACleanup();
+#endif
+    RL.Port = 0;
+}
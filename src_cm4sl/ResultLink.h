@@ -0,0 +1,51 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Result hand-off to the optimizer
+ *
+ * At the end of a Test Run the final KPIs (Time, Distance and any
+ * registered quantities) are pushed as one JSON datagram over UDP to
+ * localhost. The optimizer blocks on that socket instead of polling
+ * log files.
+ *
+ * Test Run Info File keys (all optional, no port = disabled):
+ *	ResultLink.Port       = <udp port on localhost>
+ *	ResultLink.Tag        = <trial id, echoed back>
+ *	ResultLink.Quantities = <DDict names, separated by blanks>
+ *
+ * The optimizer may answer to the address the results come from
+ * (ResultLink_Recv() / ResultLink_Reply(), used by HotParam.c).
+ *
+ *****************************************************************************
+ */
+
+#ifndef _RESULTLINK_H__
+#define _RESULTLINK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+#define RESULTLINK_MAXITEMS 48
+#define RESULTLINK_MSGMAX   2048
+
+int  ResultLink_Init(void);
+int  ResultLink_TestRun_Start(struct tInfos *Inf);
+int  ResultLink_IsActive(void);
+void ResultLink_Add(char const *name, double value);
+void ResultLink_AddQuants(void);
+int  ResultLink_Send(void);
+int  ResultLink_Recv(char *buf, int size);
+int  ResultLink_Reply(char const *msg);
+void ResultLink_Cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _RESULTLINK_H__ */
@@ -0,0 +1,505 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Active-sensor dispatch table (see SensorSched.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - SensorSched_SetThreads ()
+ * - SensorSched_Init ()
+ * - SensorSched_TestRun_Start_Finalize ()
+ * - SensorSched_Calc ()
+ * - SensorSched_Cleanup ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#if defined(WIN32)
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <CarMaker.h>
+#include <Vehicle/Sensor_Inertial.h>
+#include <Vehicle/Sensor_SAngle.h>
+#include <Vehicle/Sensor_Object.h>
+#include <Vehicle/Sensor_FSpace.h>
+#include <Vehicle/Sensor_Road.h>
+#include <Vehicle/Sensor_TSign.h>
+#include <Vehicle/Sensor_Line.h>
+#include <Vehicle/Sensor_Collision.h>
+#include <Vehicle/Sensor_GNav.h>
+#include <Vehicle/PylonDetect.h>
+#include <Vehicle/Sensor_Radar.h>
+#include <Vehicle/Sensor_USonicRSI.h>
+#include <Vehicle/Sensor_RadarRSI.h>
+#include <Vehicle/Sensor_LidarRSI.h>
+#include <Vehicle/Sensor_CameraRSI.h>
+#include <Vehicle/Sensor_Camera.h>
+#include <Vehicle/Sensor_ObjectByLane.h>
+#include <Vehicle/Sensor_GroundTruth.h>
+
+#include "CycleProf.h"
+#include "SensorSched.h"
+
+typedef struct {
+    char const     *Name;
+    int           (*Calc)(double dt);
+    int const      *Count;      /* number of instances, NULL = unknown */
+    int             ErrCode;    /* return code of App_TestRun_Calc_Part() */
+    tCycleProfSlot  Slot;
+    int             FixedRate;  /* no SensorSched.<Name>.Rate */
+    int             Serial;     /* not in the parallel stage */
+} tSensorDesc;
+
+static int
+BdyFrame_Calc_dt(double dt)
+{
+    (void) dt;
+    return BdyFrame_Calc();
+}
+
+/* Calling order and return codes of the former if-chain in CM_Main.c.
+   Serial sensors must come first: the body frames are input of all
+   other sensors. The batch build (CM_NO_SENSORS) keeps the ones the
+   vehicle and driver models rely on. */
+static tSensorDesc const SensorDesc[] = {
+    { "BdyFrame",          BdyFrame_Calc_dt,       &BdyFrameCount,          -12, CPSlot_BdyFrame,          1, 1 },
+#if !defined(CM_NO_SENSORS)
+    { "InertialSensor",    InertialSensor_Calc,    &InertialSensorCount,     -7, CPSlot_InertialSensor,    0, 0 },
+    { "SAngleSensor",      SAngleSensor_Calc,      &SAngleSensorCount,      -17, CPSlot_SAngleSensor,      0, 0 },
+    { "ObjectSensor",      ObjectSensor_Calc,      &ObjectSensorCount,       -8, CPSlot_ObjectSensor,      0, 0 },
+    { "GroundTruthSensor", GroundTruthSensor_Calc, &GroundTruthSensorCount, -24, CPSlot_GroundTruthSensor, 0, 0 },
+    { "FSpaceSensor",      FSpaceSensor_Calc,      &FSpaceSensorCount,       -9, CPSlot_FSpaceSensor,      0, 0 },
+    { "RoadSensor",        RoadSensor_Calc,        &RoadSensorCount,        -10, CPSlot_RoadSensor,        0, 0 },
+    { "TSignSensor",       TSignSensor_Calc,       &TSignSensorCount,       -11, CPSlot_TSignSensor,       0, 0 },
+    { "LineSensor",        LineSensor_Calc,        &LineSensorCount,        -14, CPSlot_LineSensor,        0, 0 },
+#endif
+    { "CollisionSensor",   CollisionSensor_Calc,   NULL,                    -15, CPSlot_CollisionSensor,   0, 0 },
+#if !defined(CM_NO_SENSORS)
+    { "GNavSensor",        GNavSensor_Calc,        NULL,                    -16, CPSlot_GNavSensor,        0, 0 },
+#endif
+    { "PylonDetect",       PylonDetect_Calc,       NULL,                    -13, CPSlot_PylonDetect,       0, 0 },
+#if !defined(CM_NO_SENSORS)
+    { "RadarSensor",       RadarSensor_Calc,       NULL,                    -18, CPSlot_RadarSensor,       0, 0 },
+    { "USonicRSI",         USonicRSI_Calc,         &USonicRSICount,         -19, CPSlot_USonicRSI,         0, 0 },
+    { "RadarRSI",          RadarRSI_Calc,          &RadarRSICount,          -20, CPSlot_RadarRSI,          0, 0 },
+    { "LidarRSI",          LidarRSI_Calc,          &LidarRSICount,          -22, CPSlot_LidarRSI,          0, 0 },
+    { "ObjByLane",         ObjByLane_Calc,         &ObjByLaneCount,         -23, CPSlot_ObjByLane,         0, 0 },
+    { "CameraSensor",      CameraSensor_Calc,      &CameraSensorCount,      -40, CPSlot_CameraSensor,      0, 0 },
+    { "CameraRSI",         CameraRSI_Calc,         &CameraRSICount,         -41, CPSlot_CameraRSI,         0, 0 },
+#endif
+};
+
+#define SS_NSENSORS ((int) (sizeof(SensorDesc) / sizeof(SensorDesc[0])))
+
+static struct {
+    int nTask;
+    int Parallel;                   /* SensorSched.Parallel and pool running */
+    struct {
+        tSensorDesc const *Desc;
+        int                Div;     /* rate divider, 1 = every cycle */
+        int                Cnt;
+    } Task[SS_NSENSORS];
+} SS;
+
+
+/*** Worker pool for the parallel stage **************************************/
+
+/* The due sensors of one cycle are claimed through a single atomic ticket
+ *	bits 8..15	number of due sensors
+ *	bits 0.. 7	next sensor to claim
+ * so a worker still busy with the previous cycle always compares the
+ * index it claimed with the count of the same cycle. */
+#define SS_TICKET(n) ((long) (n) << 8)
+
+#if defined(WIN32)
+typedef volatile LONG tSSAtomic;
+typedef HANDLE        tSSThread;
+# define SS_FETCH_ADD(p, v) InterlockedExchangeAdd((p), (v))
+# define SS_LOAD(p)         InterlockedCompareExchange((p), 0, 0)
+# define SS_STORE(p, v)     InterlockedExchange((p), (v))
+# define SS_YIELD()         SwitchToThread()
+#else
+typedef long          tSSAtomic;
+typedef pthread_t     tSSThread;
+# define SS_FETCH_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+# define SS_LOAD(p)         __atomic_load_n((p), __ATOMIC_SEQ_CST)
+# define SS_STORE(p, v)     __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+# define SS_YIELD()         sched_yield()
+#endif
+
+static struct {
+    int       nThreads;             /* -sensorthreads */
+    int       nRunning;
+    tSSThread Thread[SENSORSCHED_MAXTHREADS];
+
+    /* Wake-up of the workers, Gen and Quit protected by Mutex */
+#if defined(WIN32)
+    CRITICAL_SECTION   Mutex;
+    CONDITION_VARIABLE Cond;
+#else
+    pthread_mutex_t    Mutex;
+    pthread_cond_t     Cond;
+#endif
+    unsigned  Gen;
+    int       Quit;
+
+    /* Current cycle */
+    tSSAtomic Ticket;
+    tSSAtomic nDone;
+    double    dt;
+    int       Due[SS_NSENSORS];     /* task index, in table order */
+    int       Res[SS_NSENSORS];     /* return value of the sensor */
+} Pool;
+
+/* Claim and calculate due sensors until there are none left */
+static void
+Pool_RunTasks(void)
+{
+    for (;;) {
+        long const v = SS_FETCH_ADD(&Pool.Ticket, 1);
+        int const  k = (int) (v & 0xff);
+        int        t;
+
+        if (k >= (int) ((v >> 8) & 0xff)) {
+            return;
+        }
+        t = Pool.Due[k];
+        Pool.Res[k] = SS.Task[t].Desc->Calc(Pool.dt * SS.Task[t].Div);
+        SS_FETCH_ADD(&Pool.nDone, 1);
+    }
+}
+
+#if defined(WIN32)
+static DWORD WINAPI
+Pool_Worker(LPVOID arg)
+#else
+static void *
+Pool_Worker(void *arg)
+#endif
+{
+    unsigned seen = 0;
+    int      quit;
+
+    (void) arg;
+    for (;;) {
+#if defined(WIN32)
+        EnterCriticalSection(&Pool.Mutex);
+        while (Pool.Gen == seen && !Pool.Quit) {
+            SleepConditionVariableCS(&Pool.Cond, &Pool.Mutex, INFINITE);
+        }
+        seen = Pool.Gen;
+        quit = Pool.Quit;
+        LeaveCriticalSection(&Pool.Mutex);
+#else
+        pthread_mutex_lock(&Pool.Mutex);
+        while (Pool.Gen == seen && !Pool.Quit) {
+            pthread_cond_wait(&Pool.Cond, &Pool.Mutex);
+        }
+        seen = Pool.Gen;
+        quit = Pool.Quit;
+        pthread_mutex_unlock(&Pool.Mutex);
+#endif
+        if (quit) {
+            break;
+        }
+        Pool_RunTasks();
+    }
+    return 0;
+}
+
+/* Publish the due sensors of this cycle and wake up the workers */
+static void
+Pool_Start(double dt, int nDue)
+{
+    Pool.dt = dt;
+    SS_STORE(&Pool.nDone, 0);
+
+#if defined(WIN32)
+    EnterCriticalSection(&Pool.Mutex);
+    Pool.Gen++;
+    SS_STORE(&Pool.Ticket, SS_TICKET(nDue));
+    WakeAllConditionVariable(&Pool.Cond);
+    LeaveCriticalSection(&Pool.Mutex);
+#else
+    pthread_mutex_lock(&Pool.Mutex);
+    Pool.Gen++;
+    SS_STORE(&Pool.Ticket, SS_TICKET(nDue));
+    pthread_cond_broadcast(&Pool.Cond);
+    pthread_mutex_unlock(&Pool.Mutex);
+#endif
+}
+
+/*
+ * SensorSched_SetThreads ()
+ *
+ * Number of worker threads for the parallel sensor stage.
+ *
+ * Call:
+ * - before SensorSched_Init(), User_ScanCmdLine() (-sensorthreads <n>)
+ */
+
+void
+SensorSched_SetThreads(int n)
+{
+    Pool.nThreads = n < 0 ? 0 : n > SENSORSCHED_MAXTHREADS ? SENSORSCHED_MAXTHREADS : n;
+}
+
+/*
+ * SensorSched_Init ()
+ *
+ * Start the worker pool, if requested. The workers get the
+ * priority of the calling (main) thread.
+ *
+ * Call:
+ * - once at program start, MainThread_Init()
+ */
+
+int
+SensorSched_Init(void)
+{
+    int i;
+
+    if (Pool.nThreads == 0 || Pool.nRunning > 0) {
+        return 0;
+    }
+
+#if defined(WIN32)
+    InitializeCriticalSection(&Pool.Mutex);
+    InitializeConditionVariable(&Pool.Cond);
+#else
+    pthread_mutex_init(&Pool.Mutex, NULL);
+    pthread_cond_init(&Pool.Cond, NULL);
+#endif
+
+    for (i = 0; i < Pool.nThreads; i++) {
+#if defined(WIN32)
+        if ((Pool.Thread[i] = CreateThread(NULL, 0, Pool_Worker, NULL, 0, NULL)) == NULL) {
+            break;
+        }
+        SetThreadPriority(Pool.Thread[i], GetThreadPriority(GetCurrentThread()));
+#else
+        pthread_attr_t attr;
+        int            err;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        err = pthread_create(&Pool.Thread[i], &attr, Pool_Worker, NULL);
+        pthread_attr_destroy(&attr);
+        if (err != 0) {
+            break;
+        }
+#endif
+    }
+    Pool.nRunning = i;
+
+    if (Pool.nRunning < Pool.nThreads) {
+        LogWarnF(EC_Init, "SensorSched: only %d of %d worker threads started", Pool.nRunning, Pool.nThreads);
+    }
+    Log("SensorSched: %d worker threads\n", Pool.nRunning);
+    return 0;
+}
+
+/*
+ * SensorSched_TestRun_Start_Finalize ()
+ *
+ * Build the table of active sensors and their rate dividers.
+ * No allocation, only Info File lookups.
+ *
+ * Call:
+ * - RT context, App_TestRun_Start_Finalize()
+ *   (all sensor instances of the Test Run exist)
+ */
+
+int
+SensorSched_TestRun_Start_Finalize(struct tInfos *Inf)
+{
+    char   key[64], line[512];
+    int    i, all, len = 0;
+    double rate;
+
+    all      = iGetIntOpt(Inf, "SensorSched.All", 0);
+    SS.nTask = 0;
+    line[0]  = '\0';
+
+    for (i = 0; i < SS_NSENSORS; i++) {
+        tSensorDesc const *d = &SensorDesc[i];
+        int                div = 1;
+
+        if (!all && d->Count != NULL && *d->Count <= 0) {
+            continue;
+        }
+        if (!d->FixedRate) {
+            sprintf(key, "SensorSched.%s.Rate", d->Name);
+            rate = iGetDblOpt(Inf, key, 0.0);
+            if (rate < 0.0 || (rate == 0.0 && iGetStrOpt(Inf, key, NULL) != NULL)) {
+                continue;
+            }
+            if (rate > 0.0) {
+                div = (int) (1.0 / (rate * SimCore.DeltaT) + 0.5);
+                if (div < 1) {
+                    div = 1;
+                }
+            }
+        }
+
+        SS.Task[SS.nTask].Desc = d;
+        SS.Task[SS.nTask].Div  = div;
+        SS.Task[SS.nTask].Cnt  = 0;
+        SS.nTask++;
+
+        if (len < (int) sizeof(line) - 32) {
+            len += div > 1 ? sprintf(line + len, " %s/%d", d->Name, div)
+                           : sprintf(line + len, " %s", d->Name);
+        }
+    }
+
+    SS.Parallel = Pool.nRunning > 0 && iGetIntOpt(Inf, "SensorSched.Parallel", 0);
+
+    Log("SensorSched: %d of %d sensors%s:%s\n", SS.nTask, SS_NSENSORS,
+        SS.Parallel ? " (parallel)" : "", line);
+    return 0;
+}
+
+/* Rate divider: is task t due in this cycle? */
+static int
+IsDue(int t)
+{
+    if (SS.Task[t].Div > 1) {
+        if (SS.Task[t].Cnt-- > 0) {
+            return 0;
+        }
+        SS.Task[t].Cnt = SS.Task[t].Div - 1;
+    }
+    return 1;
+}
+
+/*
+ * SensorSched_Calc ()
+ *
+ * Call the sensors of the table that are due in this cycle.
+ * Returns rv, overwritten by the error code of a failing sensor
+ * (the last one in table order wins, as in the original if-chain).
+ *
+ * Parallel stage: the serial sensors (BdyFrame) first, then all other
+ * due sensors are spread over the worker pool and this thread. The
+ * stage is joined before returning and the return values are merged
+ * in table order, so rv is the same as in the serial case. CycleProf
+ * only sees the stage as a whole there (slot "SensorStage").
+ *
+ * Call:
+ * - RT context, App_TestRun_Calc_Part(), after CyclePart_Vhcl_Last
+ */
+
+int
+SensorSched_Calc(double dt, int rv)
+{
+    int i, nDue = 0;
+    CYCLEPROF_MARK(cpT);
+
+    if (!SS.Parallel) {
+        for (i = 0; i < SS.nTask; i++) {
+            tSensorDesc const *d = SS.Task[i].Desc;
+
+            if (!IsDue(i)) {
+                continue;
+            }
+            if (d->Calc(dt * SS.Task[i].Div) < 0) {
+                rv = d->ErrCode;
+            }
+            CYCLEPROF_LAP(d->Slot, cpT);
+        }
+        return rv;
+    }
+
+    for (i = 0; i < SS.nTask; i++) {
+        tSensorDesc const *d = SS.Task[i].Desc;
+
+        if (!IsDue(i)) {
+            continue;
+        }
+        if (d->Serial) {
+            if (d->Calc(dt * SS.Task[i].Div) < 0) {
+                rv = d->ErrCode;
+            }
+            CYCLEPROF_LAP(d->Slot, cpT);
+        } else {
+            Pool.Due[nDue++] = i;
+        }
+    }
+
+    if (nDue == 0) {
+        return rv;
+    }
+
+    Pool_Start(dt, nDue);
+    Pool_RunTasks();
+    while (SS_LOAD(&Pool.nDone) < nDue) {
+        SS_YIELD();
+    }
+
+    for (i = 0; i < nDue; i++) {
+        if (Pool.Res[i] < 0) {
+            rv = SS.Task[Pool.Due[i]].Desc->ErrCode;
+        }
+    }
+    CYCLEPROF_LAP(CPSlot_SensorStage, cpT);
+    return rv;
+}
+
+/*
+ * SensorSched_Cleanup ()
+ *
+ * Stop the worker pool.
+ *
+ * Call:
+ * - once at end of program, App_Cleanup()
+ */
+
+void
+SensorSched_Cleanup(void)
+{
+    int i;
+
+    if (Pool.nRunning == 0) {
+        return;
+    }
+
+#if defined(WIN32)
+    EnterCriticalSection(&Pool.Mutex);
+    Pool.Quit = 1;
+    WakeAllConditionVariable(&Pool.Cond);
+    LeaveCriticalSection(&Pool.Mutex);
+    WaitForMultipleObjects(Pool.nRunning, Pool.Thread, TRUE, INFINITE);
+    for (i = 0; i < Pool.nRunning; i++) {
+        CloseHandle(Pool.Thread[i]);
+    }
+    DeleteCriticalSection(&Pool.Mutex);
+#else
+    pthread_mutex_lock(&Pool.Mutex);
+    Pool.Quit = 1;
+    pthread_cond_broadcast(&Pool.Cond);
+    pthread_mutex_unlock(&Pool.Mutex);
+    for (i = 0; i < Pool.nRunning; i++) {
+        pthread_join(Pool.Thread[i], NULL);
+    }
+    pthread_cond_destroy(&Pool.Cond);
+    pthread_mutex_destroy(&Pool.Mutex);
+#endif
+
+    Pool.nRunning = 0;
+    Pool.Quit     = 0;
+    SS.Parallel   = 0;
+}
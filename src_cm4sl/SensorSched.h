@@ -0,0 +1,65 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Active-sensor dispatch table
+ *
+ * Instead of calling every sensor module in each cycle, a table of only
+ * the sensors the vehicle actually has (instance count > 0) is built once
+ * per Test Run in App_TestRun_Start_Finalize(). App_TestRun_Calc_Part()
+ * walks this table after CyclePart_Vhcl_Last, in the original calling
+ * order and with the original return codes.
+ *
+ * Collision, GNav, PylonDetect and Radar have no instance count and
+ * are always scheduled.
+ * The batch build (-DCM_NO_SENSORS) only has BdyFrame, Collision and
+ * PylonDetect in the table.
+ *
+ * Test Run Info File keys:
+ *	SensorSched.<Name>.Rate = <update rate in Hz>
+ *		called every round(1 / (Rate * DeltaT)) cycles with the
+ *		accumulated time step; <= 0 removes the sensor from the table.
+ *		Not available for BdyFrame (always every cycle).
+ *	SensorSched.All = 1
+ *		schedule every sensor, ignoring the instance counts
+ *
+ *	SensorSched.Parallel = 1
+ *		parallel sensor stage, if the worker pool is running
+ *
+ * <Name> as in CycleProf.h, e.g. SensorSched.LineSensor.Rate = 100
+ *
+ * Parallel sensor stage (command line option -sensorthreads <n>):
+ * n worker threads are started in MainThread_Init() and wait for the
+ * sensors of each cycle. After BdyFrame, the due sensors are claimed
+ * one by one by the workers and the main thread, and the stage is
+ * joined before User_Calc(). The error codes are merged in table
+ * order, rv is the same as with the serial stage. Only for sensors
+ * that don't share state; enable per Test Run.
+ *
+ *****************************************************************************
+ */
+
+#ifndef _SENSORSCHED_H__
+#define _SENSORSCHED_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+#define SENSORSCHED_MAXTHREADS 16
+
+void SensorSched_SetThreads(int n);
+int  SensorSched_Init(void);
+int  SensorSched_TestRun_Start_Finalize(struct tInfos *Inf);
+int  SensorSched_Calc(double dt, int rv);
+void SensorSched_Cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _SENSORSCHED_H__ */
@@ -0,0 +1,307 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Live telemetry in shared memory (see Telemetry.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - Telemetry_SetName ()
+ * - Telemetry_Init ()
+ * - Telemetry_TestRun_Start ()
+ * - Telemetry_TestRun_Start_Finalize ()
+ * - Telemetry_Publish ()
+ * - Telemetry_Cleanup ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#if defined(WIN32)
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CarMaker.h>
+
+#include "Telemetry.h"
+
+/* Frame / layout stores must be visible before the counter update */
+#if defined(_MSC_VER)
+# define TLM_RELEASE() MemoryBarrier()
+#elif defined(__GNUC__)
+# define TLM_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+# define TLM_RELEASE() ((void) 0)
+#endif
+
+static char const *DefaultQuants = "Car.v Car.YawRate Car.Roll Car.ay Vhcl.Distance";
+
+typedef struct {
+    int          nQuants;
+    int          Cycles;
+    char         Tag[64];
+    char         Name[TELEMETRY_MAXQUANTS][TELEMETRY_NAMELEN];
+    tDDictEntry *Quant[TELEMETRY_MAXQUANTS];
+} tTlmConfig;
+
+static struct {
+    char           ShmName[128];
+    tTelemetryShm *Shm;
+#if defined(WIN32)
+    HANDLE         hMap;
+#endif
+
+    tTlmConfig     Active;      /* main thread */
+    tTlmConfig     Next;        /* read in at Test Run start */
+    unsigned       RunNo;
+    unsigned       Count;
+} Tlm;
+
+/*
+ * Telemetry_SetName ()
+ *
+ * Call:
+ * - command line option -telemetry, User_ScanCmdLine()
+ */
+
+void
+Telemetry_SetName(char const *name)
+{
+    strncpy(Tlm.ShmName, name, sizeof(Tlm.ShmName) - 1);
+    Tlm.ShmName[sizeof(Tlm.ShmName) - 1] = '\0';
+}
+
+/*
+ * Telemetry_Init ()
+ *
+ * Create the shared memory region, if a name is given.
+ *
+ * Call:
+ * - once at program start, User_Init()
+ * - no realtime conditions
+ */
+
+int
+Telemetry_Init(void)
+{
+    tTelemetryShm *shm;
+    size_t         size = sizeof(tTelemetryShm);
+
+    if (Tlm.ShmName[0] == '\0') {
+        char const *env = getenv("CM_TELEMETRY");
+        if (env == NULL || *env == '\0') {
+            return 0;
+        }
+        Telemetry_SetName(env);
+    }
+
+#if defined(WIN32)
+    Tlm.hMap = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD) size,
+                                  Tlm.ShmName);
+    if (Tlm.hMap == NULL) {
+        LogErrF(EC_Init, "Telemetry: can't create shared memory '%s'", Tlm.ShmName);
+        return -1;
+    }
+    if ((shm = (tTelemetryShm *) MapViewOfFile(Tlm.hMap, FILE_MAP_ALL_ACCESS, 0, 0, size)) == NULL) {
+        LogErrF(EC_Init, "Telemetry: can't map shared memory '%s'", Tlm.ShmName);
+        CloseHandle(Tlm.hMap);
+        Tlm.hMap = NULL;
+        return -1;
+    }
+#else
+    {
+        char path[sizeof(Tlm.ShmName) + 1];
+        int  fd;
+        void *p;
+
+        sprintf(path, "/%s", Tlm.ShmName);
+        if ((fd = shm_open(path, O_CREAT | O_RDWR, 0644)) < 0) {
+            LogErrF(EC_Init, "Telemetry: can't create shared memory '%s'", path);
+            return -1;
+        }
+        if (ftruncate(fd, (off_t) size) < 0
+            || (p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+            LogErrF(EC_Init, "Telemetry: can't map shared memory '%s'", path);
+            close(fd);
+            return -1;
+        }
+        close(fd);
+        shm = (tTelemetryShm *) p;
+    }
+#endif
+
+    memset(shm, 0, size);
+    shm->Version     = TELEMETRY_VERSION;
+    shm->MaxQuants   = TELEMETRY_MAXQUANTS;
+    shm->FrameOffset = (unsigned) ((char *) &shm->Frame[0] - (char *) shm);
+    shm->FrameSize   = (unsigned) sizeof(tTelemetryFrame);
+    TLM_RELEASE();
+    shm->Magic = TELEMETRY_MAGIC;
+
+    Tlm.Shm           = shm;
+    Tlm.Active.Cycles = 10;
+
+    Log("Telemetry: shared memory '%s', %u bytes\n", Tlm.ShmName, (unsigned) size);
+    return 0;
+}
+
+/*
+ * Telemetry_TestRun_Start ()
+ *
+ * Read the Telemetry.* keys and resolve the quantities. Takes effect
+ * in Telemetry_TestRun_Start_Finalize().
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), User_TestRun_Start_atEnd()
+ */
+
+int
+Telemetry_TestRun_Start(struct tInfos *Inf)
+{
+    tTlmConfig *cf = &Tlm.Next;
+    char const *s;
+    char        buf[2048], *tok;
+
+    if (Tlm.Shm == NULL) {
+        return 0;
+    }
+
+    cf->nQuants = 0;
+    if ((cf->Cycles = iGetIntOpt(Inf, "Telemetry.Cycles", 10)) < 1) {
+        cf->Cycles = 1;
+    }
+    s = iGetStrOpt(Inf, "ResultLink.Tag", "");
+    strncpy(cf->Tag, s, sizeof(cf->Tag) - 1);
+    cf->Tag[sizeof(cf->Tag) - 1] = '\0';
+
+    s = iGetStrOpt(Inf, "Telemetry.Quantities", DefaultQuants);
+    strncpy(buf, s, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (tok = strtok(buf, " \t,"); tok != NULL; tok = strtok(NULL, " \t,")) {
+        if (cf->nQuants >= TELEMETRY_MAXQUANTS) {
+            LogWarnF(EC_General, "Telemetry: too many quantities, '%s' ignored", tok);
+            continue;
+        }
+        if ((cf->Quant[cf->nQuants] = DDictGetEntry(tok)) == NULL) {
+            LogWarnF(EC_General, "Telemetry: unknown quantity '%s'", tok);
+            continue;
+        }
+        strncpy(cf->Name[cf->nQuants], tok, TELEMETRY_NAMELEN - 1);
+        cf->Name[cf->nQuants][TELEMETRY_NAMELEN - 1] = '\0';
+        cf->nQuants++;
+    }
+    return 0;
+}
+
+/*
+ * Telemetry_TestRun_Start_Finalize ()
+ *
+ * Switch to the configuration of the new Test Run and publish its
+ * layout (names, Tag, RunNo).
+ *
+ * Call:
+ * - in main task (realtime conditions), User_TestRun_Start_Finalize()
+ */
+
+void
+Telemetry_TestRun_Start_Finalize(void)
+{
+    tTelemetryShm *shm = Tlm.Shm;
+    int            i;
+
+    if (shm == NULL) {
+        return;
+    }
+
+    memcpy(&Tlm.Active, &Tlm.Next, sizeof(Tlm.Active));
+    Tlm.Count = 0;
+    Tlm.RunNo++;
+
+    shm->Layout++;
+    TLM_RELEASE();
+    shm->nQuants = (unsigned) Tlm.Active.nQuants;
+    shm->RunNo   = Tlm.RunNo;
+    memcpy(shm->Tag, Tlm.Active.Tag, sizeof(shm->Tag));
+    memset(shm->Name, 0, sizeof(shm->Name));
+    for (i = 0; i < Tlm.Active.nQuants; i++) {
+        memcpy(shm->Name[i], Tlm.Active.Name[i], TELEMETRY_NAMELEN);
+    }
+    TLM_RELEASE();
+    shm->Layout++;
+}
+
+/*
+ * Telemetry_Publish ()
+ *
+ * Write a frame, every Telemetry.Cycles calls.
+ *
+ * Call:
+ * - in main task (realtime conditions), MainThread_FinishCycle()
+ */
+
+void
+Telemetry_Publish(unsigned long long CycleNo)
+{
+    tTelemetryShm   *shm = Tlm.Shm;
+    tTelemetryFrame *fr;
+    int              i;
+
+    if (shm == NULL || ++Tlm.Count < (unsigned) Tlm.Active.Cycles) {
+        return;
+    }
+    Tlm.Count = 0;
+
+    fr          = &shm->Frame[(shm->Seq + 1) & 1];
+    fr->CycleNo  = CycleNo;
+    fr->Time     = SimCore.Time;
+    fr->Layout   = shm->Layout;
+    fr->Simulate = SimCore.State == SCState_Simulate;
+    for (i = 0; i < Tlm.Active.nQuants; i++) {
+        fr->Value[i] = DDictGetValue(Tlm.Active.Quant[i]);
+    }
+    TLM_RELEASE();
+    shm->Seq++;
+}
+
+/*
+ * Telemetry_Cleanup ()
+ *
+ * Call:
+ * - once at end of program, User_Cleanup()
+ */
+
+void
+Telemetry_Cleanup(void)
+{
+    if (Tlm.Shm == NULL) {
+        return;
+    }
+    Tlm.Shm->Magic = 0;
+#if defined(WIN32)
+    UnmapViewOfFile(Tlm.Shm);
+    CloseHandle(Tlm.hMap);
+    Tlm.hMap = NULL;
+#else
+    {
+        char path[sizeof(Tlm.ShmName) + 1];
+
+        munmap(Tlm.Shm, sizeof(tTelemetryShm));
+        sprintf(path, "/%s", Tlm.ShmName);
+        shm_unlink(path);
+    }
+#endif
+    Tlm.Shm = NULL;
+}
@@ -0,0 +1,89 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Live telemetry in shared memory
+ *
+ * A configured set of DDict quantities is copied into a named shared
+ * memory region from MainThread_FinishCycle(). Readers (the dashboard)
+ * map the region and never block the main loop; the writer doesn't
+ * know about them.
+ *
+ * Region name (none = disabled):
+ *	command line option -telemetry <name>, or CM_TELEMETRY=<name>
+ *	Windows: named file mapping <name>, Linux: shm_open("/<name>")
+ *
+ * Test Run Info File keys:
+ *	Telemetry.Quantities = <DDict names, separated by blanks>
+ *		default Car.v Car.YawRate Car.Roll Car.ay Vhcl.Distance
+ *	Telemetry.Cycles = <publish every n cycles>, default 10
+ *
+ * Layout (little endian, tTelemetryShm below):
+ * - header: Magic, Version, MaxQuants, FrameOffset, FrameSize, Layout,
+ *   nQuants, RunNo, Tag (ResultLink.Tag of the Test Run) and the names
+ *   of the quantities. Changed only in App_TestRun_Start_Finalize();
+ *   Layout is odd meanwhile and incremented by 2 per change.
+ * - Seq and two frames. A frame is written into Frame[(Seq + 1) & 1],
+ *   then Seq is incremented: Frame[Seq & 1] is the last complete one
+ *   and is not touched before the next publish.
+ *
+ * Reader:
+ *	s = Seq; copy Frame[s & 1]; valid if Seq is still s
+ *	names valid for frames with Frame.Layout == Layout (even)
+ *
+ *****************************************************************************
+ */
+
+#ifndef _TELEMETRY_H__
+#define _TELEMETRY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+#define TELEMETRY_MAGIC     0x4c544d43  /* "CMTL" */
+#define TELEMETRY_VERSION   1
+#define TELEMETRY_MAXQUANTS 64
+#define TELEMETRY_NAMELEN   64
+
+typedef struct tTelemetryFrame {
+    unsigned long long CycleNo;
+    double             Time;
+    unsigned           Layout;
+    int                Simulate;    /* SimCore.State == SCState_Simulate */
+    double             Value[TELEMETRY_MAXQUANTS];
+} tTelemetryFrame;
+
+typedef struct tTelemetryShm {
+    unsigned          Magic;
+    unsigned          Version;
+    unsigned          MaxQuants;
+    unsigned          FrameOffset;
+    unsigned          FrameSize;
+    volatile unsigned Layout;
+    unsigned          nQuants;
+    unsigned          RunNo;
+    char              Tag[64];
+    char              Name[TELEMETRY_MAXQUANTS][TELEMETRY_NAMELEN];
+
+    volatile unsigned Seq;
+    unsigned          Reserved;
+    tTelemetryFrame   Frame[2];
+} tTelemetryShm;
+
+void Telemetry_SetName(char const *name);
+int  Telemetry_Init(void);
+int  Telemetry_TestRun_Start(struct tInfos *Inf);
+void Telemetry_TestRun_Start_Finalize(void);
+void Telemetry_Publish(unsigned long long CycleNo);
+void Telemetry_Cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _TELEMETRY_H__ */
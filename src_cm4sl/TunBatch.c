@@ -0,0 +1,220 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Batch service for tunable model parameters (see TunBatch.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - TunBatch_Register ()
+ * - TunBatch_TestRun_Start ()
+ * - TunBatch_TestRun_End_First ()
+ * - TunBatch_Cleanup ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include "TunBatch.h"
+
+#if defined(CM_TUNBATCH)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CarMaker.h>
+
+#include "ResultLink.h"
+
+typedef struct {
+    char                      Name[64];
+    const struct tMatSuppMMI *MMI;
+    int                       nParams;
+    char                    **Param;   /* MatSupp_TunListAll() */
+    char                    **Key;     /* "Tun.<model>.<param>" */
+} tTBModel;
+
+static struct {
+    int      nModels;
+    tTBModel Model[TUNBATCH_MAXMODELS];
+    int      nSet;                     /* parameters set in this Test Run */
+} TB;
+
+static void
+FreeModel(tTBModel *m)
+{
+    int i;
+
+    for (i = 0; i < m->nParams; i++) {
+        free(m->Param[i]);
+        free(m->Key[i]);
+    }
+    free(m->Param);
+    free(m->Key);
+    m->Param   = NULL;
+    m->Key     = NULL;
+    m->nParams = 0;
+}
+
+/*
+ * TunBatch_Register ()
+ *
+ * Register a model and cache its parameter names and Info File keys.
+ * Registering the same model again replaces the entry.
+ *
+ * Call:
+ * - in the model's wrapper, once the model's mapping info is valid
+ * - no realtime conditions
+ */
+
+int
+TunBatch_Register(char const *model, const struct tMatSuppMMI *mmi)
+{
+    tMatSuppTunables *tuns;
+    tTBModel         *m = NULL;
+    char             *key;
+    int               i, n;
+
+    for (i = 0; i < TB.nModels; i++) {
+        if (strcmp(TB.Model[i].Name, model) == 0) {
+            m = &TB.Model[i];
+            FreeModel(m);
+            break;
+        }
+    }
+    if (m == NULL) {
+        if (TB.nModels >= TUNBATCH_MAXMODELS) {
+            LogErrF(EC_Init, "TunBatch: too many models, '%s' ignored", model);
+            return -1;
+        }
+        m = &TB.Model[TB.nModels++];
+        strncpy(m->Name, model, sizeof(m->Name) - 1);
+        m->Name[sizeof(m->Name) - 1] = '\0';
+    }
+    m->MMI = mmi;
+
+    if ((tuns = MatSupp_TunBegin(model, mmi)) == NULL) {
+        Log("TunBatch: model '%s' has no tunable parameters\n", model);
+        return 0;
+    }
+    m->Param = MatSupp_TunListAll(tuns, &n);
+    MatSupp_TunEnd(tuns);
+
+    if ((m->Key = (char **) calloc(n > 0 ? n : 1, sizeof(char *))) == NULL) {
+        LogErrF(EC_Init, "TunBatch: out of memory");
+        return -1;
+    }
+    m->nParams = n;
+    for (i = 0; i < n; i++) {
+        if ((key = (char *) malloc(strlen(model) + strlen(m->Param[i]) + 6)) == NULL) {
+            LogErrF(EC_Init, "TunBatch: out of memory");
+            return -1;
+        }
+        sprintf(key, "Tun.%s.%s", model, m->Param[i]);
+        m->Key[i] = key;
+    }
+    Log("TunBatch: model '%s', %d tunable parameter(s)\n", model, n);
+    return 0;
+}
+
+/*
+ * TunBatch_TestRun_Start ()
+ *
+ * Set every registered parameter that has a Tun.<model>.<param> key,
+ * one MatSupp tuning session per model.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), User_TestRun_Start_atEnd()
+ * - after the models have read their parameters
+ */
+
+int
+TunBatch_TestRun_Start(struct tInfos *Inf)
+{
+    char **keys;
+    int    i, j, n, rv = 0;
+
+    TB.nSet = 0;
+    for (i = 0; i < TB.nModels; i++) {
+        tTBModel         *m    = &TB.Model[i];
+        tMatSuppTunables *tuns = NULL;
+
+        for (j = 0; j < m->nParams; j++) {
+            if (iGetStrOpt(Inf, m->Key[j], NULL) == NULL) {
+                continue;
+            }
+            if (tuns == NULL && (tuns = MatSupp_TunBegin(m->Name, m->MMI)) == NULL) {
+                LogErrF(EC_Init, "TunBatch: can't tune model '%s'", m->Name);
+                rv = -1;
+                break;
+            }
+            if (MatSupp_TunRead(tuns, m->Param[j], Inf, m->Key[j]) < 0) {
+                rv = -1;
+            } else {
+                TB.nSet++;
+            }
+        }
+        if (tuns != NULL) {
+            MatSupp_TunEnd(tuns);
+        }
+    }
+
+    if (TB.nSet > 0) {
+        Log("TunBatch: %d parameter(s) set\n", TB.nSet);
+    }
+
+    /* Keys of an unregistered model or unknown parameter are not set */
+    if ((keys = InfoListKeys(Inf, "Tun.", 0)) != NULL) {
+        for (n = 0; keys[n] != NULL; n++)
+            ;
+        if (n > TB.nSet) {
+            LogWarnF(EC_General, "TunBatch: %d of %d Tun.* key(s) not set (%d model(s) registered, "
+                     "TunBatch_Register() missing in a model wrapper?)", n - TB.nSet, n, TB.nModels);
+        }
+        free(keys);
+    }
+    return rv;
+}
+
+/*
+ * TunBatch_TestRun_End_First ()
+ *
+ * Call:
+ * - in main task (realtime conditions), User_TestRun_End_First()
+ */
+
+void
+TunBatch_TestRun_End_First(void)
+{
+    ResultLink_Add("TunBatch.n", TB.nSet);
+}
+
+/*
+ * TunBatch_Cleanup ()
+ *
+ * Call:
+ * - once at end of program, just before exit
+ */
+
+void
+TunBatch_Cleanup(void)
+{
+    int i;
+
+    for (i = 0; i < TB.nModels; i++) {
+        FreeModel(&TB.Model[i]);
+    }
+    TB.nModels = 0;
+}
+
+#else
+
+/* ISO C forbids an empty translation unit */
+typedef int tTunBatch_Disabled;
+
+#endif /* CM_TUNBATCH */
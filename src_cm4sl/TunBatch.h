@@ -0,0 +1,70 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Batch service for the tunable parameters of RTW-built Simulink models
+ *
+ * Controller gains (TC_Derivative, TV_Override, Brake_Mech_Rec_Ratio, ...)
+ * are set per Test Run from Test Run Info File keys
+ *	Tun.<model>.<param> = <value(s)>
+ * instead of regenerating workspace variables. A model registers once
+ * from its wrapper:
+ *	XXX_New():	TunBatch_Register("OPENXWD", &(rtmGetDataMapInfo(rtm).mmi));
+ * Its parameter names (MatSupp_TunListAll()) and Info File keys are
+ * resolved at registration and cached. In User_TestRun_Start_atEnd(),
+ * after the models have read their own parameters, one pass sets all
+ * parameters with a key, with one MatSupp_TunBegin()/MatSupp_TunEnd()
+ * per model.
+ *
+ * The wrappers are generated by the CarMaker target and aren't part of
+ * this tree: the TunBatch_Register() call has to be added to XXX_New()
+ * after each code generation. Keys of a model that didn't register are
+ * not set, with a warning at Test Run start and TunBatch.n lower than
+ * the number of keys (the optimizer fails the trial).
+ *
+ * The keys can also be sent between Test Runs without writing the Test
+ * Run, as TestRun keys of a HotParam message (HotParam.h).
+ * The number of parameters set is reported as TunBatch.n with the
+ * ResultLink message.
+ *
+ * Compile with -DCM_TUNBATCH and link $(MATSUPP_LIB) (see Makefile);
+ * otherwise the TunBatch_* calls in User.c are empty.
+ *
+ *****************************************************************************
+ */
+
+#ifndef _TUNBATCH_H__
+#define _TUNBATCH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+#define TUNBATCH_MAXMODELS 16
+
+#if defined(CM_TUNBATCH)
+
+# include "MatSupp.h"
+
+int  TunBatch_Register(char const *model, const struct tMatSuppMMI *mmi);
+int  TunBatch_TestRun_Start(struct tInfos *Inf);
+void TunBatch_TestRun_End_First(void);
+void TunBatch_Cleanup(void);
+
+#else
+
+# define TunBatch_TestRun_Start(Inf) 0
+# define TunBatch_TestRun_End_First()
+# define TunBatch_Cleanup()
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _TUNBATCH_H__ */
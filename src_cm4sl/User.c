@@ -86,12 +86,23 @@
 #include <ADASRP.h>
 
 #include "IOVec.h"
+#include "BinExport.h"
+#include "HotParam.h"
+#include "KPI.h"
+#include "MultiRate.h"
+#include "Prune.h"
+#include "ResultLink.h"
+#include "SensorSched.h"
+#include "Telemetry.h"
+#include "TunBatch.h"
 #include "User.h"
+#include "WarmStart.h"
 
 /* @@PLUGIN-BEGIN-INCLUDE@@ - Automatically generated code - don't edit! */
 /* @@PLUGIN-END@@ */
 
 int UserCalcCalledByAppTestRunCalc = 0;
+int UserHeadless                   = 0;
 
 tUser User;
 
@@ -127,6 +138,12 @@ User_PrintUsage(char const *Pgm)
     LogUsage("\n");
     LogUsage("Usage: %s [options] [testrun]\n", Pgm);
     LogUsage("Options:\n");
+    LogUsage(" -sensorthreads <n>  Worker threads for the parallel sensor stage (SensorSched.Parallel)\n");
+    LogUsage(" -headless           Batch mode without visualization (also CM_HEADLESS=1)\n");
+    LogUsage(" -telemetry <name>   Live telemetry in shared memory <name> (also CM_TELEMETRY)\n");
+#if defined(CM_CALBENCH)
+    LogUsage(" -calbench <n>       Benchmark the I/O calibration with n channels and exit\n");
+#endif
 
 #if defined(CM_HIL)
     {
@@ -160,11 +177,29 @@ User_ScanCmdLine(int argc, char **argv)
        specified on the command line. */
     IO_SelectDefault("default" /* or "brakecu", "stwheel", "can,flexray" etc. */);
 
+    /* Optimizer sessions may not control the command line */
+    {
+        char const *env = getenv("CM_HEADLESS");
+        if (env != NULL && atoi(env) != 0) {
+            UserHeadless = 1;
+        }
+    }
+
     while (*++argv) {
         if (strcmp(*argv, "-io") == 0 && argv[1] != NULL) {
             if (IO_Select(*++argv) != 0) {
                 return NULL;
             }
+        } else if (strcmp(*argv, "-sensorthreads") == 0 && argv[1] != NULL) {
+            SensorSched_SetThreads(atoi(*++argv));
+        } else if (strcmp(*argv, "-headless") == 0) {
+            UserHeadless = 1;
+        } else if (strcmp(*argv, "-telemetry") == 0 && argv[1] != NULL) {
+            Telemetry_SetName(*++argv);
+#if defined(CM_CALBENCH)
+        } else if (strcmp(*argv, "-calbench") == 0 && argv[1] != NULL) {
+            exit(IO_CalBench(atoi(*++argv), 100000) != 0);
+#endif
         } else if (strcmp(*argv, "-h") == 0 || strcmp(*argv, "-help") == 0) {
             User_PrintUsage(Pgm);
             SimCore_PrintUsage(Pgm); /* Possible exit(), depending on CM-platform! */
@@ -193,6 +228,13 @@ User_ScanCmdLine(int argc, char **argv)
 int
 User_Init(void)
 {
+    if (ResultLink_Init() < 0) {
+        return -1;
+    }
+    if (Telemetry_Init() < 0) {
+        return -1;
+    }
+
     return 0;
 }
 
@@ -225,6 +267,8 @@ User_DeclQuants(void)
         sprintf(sbuf, "UserOut_%02d", i);
         DDefDouble(NULL, sbuf, "", &User.Out[i], DVA_IO_Out);
     }
+
+    KPI_DeclQuants();
 }
 
 /*
@@ -332,6 +376,10 @@ User_TestRun_Start_atBegin(void)
     for (i = 0; i < N_USEROUTPUT; i++) {
         User.Out[i] = 0.0;
     }
+    WarmStart_TestRun_Start_atBegin();
+    if (HotParam_TestRun_Start_atBegin() < 0) {
+        rv = -1;
+    }
 
     if (IO_None) {
         return rv;
@@ -369,6 +417,23 @@ User_TestRun_Start_atEnd(void)
 #if defined(XENO)
     IOConf_DeclQuants();
 #endif
+    if (ResultLink_TestRun_Start(SimCore.TestRun.Inf) < 0) {
+        return -1;
+    }
+    KPI_TestRun_Start();
+    Prune_TestRun_Start(SimCore.TestRun.Inf);
+    WarmStart_TestRun_Start(SimCore.TestRun.Inf);
+    if (BinExport_TestRun_Start(SimCore.TestRun.Inf) < 0) {
+        return -1;
+    }
+    if (TunBatch_TestRun_Start(SimCore.TestRun.Inf) < 0) {
+        return -1;
+    }
+    if (MultiRate_TestRun_Start(SimCore.TestRun.Inf) < 0) {
+        return -1;
+    }
+    Telemetry_TestRun_Start(SimCore.TestRun.Inf);
+
     return 0;
 }
 
@@ -393,6 +458,8 @@ User_TestRun_Start_StaticCond_Calc(void)
 int
 User_TestRun_Start_Finalize(void)
 {
+    WarmStart_TestRun_Start_Finalize();
+    Telemetry_TestRun_Start_Finalize();
     return 0;
 }
 
@@ -438,6 +505,15 @@ User_TestRun_RampUp(double dt)
 int
 User_TestRun_End_First(void)
 {
+    /* Freeze the final values for the result message */
+    ResultLink_Add("Time", SimCore.Time);
+    ResultLink_AddQuants();
+    KPI_TestRun_End_First();
+    Prune_TestRun_End_First();
+    WarmStart_TestRun_End_First();
+    HotParam_TestRun_End_First();
+    TunBatch_TestRun_End_First();
+
     return 0;
 }
 
@@ -457,6 +533,10 @@ User_TestRun_End_First(void)
 int
 User_TestRun_End(void)
 {
+    ResultLink_Send();
+    BinExport_TestRun_End();
+    WarmStart_TestRun_End();
+
     return 0;
 }
 
@@ -572,6 +652,11 @@ User_Calc(double dt)
        of CM 5.1 and earlier. */
     /*if (!UserCalcCalledByAppTestRunCalc) return 0;*/
 
+    if (SimCore.State == SCState_Simulate && UserCalcCalledByAppTestRunCalc) {
+        KPI_Calc(dt);
+        Prune_Calc(dt);
+    }
+
     return 0;
 }
 
@@ -599,6 +684,11 @@ User_Check_IsIdle(int IsIdle)
 {
     double val;
 
+    /* Pruned optimizer trial: don't wait for the vehicle to stand still */
+    if (Prune_HasStopped()) {
+        return 1;
+    }
+
     /*** ECU / carmodel signals */
 
     /* vehicle and wheels: stand still */
@@ -638,6 +728,8 @@ User_Out(unsigned const CycleNo)
     if (SimCore.State != SCState_Simulate) {
         return;
     }
+
+    BinExport_Out();
 }
 
 /*
@@ -660,6 +752,10 @@ User_Out(unsigned const CycleNo)
 int
 User_ApoMsg_Eval(int Ch, char *Msg, int len, int who)
 {
+    if (HotParam_ApoMsg_Eval(Ch, Msg, len) == 0) {
+        return 0;
+    }
+
     if (Ch == ApoCh_CarMaker) {
 #if defined(CM_HIL)
         /*** Fail Safe Tester */
@@ -686,6 +782,7 @@ User_ApoMsg_Eval(int Ch, char *Msg, int len, int who)
 void
 User_ApoMsg_Send(double T, unsigned const CycleNo)
 {
+    HotParam_Poll(CycleNo);
 }
 
 /*
@@ -741,4 +838,8 @@ User_End(void)
 void
 User_Cleanup(void)
 {
+    ResultLink_Cleanup();
+    Telemetry_Cleanup();
+    BinExport_Cleanup();
+    TunBatch_Cleanup();
 }
@@ -19,6 +19,10 @@ extern "C" {
 #endif
 
 extern int UserCalcCalledByAppTestRunCalc;
+/* Headless batch mode: no movie / GPU sensor gathering without GPU sensors,
+   no waiting for animation clients (-headless, or CM_HEADLESS=1).
+   Cycle pacing is unchanged (SimCore_WaitForNextLoop()). */
+extern int UserHeadless;
 
 #define N_USEROUTPUT 10
 
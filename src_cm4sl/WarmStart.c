@@ -0,0 +1,120 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Warm start of optimizer trials from a settled baseline snapshot
+ * (see WarmStart.h)
+ *
+ * Functions
+ * ---------
+ *
+ * - WarmStart_TestRun_Start_atBegin ()
+ * - WarmStart_TestRun_Start ()
+ * - WarmStart_TestRun_Start_Finalize ()
+ * - WarmStart_TestRun_End_First ()
+ * - WarmStart_TestRun_End ()
+ *
+ *****************************************************************************
+ */
+
+#include <Global.h>
+
+#include <CarMaker.h>
+
+#include "ResultLink.h"
+#include "WarmStart.h"
+
+static struct {
+    int    Take;            /* snapshot requested by this Test Run */
+    int    SnapshotFlags;   /* AppStartInfo.Snapshot before */
+    double tStart;          /* wall clock, s */
+    double StartTime;       /* start phase duration, s */
+} WS;
+
+/*
+ * WarmStart_TestRun_Start_atBegin ()
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - User_TestRun_Start_atBegin()
+ */
+
+void
+WarmStart_TestRun_Start_atBegin(void)
+{
+    WS.tStart    = SysGetTime();
+    WS.StartTime = 0.0;
+}
+
+/*
+ * WarmStart_TestRun_Start ()
+ *
+ * Read WarmStart.Take and request the snapshot for this Test Run.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions)
+ * - when starting a new Test Run, after all models are read in
+ */
+
+int
+WarmStart_TestRun_Start(struct tInfos *Inf)
+{
+    WS.Take          = iGetIntOpt(Inf, "WarmStart.Take", 0) != 0;
+    WS.SnapshotFlags = AppStartInfo.Snapshot;
+
+    if (WS.Take) {
+        if (iGetDblOpt(Inf, "Snapshot.TimeLimit", 0.0) <= 0.0 && iGetDblOpt(Inf, "Snapshot.DistLimit", 0.0) <= 0.0) {
+            LogWarnF(EC_Init, "WarmStart: Snapshot.TimeLimit/DistLimit not set, snapshot at Test Run end");
+        }
+        AppStartInfo.Snapshot |= Snapshot_Take;
+    }
+    return 0;
+}
+
+/*
+ * WarmStart_TestRun_Start_Finalize ()
+ *
+ * Call:
+ * - RT context, User_TestRun_Start_Finalize()
+ */
+
+void
+WarmStart_TestRun_Start_Finalize(void)
+{
+    WS.StartTime = SysGetTime() - WS.tStart;
+}
+
+/*
+ * WarmStart_TestRun_End_First ()
+ *
+ * Call:
+ * - RT context, User_TestRun_End_First()
+ */
+
+void
+WarmStart_TestRun_End_First(void)
+{
+    ResultLink_Add("WarmStart.StartTime", WS.StartTime);
+    ResultLink_Add("WarmStart.Take",      (double) WS.Take);
+}
+
+/*
+ * WarmStart_TestRun_End ()
+ *
+ * Restore the snapshot setting of the command line, the snapshot
+ * has been exported by App_TestRun_End() already.
+ *
+ * Call:
+ * - in separate thread (no realtime conditions), User_TestRun_End()
+ */
+
+void
+WarmStart_TestRun_End(void)
+{
+    if (WS.Take) {
+        AppStartInfo.Snapshot = WS.SnapshotFlags;
+        WS.Take               = 0;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ *****************************************************************************
+ *  CarMaker Black-Box Optimization Framework
+ *  Optimizer module of the CarMaker for Simulink application
+ *****************************************************************************
+ *
+ * Warm start of optimizer trials from a settled baseline snapshot
+ *
+ * Baseline run: a short Test Run with WarmStart.Take = 1 ends after
+ * Snapshot.TimeLimit seconds (settled car) and exports the vehicle state
+ * as a snapshot vehicle data set, like the -snapshot command line
+ * option, but for this Test Run only. The optimizer then starts later
+ * trials from that data set with only the changed parameters replaced
+ * (CarMakerInterface._warm_vehicle()), so the static conditions start
+ * next to the equilibrium instead of from the design position.
+ *
+ * Fork (ForkSweep in src/core/fork_sweep.py): the same with
+ * Snapshot.DistLimit takes the snapshot in the middle of a lap. Variants
+ * of the setup continue from that data set as Test Runs of their own,
+ * started at the route position and speed of the fork point
+ * (Vehicle.StartPos, DrivMan.Man.Start.Velocity). They run in parallel
+ * on several sessions or one after the other on a session by hot
+ * parameter injection (HotParam.h), which only restarts the loaded
+ * variant Test Run.
+ *
+ * The wall clock time from User_TestRun_Start_atBegin() to
+ * User_TestRun_Start_Finalize() is reported as WarmStart.StartTime [s]
+ * with the ResultLink message of every Test Run.
+ *
+ * Test Run Info File keys:
+ *	WarmStart.Take     = 1 take the snapshot at the end of this Test Run
+ *	Snapshot.TimeLimit = <s> end of the baseline run (CarMaker key)
+ *	Snapshot.DistLimit = <m> or end at the fork point (CarMaker key)
+ *	Snapshot.FName     = <snapshot file> (CarMaker key)
+ *
+ *****************************************************************************
+ */
+
+#ifndef _WARMSTART_H__
+#define _WARMSTART_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tInfos;
+
+void WarmStart_TestRun_Start_atBegin(void);
+int  WarmStart_TestRun_Start(struct tInfos *Inf);
+void WarmStart_TestRun_Start_Finalize(void);
+void WarmStart_TestRun_End_First(void);
+void WarmStart_TestRun_End(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _WARMSTART_H__ */
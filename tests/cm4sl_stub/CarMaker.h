@@ -0,0 +1,26 @@
+/* Test stub of the CarMaker header, just enough to build the app modules under test
+   (KPI.c: test_kpi_stream.py, EnvKeep.c: test_envkeep.py) */
+#ifndef _CARMAKER_H__
+#define _CARMAKER_H__
+
+typedef struct tDDictEntry tDDictEntry;
+struct tInfos;
+
+enum { DVA_None };
+enum { EC_General, EC_Init };
+
+tDDictEntry *DDictGetEntry(char const *name);
+double       DDictGetValue(tDDictEntry const *e);
+void         DDefDouble(void *owner, char const *name, char const *unit, double *var, int dva);
+void         LogWarnF(int ec, char const *fmt, ...);
+void         Log(char const *fmt, ...);
+
+char       **InfoListKeys(struct tInfos *Inf, char const *prefix, int flags);
+char const  *iGetStrOpt(struct tInfos *Inf, char const *key, char const *def);
+char       **iGetTxtOpt(struct tInfos *Inf, char const *key, char **def);
+int          iGetIntOpt(struct tInfos *Inf, char const *key, int def);
+
+int          Env_New(void);
+void         Env_Delete(void);
+
+#endif
@@ -0,0 +1,4 @@
+/* Test stub of the CarMaker header (see CarMaker.h) */
+#ifndef _GLOBAL_H__
+#define _GLOBAL_H__
+#endif
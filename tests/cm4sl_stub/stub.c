@@ -0,0 +1,172 @@
+/*
+ * CarMaker functions used by the app modules under test:
+ * - data dictionary and ResultLink (KPI.c): the quantities are set from
+ *   Python (Stub_Set), the values added to the result message read back
+ *   with Stub_Result
+ * - Test Run Info File and environment (EnvKeep.c): keys set with
+ *   Stub_InfoSet (rows of a multi-line value separated by '\n'), the
+ *   Env_New/Env_Delete calls counted (Stub_Count)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "CarMaker.h"
+
+#define STUB_N 16
+
+struct tDDictEntry {
+    char   Name[64];
+    double Value;
+};
+
+static struct tDDictEntry Quant[STUB_N];
+static int nQuant;
+
+static struct {
+    char   Name[64];
+    double Value;
+} Res[STUB_N];
+static int nRes;
+
+static struct tDDictEntry *
+Find(char const *name)
+{
+    int i;
+    for (i = 0; i < nQuant; i++) {
+        if (strcmp(Quant[i].Name, name) == 0)
+            return &Quant[i];
+    }
+    return NULL;
+}
+
+void
+Stub_Set(char const *name, double value)
+{
+    struct tDDictEntry *e = Find(name);
+    if (e == NULL && nQuant < STUB_N) {
+        e = &Quant[nQuant++];
+        strncpy(e->Name, name, sizeof(e->Name) - 1);
+    }
+    if (e != NULL)
+        e->Value = value;
+}
+
+double
+Stub_Result(char const *name)
+{
+    int i;
+    for (i = nRes - 1; i >= 0; i--) {
+        if (strcmp(Res[i].Name, name) == 0)
+            return Res[i].Value;
+    }
+    return -1.0;
+}
+
+static struct {
+    char  Key[64];
+    char  Value[256];
+    char *Rows[9];      /* multi-line value, NULL terminated; Rows[0] == NULL: single line */
+} Info[STUB_N];
+static int nInfo, nEnvNew, nEnvDelete;
+
+void
+Stub_Reset(void)
+{
+    nQuant = nRes = nInfo = nEnvNew = nEnvDelete = 0;
+}
+
+void
+Stub_InfoClear(void)
+{
+    nInfo = 0;
+}
+
+void
+Stub_InfoSet(char const *key, char const *value)
+{
+    int   n = 0;
+    char *p;
+
+    if (nInfo >= STUB_N)
+        return;
+    memset(&Info[nInfo], 0, sizeof(Info[nInfo]));
+    strncpy(Info[nInfo].Key, key, sizeof(Info[nInfo].Key) - 1);
+    strncpy(Info[nInfo].Value, value, sizeof(Info[nInfo].Value) - 1);
+    if (strchr(value, '\n') != NULL) {
+        for (p = Info[nInfo].Value; p != NULL && n < 8; n++) {
+            Info[nInfo].Rows[n] = p;
+            if ((p = strchr(p, '\n')) != NULL)
+                *p++ = '\0';
+        }
+    }
+    nInfo++;
+}
+
+int
+Stub_Count(char const *name)
+{
+    return strcmp(name, "Env_New") == 0 ? nEnvNew : strcmp(name, "Env_Delete") == 0 ? nEnvDelete : -1;
+}
+
+tDDictEntry *DDictGetEntry(char const *name)       { return Find(name); }
+double DDictGetValue(tDDictEntry const *e)         { return e->Value; }
+void DDefDouble(void *o, char const *n, char const *u, double *v, int d) { }
+void LogWarnF(int ec, char const *fmt, ...)        { }
+void Log(char const *fmt, ...)                     { }
+int  Env_New(void)                                 { nEnvNew++; return 0; }
+void Env_Delete(void)                              { nEnvDelete++; }
+
+static int
+InfoFind(char const *key)
+{
+    int i;
+    for (i = 0; i < nInfo; i++) {
+        if (strcmp(Info[i].Key, key) == 0)
+            return i;
+    }
+    return -1;
+}
+
+char **
+InfoListKeys(struct tInfos *Inf, char const *prefix, int flags)
+{
+    char **keys = calloc(nInfo + 1, sizeof(char *));
+    int    i, n = 0;
+
+    for (i = 0; i < nInfo; i++) {
+        if (strncmp(Info[i].Key, prefix, strlen(prefix)) == 0)
+            keys[n++] = Info[i].Key;
+    }
+    return keys;
+}
+
+char const *
+iGetStrOpt(struct tInfos *Inf, char const *key, char const *def)
+{
+    int i = InfoFind(key);
+    return i < 0 ? def : Info[i].Rows[0] != NULL ? NULL : Info[i].Value;
+}
+
+char **
+iGetTxtOpt(struct tInfos *Inf, char const *key, char **def)
+{
+    int i = InfoFind(key);
+    return i < 0 || Info[i].Rows[0] == NULL ? def : Info[i].Rows;
+}
+
+int
+iGetIntOpt(struct tInfos *Inf, char const *key, int def)
+{
+    int i = InfoFind(key);
+    return i < 0 ? def : atoi(Info[i].Value);
+}
+
+void
+ResultLink_Add(char const *name, double value)
+{
+    if (nRes < STUB_N) {
+        strncpy(Res[nRes].Name, name, sizeof(Res[nRes].Name) - 1);
+        Res[nRes++].Value = value;
+    }
+}
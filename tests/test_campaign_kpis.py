@@ -0,0 +1,100 @@
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy as np
+
+from src.database.campaign_kpis import _load_run, batch_kpis
+from src.database.data_handler import ResultHandler
+
+
+def write_erg(path, columns):
+    """ASCII result file as ResultHandler reads it: names, units, rows."""
+    names = list(columns)
+    data = np.column_stack([columns[c] for c in names])
+    with open(path, 'w', encoding='iso-8859-1') as f:
+        f.write(" ".join(names) + "\n")
+        f.write(" ".join("-" for _ in names) + "\n")
+        for row in data:
+            f.write(" ".join(f"{v:.10g}" for v in row) + "\n")
+
+
+def synthetic_run(n, dt, shift, seed, end_speed=14.0, sideslip=True):
+    """
+    Skidpad-like run of n samples. The yaw rate is the steering angle
+    shifted by 'shift' samples: yaw[k] = g * steer[k + shift], i.e. the
+    yaw rate leads the steering for shift > 0 and lags it for shift < 0.
+    """
+    rng = np.random.default_rng(seed)
+    pad = abs(shift)
+    base = np.convolve(rng.standard_normal(n + 2 * pad + 20), np.ones(20) / 20.0, mode='valid')[:n + 2 * pad]
+    base = 0.03 * base + 0.02 * np.sin(2 * np.pi * 0.8 * dt * np.arange(n + 2 * pad))
+    t = dt * np.arange(n)
+    cols = {
+        'Time': t,
+        'Car.Steer.WhlAngle': base[pad:pad + n],
+        'Car.v': np.linspace(12.0, end_speed, n) + 0.5 * np.sin(0.3 * t),
+        'Car.YawRate': 4.0 * base[pad + shift:pad + shift + n],
+        'Car.Fr1.Ay': 7.0 + 1.5 * np.sin(1.1 * t) + 0.2 * rng.standard_normal(n),
+        'Car.Roll': 0.02 * np.sin(0.9 * t + seed),
+    }
+    if sideslip:
+        cols['Car.SideSlip'] = 0.01 * np.sin(0.7 * t) + 0.001 * rng.standard_normal(n)
+    return cols
+
+
+class BatchKpiParityTest(unittest.TestCase):
+    # (n, dt, shift, end speed, sideslip)
+    RUNS = [
+        (700, 0.01, 5, 14.0, True),
+        (1000, 0.01, -7, 14.0, True),
+        (1301, 0.01, 12, 0.5, True),   # didn't finish: cost 999
+        (1000, 0.01, 3, 14.0, False),  # same length as run 1, shared Welch group
+        (512, 0.02, 4, 14.0, True),    # other sample time
+    ]
+
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.paths = []
+        for i, (n, dt, shift, end_speed, sideslip) in enumerate(self.RUNS):
+            path = os.path.join(self.dir, f"Run_{i}.erg")
+            write_erg(path, synthetic_run(n, dt, shift, i, end_speed, sideslip))
+            self.paths.append(path)
+        self.handler = ResultHandler(os.path.join(self.dir, "parquet"))
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def test_batch_matches_process_results(self):
+        batch = batch_kpis([_load_run(p) for p in self.paths])
+        for i, path in enumerate(self.paths):
+            ref = self.handler.process_results(f"Run_{i}", path)
+            with self.subTest(run=i):
+                self.assertEqual(set(batch[i]), set(ref))
+                for key, val in ref.items():
+                    self.assertAlmostEqual(batch[i][key], val, delta=1e-6 * max(1.0, abs(val)), msg=key)
+
+    def test_lag_sign(self):
+        # np.correlate(steer, yaw) convention: a yaw rate leading the steering
+        # by k samples gives k * dt, a lagging one is clipped to 0
+        batch = batch_kpis([_load_run(p) for p in self.paths])
+        for i, (n, dt, shift, _, _) in enumerate(self.RUNS):
+            with self.subTest(run=i):
+                expected = max(0.0, shift * dt * 1000.0)
+                self.assertAlmostEqual(batch[i]['response_lag'], expected, places=6)
+                self.assertAlmostEqual(self.handler.process_results(f"Run_{i}", self.paths[i])['response_lag'],
+                                       expected, places=6)
+
+    def test_sizes_independent(self):
+        # A run's KPIs don't depend on the other runs padded into the batch
+        runs = [_load_run(p) for p in self.paths]
+        together = batch_kpis(runs)
+        for i, run in enumerate(runs):
+            alone = batch_kpis([run])[0]
+            for key, val in alone.items():
+                self.assertAlmostEqual(together[i][key], val, delta=1e-9 * max(1.0, abs(val)), msg=key)
+
+
+if __name__ == "__main__":
+    unittest.main()
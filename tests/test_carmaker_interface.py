@@ -0,0 +1,291 @@
+import contextlib
+import io
+import logging
+import os
+import shutil
+import tempfile
+import unittest
+
+from src.core.parameter_manager import CompiledTemplate
+from src.interface.carmaker_interface import CarMakerInterface
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+TESTRUN = os.path.join(ROOT, "templates", "TestRuns", "FS_SkidPad")
+VEHICLE = os.path.join(ROOT, "templates", "FSE_AllWheelDrive")
+
+
+class InterfaceTest(unittest.TestCase):
+    """Interfaces on a scratch project folder with the FS_SkidPad TestRun, no CarMaker."""
+
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.project = os.path.join(self.dir, "project")
+        os.makedirs(os.path.join(self.project, "Data", "TestRun", "Competition"))
+        shutil.copy(TESTRUN, os.path.join(self.project, "Data", "TestRun", "Competition", "FS_SkidPad"))
+        self.interfaces = []
+        # Cold start / fallback warnings are expected here
+        logger = logging.getLogger("CM_Interface")
+        self.addCleanup(logger.setLevel, logger.level)
+        logger.setLevel(logging.ERROR)
+
+    def tearDown(self):
+        for cm in self.interfaces:
+            cm.result_listener.close()
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def interface(self, **kwargs):
+        kwargs.setdefault('scratch_dir', self.dir)
+        with contextlib.redirect_stdout(io.StringIO()):
+            cm = CarMakerInterface(**kwargs)
+        cm.PROJECT_DIR = self.project
+        self.interfaces.append(cm)
+        return cm
+
+    def clone(self, cm, scratch_dir=None):
+        with contextlib.redirect_stdout(io.StringIO()):
+            other = cm.clone(scratch_dir or self.dir)
+        self.interfaces.append(other)
+        return other
+
+
+class CloneTest(InterfaceTest):
+    def configure(self, cm):
+        cm.WARM_START = True
+        cm.WARM_SETTLE_TIME = 0.8
+        cm.WARM_BASE_VEHICLE = os.path.join(self.dir, "missing") # no baseline run, trials start cold
+        cm.HOT_PARAMS = True
+        cm.KEEP_ENV = True
+        cm.WRITE_ERG = False
+        cm.RESULT_QUANTITIES = ['Car.ax']
+        cm.EXPORT_QUANTITIES = ['Car.v']
+        cm.SENSOR_RATES = {'LineSensor': 100}
+        cm.MODEL_RATES = {'OPENXWD': 200}
+        cm.TELEMETRY = "CMTelemetry"
+
+    def test_worker_runs_what_the_source_runs(self):
+        cm = self.interface()
+        self.configure(cm)
+        prune = {'TotalDist': 75.0, 'Horizon': 20}
+        worker = self.clone(cm, os.path.join(self.dir, "worker_0"))
+
+        for name in CarMakerInterface.CONFIG:
+            self.assertEqual(getattr(worker, name), getattr(cm, name), msg=name)
+        self.assertIs(worker.session_pool, cm.session_pool)
+        self.assertEqual(worker.scratch_dir, os.path.join(self.dir, "worker_0"))
+        self.assertNotEqual(worker.result_listener.port, cm.result_listener.port)
+        self.assertEqual(worker.launch_env(), cm.launch_env())
+
+        # Without the TestRun keys of the result transport (own port each) the TestRun is the same
+        self.assertEqual(worker.result_fingerprint(prune), cm.result_fingerprint(prune))
+        strip = lambda lines: [l for l in lines if not l.startswith("ResultLink.")]
+        self.assertEqual(strip(worker._trial_lines(7, prune)), strip(cm._trial_lines(7, prune)))
+        # A bare interface (the previous workers) runs something else
+        self.assertNotEqual(self.interface().result_fingerprint(prune), cm.result_fingerprint(prune))
+
+    def test_settings_copied_not_shared(self):
+        cm = self.interface()
+        worker = self.clone(cm)
+        worker.SENSOR_RATES['LineSensor'] = 50
+        self.assertEqual(cm.SENSOR_RATES, {})
+
+        # Later changes of the source reach the worker with copy_config() (Orchestrator._simulate)
+        self.configure(cm)
+        self.assertNotEqual(worker.result_fingerprint(), cm.result_fingerprint())
+        worker.copy_config(cm)
+        self.assertEqual(worker.result_fingerprint(), cm.result_fingerprint())
+
+
+class WarmBaselineTest(InterfaceTest):
+    SNAPSHOT = {"#0": ["## Snapshot 2026-10-14 12:00\n"], "SuspF.Spring": ["SuspF.Spring = 1\n"],
+                "Vhcl.State": ["Vhcl.State:\n", "\t0.1 0.2\n"]}
+
+    def setUp(self):
+        super().setUp()
+        self.runs = []
+        self.vehicle = os.path.join(self.dir, "Base_Vehicle")
+        with open(self.vehicle, 'w', encoding='utf-8') as f:
+            f.write("SuspF.Spring = 30000\nSuspR.Spring = 35000\n")
+
+    def stub(self, cm, sim_time=0.5):
+        """_take_snapshot of cm without CarMaker: the run ends at sim_time."""
+        def take_snapshot(vehicle_path, trial_id, limits, prune=None):
+            self.runs.append((vehicle_path, limits))
+            return {'status': 'Complete', 'lap_time': sim_time, 'distance': 1.0}, dict(self.SNAPSHOT)
+        cm._take_snapshot = take_snapshot
+        return cm
+
+    def warm(self, **kwargs):
+        cm = self.interface(**kwargs)
+        cm.WARM_START = True
+        cm.WARM_BASE_VEHICLE = self.vehicle
+        return cm
+
+    def test_one_baseline_of_the_base_vehicle(self):
+        cm = self.stub(self.warm())
+        workers = [self.stub(self.clone(cm)) for _ in range(3)]
+        trial = os.path.join(self.dir, "Trial_Vehicle")
+        with open(trial, 'w', encoding='utf-8') as f:
+            f.write("SuspF.Spring = 42000\nSuspR.Spring = 35000\n")
+
+        # Whichever worker asks first, the snapshot is of the base vehicle and taken once
+        fingerprint = workers[2].result_fingerprint()
+        for w in workers + [cm]:
+            base, snapshot, digest = w.warm_baseline()
+            self.assertEqual(snapshot, self.SNAPSHOT)
+            self.assertEqual(w.result_fingerprint(), fingerprint)
+        self.assertEqual(self.runs, [(self.vehicle, {"Snapshot.TimeLimit": 0.5})])
+        self.assertEqual(fingerprint['warm_start'], [0.5, digest])
+
+        with open(workers[0]._warm_vehicle(trial, 1), encoding='utf-8') as f:
+            self.assertEqual(f.read(), "## Snapshot 2026-10-14 12:00\nSuspF.Spring = 42000\n"
+                                       "Vhcl.State:\n\t0.1 0.2\n")
+
+        # Another base vehicle: taken again
+        with open(self.vehicle, 'a', encoding='utf-8') as f:
+            f.write("SuspF.Stabi = 287\n")
+        workers[1].warm_baseline()
+        self.assertEqual(len(self.runs), 2)
+
+    def test_long_baseline_run_rejected(self):
+        # The app didn't stop at Snapshot.TimeLimit: the snapshot is the car at the finish
+        cm = self.stub(self.warm(), sim_time=24.3)
+        self.assertIsNone(cm.warm_baseline())
+        self.assertEqual(cm.result_fingerprint()['warm_start'], None)
+        trial = os.path.join(self.dir, "Trial_Vehicle")
+        shutil.copy(self.vehicle, trial)
+        self.assertEqual(cm._warm_vehicle(trial, 1), trial)
+        self.assertEqual(len(self.runs), 1)
+
+
+class FakeSession:
+    """What _hot_start() uses of a pool session."""
+    def __init__(self, hot_base=None):
+        self.hot_base = hot_base
+        self.app_addr = ("127.0.0.1", 1) if hot_base is not None else None
+
+
+class HotStartTest(InterfaceTest):
+    COEFF = ["Aero.Coeff:\n", "\t0 1 2\n", "\t3 4 5\n"]
+
+    def setUp(self):
+        super().setUp()
+        self.cm = self.interface()
+        self.cm.HOT_PARAMS = True
+        self.sent = []
+        self.ack = None # None = number of keys sent
+        def send_hot_params(addr, lines, timeout=1.0):
+            self.sent.append(list(lines))
+            n = sum(1 for line in lines if line.startswith(("Vhcl ", "TestRun ")))
+            return n if self.ack is None else self.ack
+        self.cm.result_listener.send_hot_params = send_hot_params
+        self.tpl = CompiledTemplate(VEHICLE)
+
+    def vehicle(self, name, replace=None, drop=()):
+        path = os.path.join(self.dir, name)
+        CompiledTemplate.write(path, self.tpl.render(replace, drop))
+        return path
+
+    def session(self, prune):
+        """Session whose loaded TestRun is the template vehicle with these trial keys."""
+        base = self.cm._vehicle_blocks(self.vehicle("Base", {}))
+        return FakeSession((base, self.cm._line_keys(self.cm._trial_lines(3, prune))))
+
+    def test_sends_the_changed_keys(self):
+        prune = {'TotalDist': 75.0, 'BestTime': 24.1}
+        session = self.session(prune)
+        trial = self.vehicle("Trial", {"SuspF.Spring": 42000, "Aero.Coeff": self.COEFF})
+
+        self.assertTrue(self.cm._hot_start(session, trial, 4, {'TotalDist': 75.0, 'BestTime': 23.9}))
+        lines = self.sent[-1]
+        self.assertEqual([l for l in lines if l.startswith("Vhcl ")],
+                         ["Vhcl Aero.Coeff:\n", "Vhcl SuspF.Spring = 42000\n"])
+        i = lines.index("Vhcl Aero.Coeff:\n")
+        self.assertEqual(lines[i + 1:i + 3], self.COEFF[1:])
+        testrun = [l[len("TestRun "):] for l in lines if l.startswith("TestRun ")]
+        self.assertEqual(testrun, self.cm._trial_lines(4, {'TotalDist': 75.0, 'BestTime': 23.9}))
+        self.assertIn("Prune.BestTime = 23.9\n", testrun)
+        self.assertIn("ResultLink.Tag = 4\n", testrun)
+
+        # vehicle_keys go into the diff like a changed file
+        self.assertTrue(self.cm._hot_start(session, self.vehicle("Same", {}), 5, prune,
+                                           vehicle_keys={"SuspR.Stabi": ["SuspR.Stabi = 99\n"]}))
+        self.assertEqual([l for l in self.sent[-1] if l.startswith("Vhcl ")], ["Vhcl SuspR.Stabi = 99\n"])
+
+    def test_unchanged_vehicle_sends_trial_keys_only(self):
+        prune = {'TotalDist': 75.0}
+        self.assertTrue(self.cm._hot_start(self.session(prune), self.vehicle("Same", {}), 4, prune))
+        self.assertFalse([l for l in self.sent[-1] if l.startswith("Vhcl ")])
+
+    def test_cold_fallbacks(self):
+        prune = {'TotalDist': 75.0}
+        trial = self.vehicle("Trial", {"SuspF.Spring": 42000})
+        # No TestRun loaded by a cold trial yet
+        self.assertFalse(self.cm._hot_start(FakeSession(), trial, 4, prune))
+        # A key the loaded vehicle has can't be removed
+        self.assertFalse(self.cm._hot_start(self.session(prune), self.vehicle("Dropped", drop=["SuspF.Spring"]),
+                                            4, prune))
+        # Other TestRun keys than the loaded TestRun
+        self.assertFalse(self.cm._hot_start(self.session(prune), trial, 4, {**prune, 'Horizon': 20}))
+        self.assertEqual(self.sent, [])
+
+        # Not acknowledged by the app: the overlay is cleared again
+        self.ack = 1
+        self.assertFalse(self.cm._hot_start(self.session(prune), trial, 4, prune))
+        self.assertEqual(self.sent[-1], [])
+
+
+class SnapshotVehicleTest(InterfaceTest):
+    # Snapshot data set as the app exports it: comments, blocks in its own order, state keys
+    SNAPSHOT = ("## Snapshot of Base at 30.0 m\n"
+                "SuspR.Spring = 35000\n"
+                "Aero.Coeff:\n\t0 1 2\n\t3 4 5\n"
+                "SuspF.Spring = 30000\n"
+                "Vhcl.State:\n\t0.1 0.2\n\t0.3 0.4\n")
+    BASE = "SuspF.Spring = 30000\nSuspR.Spring = 35000\nAero.Coeff:\n\t0 1 2\n\t3 4 5\n"
+
+    def write(self, name, text):
+        path = os.path.join(self.dir, name)
+        with open(path, 'w', encoding='utf-8') as f:
+            f.write(text)
+        return path
+
+    def snapshot_vehicle(self, vehicle_text):
+        cm = self.interface()
+        base = cm._infofile_blocks(self.write("Base", self.BASE))
+        snapshot = cm._infofile_blocks(self.write("Snapshot.info", self.SNAPSHOT))
+        out = cm._snapshot_vehicle(base, snapshot, self.write("Trial", vehicle_text),
+                                   os.path.join(self.dir, "Out"))
+        with open(out, encoding='utf-8') as f:
+            return f.read()
+
+    def test_unchanged_vehicle_is_the_snapshot(self):
+        self.assertEqual(self.snapshot_vehicle(self.BASE), self.SNAPSHOT)
+
+    def test_changed_blocks_replaced_in_place(self):
+        # A scalar and a multi-line block with another number of rows, in the snapshot's order
+        out = self.snapshot_vehicle("SuspF.Spring = 42000\nSuspR.Spring = 35000\n"
+                                    "Aero.Coeff:\n\t9 9 9\n")
+        self.assertEqual(out, "## Snapshot of Base at 30.0 m\n"
+                              "SuspR.Spring = 35000\n"
+                              "Aero.Coeff:\n\t9 9 9\n"
+                              "SuspF.Spring = 42000\n"
+                              "Vhcl.State:\n\t0.1 0.2\n\t0.3 0.4\n")
+
+    def test_new_keys_appended(self):
+        out = self.snapshot_vehicle(self.BASE + "SuspF.Stabi = 287\n")
+        self.assertEqual(out, self.SNAPSHOT + "SuspF.Stabi = 287\n")
+
+    def test_fork_variant(self):
+        cm = self.interface()
+        fork = {'vehicle': cm._infofile_blocks(self.write("Base", self.BASE)),
+                'snapshot': cm._infofile_blocks(self.write("Snapshot.info", self.SNAPSHOT)),
+                'time': 4.2, 'distance': 30.0, 'sroad': 31.25, 'troad': -0.4, 'v': 12.5}
+        vehicle, keys = cm.fork_variant(fork, self.write("Trial", self.BASE.replace("35000", "36000")), "Fork_0")
+        self.assertEqual(keys, {"Vehicle.StartPos": "31.2500 -0.4000",
+                                "DrivMan.Man.Start.Velocity": "45.0000"})
+        with open(vehicle, encoding='utf-8') as f:
+            self.assertEqual(f.read(), self.SNAPSHOT.replace("35000", "36000"))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,89 @@
+import ctypes
+import os
+import shutil
+import subprocess
+import tempfile
+import unittest
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+APP = os.path.join(ROOT, "src_cm4sl")
+STUB = os.path.join(ROOT, "tests", "cm4sl_stub")
+CC = shutil.which("cc") or shutil.which("gcc")
+
+# Road / environment keys of a TestRun, as EnvKeep.c fingerprints them
+TESTRUN = {
+    "EnvKeep.Active": "1",
+    "Road.FName": "FS_SkidPad.rd5",
+    "Road.Link.0.Friction": "1.3",
+    "Road.Link.0.Marker": "0 0 1\n10 0 1",
+    "Env.Temperature": "20",
+    "Vehicle": "Optimized_Car_1",
+    "Prune.TotalDist": "75.0",
+}
+
+
+@unittest.skipIf(CC is None, "no C compiler")
+class EnvKeepTest(unittest.TestCase):
+    """EnvKeep.c built against stub CarMaker headers, one call per Test Run start / end."""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.dir = tempfile.mkdtemp()
+        lib = os.path.join(cls.dir, "libenvkeep.so")
+        subprocess.check_call([CC, "-shared", "-fPIC", "-I", STUB, "-I", APP,
+                               os.path.join(APP, "EnvKeep.c"), os.path.join(STUB, "stub.c"), "-o", lib])
+        cls.lib = ctypes.CDLL(lib)
+        cls.lib.Stub_InfoSet.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+        cls.lib.Stub_Count.argtypes = [ctypes.c_char_p]
+        cls.lib.EnvKeep_Env_New.argtypes = [ctypes.c_void_p]
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.dir, ignore_errors=True)
+
+    def setUp(self):
+        self.lib.Stub_Reset()
+        # Module state of the app: no environment kept from a previous test
+        self.run_testrun({"EnvKeep.Active": "0"})
+        self.lib.Stub_Reset()
+
+    def run_testrun(self, keys):
+        """Start and end of a Test Run with these keys: (Env_New calls, Env_Delete calls, kept at the end)."""
+        self.lib.Stub_InfoClear()
+        for key, value in keys.items():
+            self.lib.Stub_InfoSet(key.encode(), value.encode())
+        self.assertGreaterEqual(self.lib.EnvKeep_Env_New(None), 0)
+        kept = self.lib.EnvKeep_TestRun_End()
+        return self.lib.Stub_Count(b"Env_New"), self.lib.Stub_Count(b"Env_Delete"), kept
+
+    def test_reused_while_road_and_env_unchanged(self):
+        self.assertEqual(self.run_testrun(TESTRUN), (1, 0, 1))
+        # Other trial: vehicle and Prune keys change, the road doesn't
+        self.assertEqual(self.run_testrun({**TESTRUN, "Vehicle": "Optimized_Car_2", "Prune.TotalDist": "30"}),
+                         (1, 0, 1))
+
+    def test_changed_road_read_in_again(self):
+        self.run_testrun(TESTRUN)
+        for i, change in enumerate([{"Road.Link.0.Friction": "1.1"},
+                                    {"Road.Link.0.Marker": "0 0 1\n12 0 1"},
+                                    {"Env.Temperature": "25"},
+                                    {"Road.Link.1.Friction": "1.0"}]):
+            with self.subTest(change=change):
+                self.assertEqual(self.run_testrun({**TESTRUN, **change}), (i + 2, i + 1, 1))
+                # ... and reused from then on
+                self.assertEqual(self.run_testrun({**TESTRUN, **change}), (i + 2, i + 1, 1))
+
+    def test_inactive(self):
+        # Without EnvKeep.Active every Test Run reads the environment, App_TestRun_End deletes it
+        inactive = {**TESTRUN, "EnvKeep.Active": "0"}
+        self.assertEqual(self.run_testrun(inactive), (1, 0, 0))
+        self.assertEqual(self.run_testrun(inactive), (2, 0, 0))
+
+        # A kept environment is deleted by the first Test Run without the key
+        self.run_testrun(TESTRUN)
+        self.assertEqual(self.run_testrun(inactive), (4, 1, 0))
+        self.assertEqual(self.run_testrun(TESTRUN), (5, 1, 1))
+
+
+if __name__ == "__main__":
+    unittest.main()
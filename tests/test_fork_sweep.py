@@ -0,0 +1,76 @@
+import os
+import queue
+import shutil
+import tempfile
+import threading
+import unittest
+
+from src.core.fork_sweep import ForkSweep
+from src.core.orchestrator import Orchestrator
+from src.core.parameter_manager import ParameterManager
+
+TEMPLATE = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                        "templates", "FSE_AllWheelDrive")
+
+FORK = {'vehicle': {}, 'snapshot': {}, 'time': 4.0, 'distance': 30.0, 'sroad': 30.5, 'troad': 0.0, 'v': 11.0}
+
+
+class StubInterface:
+    """The CarMakerInterface calls of ForkSweep, without CarMaker: a variant's time is its front spring / 1e4."""
+    def __init__(self, runs, lock):
+        self.WARM_START = True
+        self.runs, self.lock = runs, lock
+
+    def fork(self, vehicle_path, fork_dist):
+        return dict(FORK, distance=fork_dist)
+
+    def fork_variant(self, fork, vehicle_path, trial_id):
+        return vehicle_path, {"Vehicle.StartPos": f"{fork['sroad']:.4f} 0.0000"}
+
+    def run_test(self, vehicle_path, output_folder, trial_id, tunables=None):
+        with self.lock:
+            self.runs.append((trial_id, self.WARM_START, dict(tunables)))
+        with open(vehicle_path, encoding='utf-8') as f:
+            spring = float(next(line for line in f if line.startswith("SuspF.Spring =")).split("=")[1])
+        if spring > 70000:
+            return {'status': 'Crash', 'lap_time': 999, 'distance': 2.0}
+        return {'status': 'Complete', 'lap_time': spring / 1e4, 'distance': 45.0,
+                'quantities': {'Time': spring / 1e4}}
+
+
+class ForkSweepTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.runs = []
+        workers = queue.Queue()
+        self.interfaces = [StubInterface(self.runs, threading.Lock()) for _ in range(2)]
+        for cm in self.interfaces:
+            workers.put(cm)
+        self.sweep = ForkSweep(workers=workers, n_workers=2, param_manager=ParameterManager(TEMPLATE),
+                               fork_dist=30.0, output_dir=self.dir)
+        self.base = {name: (lo + hi) / 2 for name, _, lo, hi in Orchestrator.DYNAMICS_SPACE}
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def test_variant_time_adds_the_trunk(self):
+        springs = [30000, 40000, 75000]
+        result = self.sweep.sweep(self.base, "Spring_F", springs)
+        # Lap = trunk time to the fork + the variant's own time; a crashed variant has none
+        self.assertEqual(result, [(30000, 4.0 + 3.0), (40000, 4.0 + 4.0), (75000, None)])
+
+        self.assertEqual(sorted(r[0] for r in self.runs), ["Fork_0", "Fork_1", "Fork_2"])
+        for _, warm, keys in self.runs:
+            # The fork's snapshot replaces the warm start, restored afterwards
+            self.assertFalse(warm)
+            self.assertEqual(keys, {"Vehicle.StartPos": "30.5000 0.0000"})
+        self.assertTrue(all(cm.WARM_START for cm in self.interfaces))
+
+    def test_gradient(self):
+        grad = self.sweep.gradient(self.base, names=["Spring_F", "Spring_R"])
+        self.assertAlmostEqual(grad["Spring_F"], 1e-4)
+        self.assertEqual(grad["Spring_R"], 0.0)
+
+
+if __name__ == "__main__":
+    unittest.main()
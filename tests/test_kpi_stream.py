@@ -0,0 +1,74 @@
+import ctypes
+import os
+import shutil
+import subprocess
+import tempfile
+import unittest
+
+from src.database.data_handler import ResultHandler
+from tests.test_campaign_kpis import synthetic_run, write_erg
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+APP = os.path.join(ROOT, "src_cm4sl")
+STUB = os.path.join(ROOT, "tests", "cm4sl_stub")
+CC = shutil.which("cc") or shutil.which("gcc")
+
+KPI_LAG_DECIM = 10 # KPI.h
+INPUTS = ['Car.Steer.WhlAngle', 'Car.v', 'Car.YawRate', 'Car.Fr1.Ay', 'Car.Roll', 'Car.SideSlip']
+
+
+@unittest.skipIf(CC is None, "no C compiler")
+class StreamedLagParityTest(unittest.TestCase):
+    """KPI.c built against stub CarMaker headers, fed the samples of a synthetic ERG."""
+    # (n, dt, shift): the yaw rate leads the steering by 'shift' samples
+    RUNS = [(700, 0.01, 5), (1000, 0.01, -7), (1301, 0.01, 12), (1000, 0.01, 0), (512, 0.02, 4)]
+
+    @classmethod
+    def setUpClass(cls):
+        cls.dir = tempfile.mkdtemp()
+        lib = os.path.join(cls.dir, "libkpi.so")
+        subprocess.check_call([CC, "-shared", "-fPIC", "-O1", "-I", STUB, "-I", APP,
+                               os.path.join(APP, "KPI.c"), os.path.join(STUB, "stub.c"), "-o", lib, "-lm"])
+        cls.kpi = ctypes.CDLL(lib)
+        cls.kpi.Stub_Set.argtypes = [ctypes.c_char_p, ctypes.c_double]
+        cls.kpi.Stub_Result.argtypes = [ctypes.c_char_p]
+        cls.kpi.Stub_Result.restype = ctypes.c_double
+        cls.kpi.KPI_Calc.argtypes = [ctypes.c_double]
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.dir, ignore_errors=True)
+
+    def stream(self, cols, dt):
+        """Runs like the app at KPI_LAG_DECIM cycles per ERG sample, returns KPI.ResponseLag."""
+        kpi = self.kpi
+        kpi.Stub_Reset()
+        for name in INPUTS:
+            kpi.Stub_Set(name.encode(), 0.0)
+        kpi.KPI_DeclQuants()
+        kpi.KPI_TestRun_Start()
+        for i in range(len(cols['Time'])):
+            for name in INPUTS:
+                kpi.Stub_Set(name.encode(), float(cols[name][i]))
+            for _ in range(KPI_LAG_DECIM):
+                kpi.KPI_Calc(dt / KPI_LAG_DECIM)
+        kpi.KPI_TestRun_End_First()
+        self.assertEqual(kpi.Stub_Result(b"KPI.Valid"), 1.0)
+        return kpi.Stub_Result(b"KPI.ResponseLag")
+
+    def test_lag_matches_process_results(self):
+        # Same sign as np.correlate(steer, yaw) in process_results(): a leading
+        # yaw rate gives shift * dt, a lagging one is clipped to 0
+        handler = ResultHandler(os.path.join(self.dir, "parquet"))
+        for i, (n, dt, shift) in enumerate(self.RUNS):
+            with self.subTest(run=i, shift=shift):
+                cols = synthetic_run(n, dt, shift, i)
+                path = os.path.join(self.dir, f"Run_{i}.erg")
+                write_erg(path, cols)
+                ref = handler.process_results(f"Run_{i}", path)['response_lag']
+                self.assertAlmostEqual(ref, max(0.0, shift * dt * 1000.0), places=6)
+                self.assertAlmostEqual(self.stream(cols, dt), ref, places=6)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,108 @@
+import os
+import shutil
+import tempfile
+import unittest
+
+from src.core.parameter_manager import CompiledTemplate, ParameterManager
+
+TEMPLATE = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                        "templates", "FSE_AllWheelDrive")
+
+
+def line_scan_inject(lines, valid_params):
+    """
+    ParameterManager.inject_parameters() before CompiledTemplate: one pass
+    over the file per line and key, reference for the rendered output.
+    """
+    new_lines = []
+    for line in lines:
+        stripped = line.strip()
+        for key, val in valid_params.items():
+            if stripped.startswith(key) and len(stripped) > len(key) and stripped[len(key)] in [' ', '=', '\t']:
+                if "Amplify" in key:
+                    new_lines.append(f"{key} = {val / 2000.0:.3f}\n")
+                else:
+                    new_lines.append(f"{key} = {val}\n")
+                break
+        else:
+            new_lines.append(line)
+    return "".join(new_lines)
+
+
+class CompiledTemplateTest(unittest.TestCase):
+    SETUPS = [
+        {},
+        {"Spring_F": 35000, "Spring_R": 45000, "Stabilizer_F": 20000, "Stabilizer_R": 15000},
+        {"Spring_F": 28123.456, "Damp_Bump_F": 2500, "Damp_Reb_F": 4000.7,
+         "Damp_Bump_R": 1234.5, "Damp_Reb_R": 7999.9, "Stabilizer_R": 171.9},
+        # Not in the vehicle file: ignored by both
+        {"Camber_F": -1.5, "Toe_R": 0.1, "Spring_R": 50000},
+    ]
+
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        with open(TEMPLATE, 'r', encoding='utf-8', errors='ignore') as f:
+            self.lines = f.readlines()
+        self.pm = ParameterManager(template_path=TEMPLATE)
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def _raw(self, params):
+        return {self.pm.PARAM_MAP[k]: v for k, v in params.items() if k in self.pm.PARAM_MAP}
+
+    def test_inject_matches_line_scan(self):
+        for i, params in enumerate(self.SETUPS):
+            with self.subTest(setup=i):
+                out = os.path.join(self.dir, f"Vehicle_{i}")
+                self.assertTrue(self.pm.inject_parameters(out, params))
+                with open(out, 'rb') as f:
+                    rendered = f.read()
+                self.assertEqual(rendered, line_scan_inject(self.lines, self._raw(params)).encode('utf-8'))
+
+    def test_render_without_changes_is_the_file(self):
+        self.assertEqual(CompiledTemplate(TEMPLATE).render(), "".join(self.lines))
+
+    def test_multiline_blocks(self):
+        tpl = CompiledTemplate(TEMPLATE)
+        for key in ("Aero.Coeff", "SuspF.Damp_Push", "SuspR.Damp_Pull"):
+            with self.subTest(key=key):
+                self.assertIn(key, tpl.index)
+                i = self.lines.index(key + ":\n")
+                j = i + 1
+                while j < len(self.lines) and self.lines[j][:1] in ('\t', ' ') and self.lines[j].strip():
+                    j += 1
+                self.assertGreater(j - i, 1)
+                self.assertEqual(tpl.block(key), self.lines[i:j])
+
+                # A list replaces the whole block, the rest of the file is unchanged
+                new_block = [f"{key}:\n", "\t0 0\n", "\t1 1\n"]
+                self.assertEqual(tpl.render({key: new_block}),
+                                 "".join(self.lines[:i] + new_block + self.lines[j:]))
+                self.assertEqual(tpl.render(drop=[key]), "".join(self.lines[:i] + self.lines[j:]))
+                # A scalar replaces it too, no continuation lines left behind
+                self.assertEqual(tpl.render({key: 1.5}),
+                                 "".join(self.lines[:i] + [f"{key} = 1.5\n"] + self.lines[j:]))
+
+        # The scalar keys next to a block aren't part of it
+        self.assertEqual(tpl.block("SuspF.Damp_Push.Amplify"), ["SuspF.Damp_Push.Amplify = 1\n"])
+
+    def test_physics_blocks(self):
+        # Aero.Coeff scaled by the calibrated base physics (SystemIdentifier) keeps its rows
+        tpl = CompiledTemplate(TEMPLATE)
+        blocks = self.pm.physics_blocks({"Aero_Drag_Scale": 1.1, "Aero_Lift_Scale": 0.9})
+        coeff = tpl.block("Aero.Coeff")
+        self.assertEqual(len(blocks["Aero.Coeff"]), len(coeff))
+        self.assertEqual(blocks["Aero.Coeff"][0], coeff[0])
+
+        out = os.path.join(self.dir, "Vehicle_physics")
+        self.pm.update_base_physics({"Aero_Drag_Scale": 1.1, "Aero_Lift_Scale": 0.9})
+        self.assertTrue(self.pm.inject_parameters(out, {"Spring_F": 30000}))
+        patched = CompiledTemplate(out)
+        self.assertEqual(patched.block("Aero.Coeff"), blocks["Aero.Coeff"])
+        self.assertEqual(patched.block("SuspF.Spring"), ["SuspF.Spring = 30000\n"])
+        self.assertEqual(len(patched.lines), len(self.lines))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,71 @@
+import os
+import shutil
+import tempfile
+import unittest
+
+from src.core.parameter_manager import ParameterManager
+from src.database.result_cache import ResultCache
+
+TEMPLATE = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                        "templates", "FSE_AllWheelDrive")
+
+BASE = {"Spring_F": 35000, "Spring_R": 45000, "Damp_Bump_F": 2500, "Damp_Reb_F": 4000,
+        "Damp_Bump_R": 2500, "Damp_Reb_R": 4000, "Stabilizer_F": 287, "Stabilizer_R": 171.9}
+TESTRUN = {'template': "tpl", 'keys': ["Prune.TotalDist = 75.0"], 'warm_start': None}
+
+
+class ResultCacheTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.pm = ParameterManager(template_path=TEMPLATE)
+        self.cache = ResultCache(os.path.join(self.dir, "result_cache.db"))
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def key(self, params, testrun=TESTRUN):
+        return ResultCache.key(self.pm.fingerprint(params), testrun)
+
+    def test_same_injected_setup_same_key(self):
+        base = self.key(BASE)
+        # Camber / toe aren't written into the vehicle file
+        self.assertEqual(self.key({**BASE, "Camber_F": -1.8, "Toe_R": 0.15}), base)
+        # Damper change below the 3 decimals of the Amplify factor
+        self.assertEqual(self.key({**BASE, "Damp_Bump_F": 2500.4, "Damp_Reb_R": 3999.2}), base)
+
+    def test_real_change_misses(self):
+        base = self.key(BASE)
+        self.assertNotEqual(self.key({**BASE, "Damp_Bump_F": 2510}), base)
+        self.assertNotEqual(self.key({**BASE, "Spring_F": 35001}), base)
+        self.assertNotEqual(self.key(BASE, {**TESTRUN, 'keys': ["Prune.TotalDist = 80.0"]}), base)
+        self.pm.update_base_physics({"Brake_Friction_Scale": 0.95})
+        self.assertNotEqual(self.key(BASE), base)
+
+    def test_hit_and_miss(self):
+        key = self.key(BASE)
+        self.assertIsNone(self.cache.get(key))
+        result = {'status': 'Complete', 'lap_time': 24.5, 'distance': 75.2, 'kpis': {'max_roll': 0.02}}
+        self.assertTrue(self.cache.put(key, result))
+
+        hit = self.cache.get(self.key({**BASE, "Camber_F": -1.8, "Damp_Bump_F": 2500.4}))
+        self.assertEqual(hit, {**result, 'cached': True})
+        self.assertIsNone(self.cache.get(self.key({**BASE, "Spring_R": 46000})))
+        self.assertEqual((self.cache.hits, self.cache.misses), (1, 2))
+
+    def test_campaign_dependent_results_not_stored(self):
+        key = self.key(BASE)
+        # Stopped against the current best lap time: depends on the campaign
+        slow = {'status': 'Stopped', 'stop_reason': 'slow', 'lap_time': 10.1, 'distance': 30.0}
+        self.assertFalse(self.cache.put(key, slow))
+        self.assertFalse(self.cache.put(key, {'status': 'Crash', 'lap_time': 999, 'distance': 0.0}))
+        self.assertIsNone(self.cache.get(key))
+
+        for reason in ResultCache.CACHED_STOPS:
+            with self.subTest(reason=reason):
+                stopped = {'status': 'Stopped', 'stop_reason': reason, 'lap_time': 8.0, 'distance': 20.0}
+                self.assertTrue(self.cache.put(key, stopped))
+                self.assertEqual(self.cache.get(key)['stop_reason'], reason)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,80 @@
+import os
+import shutil
+import stat
+import sys
+import tempfile
+import unittest
+
+from src.interface.session_pool import CarMakerSessionError, SessionPool
+
+# Stand-in for CM_Office.exe <project> -cmdport <port>: answers every Tcl
+# command with its own pid, 'Crash' ends the process
+FAKE_OFFICE = '''#!{python}
+import os, socket, sys
+srv = socket.socket()
+srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+srv.bind(("localhost", int(sys.argv[3])))
+srv.listen(1)
+con, _ = srv.accept()
+buf = b""
+while True:
+    chunk = con.recv(4096)
+    if not chunk:
+        break
+    buf += chunk
+    while b"\\r" in buf:
+        cmd, buf = buf.split(b"\\r", 1)
+        if cmd == b"Crash":
+            os._exit(1)
+        con.sendall(b"O%d\\r\\n\\r\\n" % os.getpid())
+'''
+
+
+@unittest.skipIf(os.name != "posix", "fake CM_Office is a script")
+class SessionPoolTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.office = os.path.join(self.dir, "CM_Office")
+        with open(self.office, "w", encoding="utf-8") as f:
+            f.write(FAKE_OFFICE.format(python=sys.executable))
+        os.chmod(self.office, os.stat(self.office).st_mode | stat.S_IEXEC)
+        self.pool = SessionPool(self.office, self.dir, size=1, base_port=17600 + os.getpid() % 1000)
+
+    def tearDown(self):
+        self.pool.shutdown()
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def test_session_kept_between_trials(self):
+        with self.pool.session() as s:
+            pid = s.execute("LoadTestRun Run_0")
+        with self.pool.session() as s:
+            self.assertEqual(s.execute("LoadTestRun Run_1"), pid)
+
+    def test_restart_after_crash(self):
+        with self.pool.session() as s:
+            pid = s.execute("LoadTestRun Run_0")
+            s.hot_base = {"SuspF.Spring": "50000"}
+
+        with self.assertRaises(CarMakerSessionError):
+            with self.pool.session() as s:
+                s.execute("Crash")
+
+        # Released as unhealthy: a new instance, without the old hot parameter state
+        with self.pool.session() as s:
+            self.assertNotEqual(s.execute("LoadTestRun Run_1"), pid)
+            self.assertIsNone(s.hot_base)
+            self.assertEqual(s.n_runs, 0)
+
+    def test_dead_session_restarted_on_acquire(self):
+        s = self.pool.acquire()
+        pid = s.execute("LoadTestRun Run_0")
+        s.process.kill()
+        s.process.wait()
+        self.pool.release(s)
+
+        with self.pool.session() as s:
+            self.assertNotEqual(s.execute("LoadTestRun Run_1"), pid)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,123 @@
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy as np
+from sklearn.gaussian_process import GaussianProcessRegressor
+from sklearn.gaussian_process.kernels import ConstantKernel, Matern, WhiteKernel
+
+from src.core.surrogate import IncrementalGP, SurrogateOracle
+
+
+def _data(n, d=3, seed=0):
+    rng = np.random.default_rng(seed)
+    X = rng.uniform(0.0, 1.0, (n, d))
+    y = 20.0 + np.sin(3.0 * X[:, 0]) + X[:, 1] ** 2 - 0.5 * X[:, 2] + 0.01 * rng.standard_normal(n)
+    return X, y
+
+
+def _frozen(kernel, X, y, normalize_y):
+    """sklearn reference: same hyperparameters, no optimizer."""
+    return GaussianProcessRegressor(kernel=kernel, optimizer=None, normalize_y=normalize_y).fit(X, y)
+
+
+class IncrementalGPTest(unittest.TestCase):
+    RTOL = 1e-6
+    ATOL = 1e-8
+
+    def assert_same_posterior(self, inc, ref, X_test):
+        mu, std = inc.predict(X_test, return_std=True)
+        mu_ref, std_ref = ref.predict(X_test, return_std=True)
+        np.testing.assert_allclose(mu, mu_ref, rtol=self.RTOL, atol=self.ATOL)
+        np.testing.assert_allclose(std, std_ref, rtol=self.RTOL, atol=self.ATOL)
+        np.testing.assert_allclose(inc.predict(X_test), mu_ref, rtol=self.RTOL, atol=self.ATOL)
+
+    def test_grown_matches_full_fit(self):
+        X, y = _data(40)
+        X_test, _ = _data(15, seed=1)
+        kernel = ConstantKernel(1.5) * Matern(length_scale=0.4, nu=2.5) + WhiteKernel(noise_level=1e-3)
+        for normalize_y in (False, True):
+            with self.subTest(normalize_y=normalize_y):
+                inc = IncrementalGP(alpha=1e-10, normalize_y=normalize_y)
+                inc.reset(kernel, X[:10], y[:10])
+                for x_i, y_i in zip(X[10:], y[10:]):
+                    self.assertTrue(inc.add(x_i, y_i))
+                self.assert_same_posterior(inc, _frozen(kernel, X, y, normalize_y), X_test)
+
+    def test_fitted_kernel(self):
+        # As SurrogateOracle.train() uses it: kernel_ of a fitted GP, then grown
+        X, y = _data(30, seed=2)
+        X_test, _ = _data(10, seed=3)
+        kernel = ConstantKernel(1.0) * Matern(nu=2.5) + WhiteKernel(noise_level=0.1)
+        gp = GaussianProcessRegressor(kernel=kernel, n_restarts_optimizer=0, normalize_y=True,
+                                      random_state=0).fit(X[:20], y[:20])
+
+        inc = IncrementalGP(alpha=gp.alpha, normalize_y=True)
+        inc.reset(gp.kernel_, X[:20], y[:20])
+        self.assert_same_posterior(inc, gp, X_test)
+        for x_i, y_i in zip(X[20:], y[20:]):
+            self.assertTrue(inc.add(x_i, y_i))
+        self.assert_same_posterior(inc, _frozen(gp.kernel_, X, y, True), X_test)
+
+
+class SurrogateOracleReplayTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.storage = os.path.join(self.dir, "knowledge_base.pkl")
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def _feed(self, oracle, X, y, crashes):
+        for x_i, y_i, crash in zip(X, y, crashes):
+            oracle.update({f"p{j}": float(v) for j, v in enumerate(x_i)}, float(y_i), bool(crash))
+
+    def assert_matches_frozen(self, oracle, X_test):
+        """Incremental posteriors of the oracle == sklearn fit with the oracle's frozen kernel_."""
+        X = np.array(oracle.X)
+        feas = np.array(oracle.y_feas)
+        valid = feas > 0.5
+        time_model, feas_model = oracle._models()
+        self.assertIs(time_model, oracle.inc_time)
+        self.assertIs(feas_model, oracle.inc_feas)
+
+        ref_time = _frozen(oracle.model_time.kernel_, X[valid], np.array(oracle.y_time), True)
+        ref_feas = _frozen(oracle.model_feas.kernel_, X, feas, False)
+        for inc, ref in ((oracle.inc_time, ref_time), (oracle.inc_feas, ref_feas)):
+            mu, std = inc.predict(X_test, return_std=True)
+            mu_ref, std_ref = ref.predict(X_test, return_std=True)
+            np.testing.assert_allclose(mu, mu_ref, rtol=1e-6, atol=1e-8)
+            np.testing.assert_allclose(std, std_ref, rtol=1e-6, atol=1e-8)
+
+    def test_replay_after_snapshot(self):
+        X, y = _data(30, seed=5)
+        crashes = np.arange(30) % 7 == 3
+        X_test, _ = _data(12, seed=6)
+
+        oracle = SurrogateOracle(storage_path=self.storage)
+        oracle.REFIT_EVERY = 1000 # only the first train() refits
+        oracle.COMPACT_EVERY = 12 # snapshot after 12 records, the rest stays in the log
+        self._feed(oracle, X, y, crashes)
+        self.assertTrue(os.path.exists(self.storage))
+        with open(oracle.log_path, encoding="utf-8") as f:
+            self.assertEqual(sum(1 for _ in f), 30 - 24)
+        self.assert_matches_frozen(oracle, X_test)
+
+        # Snapshot + log replay rebuilds the same observations, then refits
+        restored = SurrogateOracle(storage_path=self.storage)
+        self.assertEqual(np.array(restored.X).tolist(), np.array(oracle.X).tolist())
+        self.assertEqual(restored.y_feas, oracle.y_feas)
+        self.assertEqual(restored.y_time, oracle.y_time)
+        self.assertTrue(restored.is_trained)
+        self.assert_matches_frozen(restored, X_test)
+
+        # Grown after the replay, still the frozen-kernel posterior
+        restored.REFIT_EVERY = 1000
+        X_more, y_more = _data(6, seed=7)
+        self._feed(restored, X_more, y_more, [False] * 6)
+        self.assert_matches_frozen(restored, X_test)
+
+
+if __name__ == "__main__":
+    unittest.main()
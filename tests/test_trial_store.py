@@ -0,0 +1,90 @@
+import glob
+import os
+import shutil
+import sqlite3
+import tempfile
+import threading
+import unittest
+
+from src.database.trial_store import TrialStore
+
+
+class TrialStoreTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def rows(self):
+        con = sqlite3.connect(os.path.join(self.dir, "optimization.db"))
+        try:
+            return sorted(con.execute("SELECT study_name, number, key, value FROM trial_results"))
+        finally:
+            con.close()
+
+    def logs(self):
+        return sorted(glob.glob(os.path.join(self.dir, TrialStore.LOG_PATTERN)))
+
+    def test_append_and_close(self):
+        store = TrialStore(self.dir)
+        store.append("s", 1, {'max_roll': 0.02, 'response_lag': 40, 'flag': True, 'name': "x"})
+        store.append("s", 2, {'max_roll': 0.03})
+        store.close()
+        self.assertEqual(self.rows(), [("s", 1, "max_roll", 0.02), ("s", 1, "response_lag", 40.0),
+                                       ("s", 2, "max_roll", 0.03)])
+        self.assertEqual(self.logs(), [])
+
+        # A new writer after close(), the next log has its own file
+        store.append("s", 3, {'max_roll': 0.01})
+        store.close()
+        self.assertEqual(len(self.rows()), 4)
+
+    def test_replay_is_idempotent(self):
+        # Process died before its writer committed: the records are only in the log
+        store = TrialStore(self.dir)
+        store._writer = False # no writer thread, nothing committed
+        for n in range(5):
+            store.append("s", n, {'max_roll': 0.01 * n, 'steering_rms': 0.1})
+        store._log_file.close()
+        self.assertEqual(len(self.logs()), 1)
+        with open(self.logs()[0], "a", encoding="utf-8") as f:
+            f.write('["s", 5, "max_ro') # torn last line
+
+        expected = sorted(("s", n, k, v) for n in range(5) for k, v in (('max_roll', 0.01 * n),
+                                                                        ('steering_rms', 0.1)))
+        for _ in range(2):
+            replayed = TrialStore(self.dir)
+            self.assertEqual(replayed.n_committed, 10)
+            self.assertEqual(self.rows(), expected)
+        # The logs stay until a store is closed cleanly
+        self.assertEqual(len(self.logs()), 1)
+
+        # A later record of the same key replaces the replayed one
+        replayed.append("s", 0, {'max_roll': 0.5})
+        replayed.close()
+        self.assertEqual(self.rows()[0], ("s", 0, "max_roll", 0.5))
+        self.assertEqual(len(self.rows()), 10)
+        self.assertEqual(self.logs(), [])
+
+    def test_log_shared_by_threads(self):
+        store = TrialStore(self.dir)
+        def work(t):
+            for n in range(20):
+                store.append("s", 100 * t + n, {'max_roll': float(t)})
+        # One thread pool per optimize() call
+        for _ in range(3):
+            threads = [threading.Thread(target=work, args=(t,)) for t in range(4)]
+            for th in threads:
+                th.start()
+            for th in threads:
+                th.join()
+        self.assertEqual(len(self.logs()), 1)
+        with open(self.logs()[0], encoding="utf-8") as f:
+            self.assertEqual(sum(1 for _ in f), 3 * 4 * 20)
+        store.close()
+        self.assertEqual(len(self.rows()), 4 * 20)
+
+
+if __name__ == "__main__":
+    unittest.main()